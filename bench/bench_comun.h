@@ -0,0 +1,57 @@
+#ifndef BENCH_COMUN_H
+#define BENCH_COMUN_H
+
+#include <cstdlib>
+#include <string>
+#include <benchmark/benchmark.h>
+
+#include "nucleo/imagen.h"
+
+// Lados de las imagenes cuadradas de los benchmarks
+#define LADO_MIN 256
+#define LADO_MAX 16384
+// Las imagenes a color y los archivos ASCII de 16k x 16k no entran en la
+// memoria/disco de una maquina normal
+#ifndef LADO_MAX_COLOR
+#define LADO_MAX_COLOR 4096
+#endif
+#ifndef LADO_MAX_IO
+#define LADO_MAX_IO 4096
+#endif
+
+// Imagen sintetica en memoria (degradado con ruido), siempre la misma
+inline void llenarImagenSintetica(Imagen& imagen, const char* magic, int width, int height, int max_color = 255) {
+    int channels = (magic[1] == '3' || magic[1] == '6') ? 3 : 1;
+    imagen.setMetadata(magic, width, height, max_color, channels);
+    imagen.allocatePixels();
+
+    int* pixels = imagen.getPixelsEscritura();
+    unsigned int estado = 1;
+    long row_count = (long)width * channels;
+    for (int y = 0; y < height; y++) {
+        for (long i = 0; i < row_count; i++) {
+            estado = estado * 1103515245u + 12345u;
+            long x = i / channels;
+            long valor = (x * max_color / width + (long)y * max_color / height) / 2
+                         + (long)((estado >> 16) % 32) - 16;
+            if (valor < 0) valor = 0;
+            if (valor > max_color) valor = max_color;
+            pixels[y * row_count + i] = (int)valor;
+        }
+    }
+}
+
+// Contadores comunes: megapixeles/s y GB/s (bytes = lo que se lee y escribe)
+inline void reportarThroughput(benchmark::State& state, long pixeles, long bytes) {
+    state.counters["MP/s"] = benchmark::Counter((double)pixeles * state.iterations() / 1e6,
+                                                benchmark::Counter::kIsRate);
+    state.SetBytesProcessed((int64_t)bytes * state.iterations());
+}
+
+// Directorio para los archivos temporales de los benchmarks de I/O
+inline std::string dirTemporal() {
+    const char* dir = getenv("TMPDIR");
+    return (dir != nullptr && dir[0] != '\0') ? dir : "/tmp";
+}
+
+#endif
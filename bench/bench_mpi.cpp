@@ -0,0 +1,116 @@
+#include <cstring>
+#include <benchmark/benchmark.h>
+#include <mpi.h>
+
+#include "bench_comun.h"
+#include "nucleo/reparto_mpi.h"
+
+// Benchmarks del reparto MPI: distribucion de franjas con borde desde el
+// raiz y recoleccion de las filas interiores. Todos los ranks corren las
+// mismas iteraciones (fijas) y se reporta el tiempo del rank mas lento.
+//
+//   mpirun -np 4 ./bench_mpi --benchmark_out=mpi.json --benchmark_out_format=json
+
+#define ITERACIONES_MPI 10
+
+// Nada se imprime fuera del raiz
+class ReporterNulo : public benchmark::BenchmarkReporter {
+public:
+    bool ReportContext(const Context&) { return true; }
+    void ReportRuns(const std::vector<Run>&) {}
+};
+
+static double maximoEntreRanks(double segundos) {
+    double maximo;
+    MPI_Allreduce(&segundos, &maximo, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return maximo;
+}
+
+// Args: {lado, canales}
+static void BM_Distribuir(benchmark::State& state) {
+    int lado = (int)state.range(0);
+    int channels = (int)state.range(1);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    Imagen imagen;
+    if (rank == 0) llenarImagenSintetica(imagen, channels == 3 ? "P3" : "P2", lado, lado);
+    difundirMetadata(imagen);
+
+    for (auto _ : state) {
+        Imagen parte;
+        MPI_Barrier(MPI_COMM_WORLD);
+        double inicio = MPI_Wtime();
+        distribuirFranjas(imagen, 1, parte);
+        state.SetIterationTime(maximoEntreRanks(MPI_Wtime() - inicio));
+    }
+    long muestras = (long)lado * lado * channels;
+    reportarThroughput(state, (long)lado * lado, muestras * (long)sizeof(int));
+}
+
+// Args: {lado, canales}
+static void BM_Recolectar(benchmark::State& state) {
+    int lado = (int)state.range(0);
+    int channels = (int)state.range(1);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int start_row, end_row;
+    calcularFranja(lado, rank, size, start_row, end_row);
+    int row_size = lado * channels;
+    BufferPixeles filas((size_t)(end_row - start_row) * row_size);
+    int* datos = filas.escritura();
+    for (long i = 0; i < (long)(end_row - start_row) * row_size; i++) datos[i] = (int)(i & 0xFF);
+
+    for (auto _ : state) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        double inicio = MPI_Wtime();
+        BufferPixeles resultado = recolectarFranjas(filas.lectura(), lado, row_size);
+        state.SetIterationTime(maximoEntreRanks(MPI_Wtime() - inicio));
+        benchmark::DoNotOptimize(resultado.lectura());
+    }
+    long muestras = (long)lado * lado * channels;
+    reportarThroughput(state, (long)lado * lado, muestras * (long)sizeof(int));
+}
+
+static void registrar() {
+    benchmark::RegisterBenchmark("BM_Distribuir", BM_Distribuir)
+        ->ArgNames({"lado", "canales"})
+        ->ArgsProduct({benchmark::CreateRange(LADO_MIN, LADO_MAX, 4), {1}})
+        ->ArgsProduct({benchmark::CreateRange(LADO_MIN, LADO_MAX_COLOR, 4), {3}})
+        ->Iterations(ITERACIONES_MPI)->UseManualTime()->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("BM_Recolectar", BM_Recolectar)
+        ->ArgNames({"lado", "canales"})
+        ->ArgsProduct({benchmark::CreateRange(LADO_MIN, LADO_MAX, 4), {1}})
+        ->ArgsProduct({benchmark::CreateRange(LADO_MIN, LADO_MAX_COLOR, 4), {3}})
+        ->Iterations(ITERACIONES_MPI)->UseManualTime()->Unit(benchmark::kMillisecond);
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Solo el raiz escribe el archivo de salida; si los demas lo abrieran
+    // lo truncarian mientras el raiz escribe
+    if (rank != 0) {
+        int n = 1;
+        for (int i = 1; i < argc; i++) {
+            if (strncmp(argv[i], "--benchmark_out", 15) != 0) argv[n++] = argv[i];
+        }
+        argc = n;
+    }
+
+    registrar();
+    benchmark::Initialize(&argc, argv);
+    if (rank == 0) {
+        benchmark::RunSpecifiedBenchmarks();
+    } else {
+        ReporterNulo nulo;
+        benchmark::RunSpecifiedBenchmarks(&nulo);
+    }
+    benchmark::Shutdown();
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include <cstdio>
+#include <string>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <benchmark/benchmark.h>
+
+#include "bench_comun.h"
+#include "nucleo/afinidad.h"
+#include "nucleo/backend.h"
+
+// Micro-benchmarks del nucleo: el lazo de convolucion, cada backend sobre una
+// imagen completa, la carga/guardado de cada formato PNM y el ancho de banda
+// entre nodos NUMA.
+//
+//   ./bench_nucleo --benchmark_out=resultado.json --benchmark_out_format=json
+//   ./bench_nucleo --benchmark_filter='Filtrar/blur'
+
+static const char* nombresFiltros[] = {"blur", "laplace", "sharpen"};
+static const char* nombresBackends[] = {"serial", "pthreads", "openmp"};
+static const char* formatos[] = {"P2", "P3", "P5", "P6"};
+
+// filtrarFilas sobre la imagen completa en el hilo actual.
+// Args: {lado, canales}
+static void BM_Filtrar(benchmark::State& state, const char* nombre) {
+    int lado = (int)state.range(0);
+    int channels = (int)state.range(1);
+    Filtro filtro;
+    buscarFiltro(nombre, filtro);
+
+    Imagen imagen;
+    llenarImagenSintetica(imagen, channels == 3 ? "P3" : "P2", lado, lado);
+    BufferPixeles destino(imagen.getPixelCount());
+    Plano plano = imagen.getPlano();
+
+    for (auto _ : state) {
+        filtrarFilas(filtro, plano, destino.escritura(), 0, plano.height);
+        benchmark::DoNotOptimize(destino.lectura());
+        benchmark::ClobberMemory();
+    }
+    long muestras = imagen.getPixelCount();
+    reportarThroughput(state, (long)lado * lado, 2 * muestras * (long)sizeof(int));
+}
+
+// Backend::aplicar completo: reparto entre hilos, filtro y reemplazo del
+// buffer. Args: {lado, canales}
+static void BM_Backend(benchmark::State& state, const char* nombre) {
+    int lado = (int)state.range(0);
+    int channels = (int)state.range(1);
+    Filtro filtro;
+    buscarFiltro("blur", filtro);
+
+    Backend* backend = crearBackend(nombre, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    if (backend == nullptr) {
+        state.SkipWithError("backend no disponible");
+        return;
+    }
+
+    Imagen original;
+    llenarImagenSintetica(original, channels == 3 ? "P3" : "P2", lado, lado);
+    Imagen imagen;
+    for (auto _ : state) {
+        state.PauseTiming();
+        imagen.copiarDesde(original);
+        state.ResumeTiming();
+        backend->aplicar(imagen, filtro);
+        benchmark::DoNotOptimize(imagen.getPixels());
+    }
+    long muestras = original.getPixelCount();
+    reportarThroughput(state, (long)lado * lado, 2 * muestras * (long)sizeof(int));
+    state.counters["hilos"] = backend->getNumThreads();
+    delete backend;
+}
+
+// Bytes del archivo, para el throughput de I/O
+static long tamanoArchivo(const std::string& ruta) {
+    FILE* file = fopen(ruta.c_str(), "rb");
+    if (file == NULL) return 0;
+    fseek(file, 0, SEEK_END);
+    long bytes = ftell(file);
+    fclose(file);
+    return bytes;
+}
+
+// Args: {lado}
+static void BM_Cargar(benchmark::State& state, const char* formato) {
+    int lado = (int)state.range(0);
+    std::string ruta = dirTemporal() + "/bench_cargar_" + formato + ".pnm";
+
+    Imagen imagen;
+    llenarImagenSintetica(imagen, formato, lado, lado);
+    if (!imagen.guardarEnArchivo(ruta.c_str())) {
+        state.SkipWithError("no se pudo crear el archivo");
+        return;
+    }
+
+    for (auto _ : state) {
+        if (!imagen.cargarDesdeArchivo(ruta.c_str())) {
+            state.SkipWithError("error al cargar");
+            break;
+        }
+    }
+    reportarThroughput(state, (long)lado * lado, tamanoArchivo(ruta));
+    remove(ruta.c_str());
+}
+
+// Args: {lado}
+static void BM_Guardar(benchmark::State& state, const char* formato) {
+    int lado = (int)state.range(0);
+    std::string ruta = dirTemporal() + "/bench_guardar_" + formato + ".pnm";
+
+    Imagen imagen;
+    llenarImagenSintetica(imagen, formato, lado, lado);
+    for (auto _ : state) {
+        if (!imagen.guardarEnArchivo(ruta.c_str())) {
+            state.SkipWithError("error al guardar");
+            break;
+        }
+    }
+    reportarThroughput(state, (long)lado * lado, tamanoArchivo(ruta));
+    remove(ruta.c_str());
+}
+
+// Lectura secuencial de un buffer ubicado en un nodo desde una CPU de otro
+// (o del mismo). Args: {nodo de la CPU, nodo de la memoria}
+static void BM_AnchoBandaNUMA(benchmark::State& state) {
+    int nodo_cpu = (int)state.range(0);
+    int nodo_memoria = (int)state.range(1);
+    const size_t bytes = 256UL * 1024 * 1024;
+
+    cpu_set_t previa, mascara;
+    CPU_ZERO(&mascara);
+    pthread_getaffinity_np(pthread_self(), sizeof(previa), &previa);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &previa) && nodoDeCPU(cpu) == nodo_cpu) CPU_SET(cpu, &mascara);
+    }
+    if (CPU_COUNT(&mascara) == 0 || pthread_setaffinity_np(pthread_self(), sizeof(mascara), &mascara) != 0) {
+        state.SkipWithError("el nodo no tiene CPUs permitidas");
+        return;
+    }
+    void* memoria = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memoria == MAP_FAILED) {
+        pthread_setaffinity_np(pthread_self(), sizeof(previa), &previa);
+        state.SkipWithError("mmap fallo");
+        return;
+    }
+    // La politica se pone antes del primer toque
+    if (numNodosNUMA() > 1 && !colocarEnNodo(memoria, bytes, nodo_memoria)) {
+        state.SkipWithError("mbind fallo");
+    } else {
+        long* datos = (long*)memoria;
+        size_t count = bytes / sizeof(long);
+        for (size_t i = 0; i < count; i++) datos[i] = (long)i;
+        for (auto _ : state) {
+            long suma = 0;
+            for (size_t i = 0; i < count; i++) suma += datos[i];
+            benchmark::DoNotOptimize(suma);
+        }
+        state.SetBytesProcessed((int64_t)bytes * state.iterations());
+    }
+    munmap(memoria, bytes);
+    pthread_setaffinity_np(pthread_self(), sizeof(previa), &previa);
+}
+
+static void registrar() {
+    for (const char* nombre : nombresFiltros) {
+        std::string base = std::string("BM_Filtrar/") + nombre;
+        benchmark::RegisterBenchmark(base.c_str(), BM_Filtrar, nombre)
+            ->ArgNames({"lado", "canales"})
+            ->ArgsProduct({benchmark::CreateRange(LADO_MIN, LADO_MAX, 4), {1}})
+            ->ArgsProduct({benchmark::CreateRange(LADO_MIN, LADO_MAX_COLOR, 4), {3}})
+            ->Unit(benchmark::kMillisecond);
+    }
+    for (const char* nombre : nombresBackends) {
+        std::string base = std::string("BM_Backend/") + nombre;
+        benchmark::RegisterBenchmark(base.c_str(), BM_Backend, nombre)
+            ->ArgNames({"lado", "canales"})
+            ->ArgsProduct({benchmark::CreateRange(LADO_MIN, LADO_MAX, 4), {1}})
+            ->ArgsProduct({benchmark::CreateRange(LADO_MIN, LADO_MAX_COLOR, 4), {3}})
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+    }
+    for (const char* formato : formatos) {
+        benchmark::RegisterBenchmark((std::string("BM_Cargar/") + formato).c_str(), BM_Cargar, formato)
+            ->ArgName("lado")->RangeMultiplier(4)->Range(LADO_MIN, LADO_MAX_IO)
+            ->Unit(benchmark::kMillisecond)->UseRealTime();
+        benchmark::RegisterBenchmark((std::string("BM_Guardar/") + formato).c_str(), BM_Guardar, formato)
+            ->ArgName("lado")->RangeMultiplier(4)->Range(LADO_MIN, LADO_MAX_IO)
+            ->Unit(benchmark::kMillisecond)->UseRealTime();
+    }
+    int nodos = numNodosNUMA();
+    benchmark::internal::Benchmark* ancho_banda = benchmark::RegisterBenchmark("BM_AnchoBandaNUMA", BM_AnchoBandaNUMA)
+        ->ArgNames({"cpu", "memoria"})->Unit(benchmark::kMillisecond)->UseRealTime();
+    for (int cpu = 0; cpu < nodos; cpu++) {
+        for (int memoria = 0; memoria < nodos; memoria++) ancho_banda->Args({cpu, memoria});
+    }
+}
+
+int main(int argc, char** argv) {
+    registrar();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
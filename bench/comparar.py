@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+"""Compara dos resultados JSON de Google Benchmark (antes y despues).
+
+Uso: comparar.py base.json nuevo.json [umbral_porcentaje]
+
+Imprime la variacion de tiempo real de cada benchmark y termina con codigo 1
+si alguno empeora mas que el umbral (5% por defecto).
+"""
+import json
+import sys
+
+
+def cargar(ruta):
+    with open(ruta) as f:
+        datos = json.load(f)
+    resultados = {}
+    for b in datos["benchmarks"]:
+        # Con repeticiones solo se usa la mediana
+        if b.get("run_type") == "aggregate" and b.get("aggregate_name") != "median":
+            continue
+        nombre = b.get("run_name", b["name"])
+        resultados[nombre] = b["real_time"]
+    return resultados
+
+
+def main():
+    if len(sys.argv) not in (3, 4):
+        print(__doc__)
+        return 2
+    base = cargar(sys.argv[1])
+    nuevo = cargar(sys.argv[2])
+    umbral = float(sys.argv[3]) if len(sys.argv) == 4 else 5.0
+
+    regresiones = 0
+    for nombre in sorted(base):
+        if nombre not in nuevo:
+            continue
+        cambio = (nuevo[nombre] - base[nombre]) / base[nombre] * 100.0
+        marca = ""
+        if cambio > umbral:
+            marca = "  <-- REGRESION"
+            regresiones += 1
+        print("%-50s %12.3f %12.3f %+8.1f%%%s" % (nombre, base[nombre], nuevo[nombre], cambio, marca))
+
+    print("%d regresiones (umbral %.1f%%)" % (regresiones, umbral))
+    return 1 if regresiones else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
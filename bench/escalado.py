@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""Escalado fuerte y debil de los backends de filtro.
+
+Genera imagenes sinteticas con generar_imagen, corre `filtro` con cada
+backend barriendo hilos y procesos MPI, y para cada corrida informa el tiempo
+de cada fase, el speedup y la eficiencia contra `filtro --backend serial`.
+Ademas verifica que la salida de cada backend sea identica byte a byte a la
+del serial.
+
+Uso:
+  bench/escalado.py --build build/release --tamanos 2048x2048,4096x4096 \\
+                    --hilos 1,2,4,8 --procesos 1,2,4 --salida escalado.json
+
+Escalado fuerte: la imagen queda fija y crece el numero de trabajadores.
+Escalado debil: el alto de la imagen crece con el numero de trabajadores
+(trabajo constante por trabajador).
+"""
+import argparse
+import filecmp
+import json
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+
+PATRON_TIEMPOS = re.compile(r"Tiempos \(s\): carga=(\S+) filtro=(\S+) guardado=(\S+) total=(\S+)")
+FASES = ("carga", "filtro", "guardado", "total")
+
+
+def correr(comando):
+    r = subprocess.run(comando, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if r.returncode != 0:
+        sys.exit("Fallo: %s\n%s" % (" ".join(comando), r.stdout))
+    return r.stdout
+
+
+def tiempos(salida):
+    m = PATRON_TIEMPOS.search(salida)
+    if m is None:
+        sys.exit("No se encontraron los tiempos en la salida:\n" + salida)
+    return dict(zip(FASES, (float(v) for v in m.groups())))
+
+
+def mejorDe(comando, repeticiones):
+    """Menor tiempo total de varias corridas (menos ruido del sistema)."""
+    mejor = None
+    for _ in range(repeticiones):
+        t = tiempos(correr(comando))
+        if mejor is None or t["total"] < mejor["total"]:
+            mejor = t
+    return mejor
+
+
+def generar(args, dir_trabajo, ancho, alto, formato):
+    ruta = os.path.join(dir_trabajo, "entrada_%dx%d.%s" % (ancho, alto, "ppm" if formato in ("P3", "P6") else "pgm"))
+    if not os.path.exists(ruta):
+        correr([os.path.join(args.build, "generar_imagen"), ruta, str(ancho), str(alto), formato])
+    return ruta
+
+
+def configuraciones(args):
+    """(backend, procesos, hilos) a medir, sin el serial."""
+    confs = []
+    for h in args.hilos:
+        for b in ("pthreads", "openmp"):
+            if b in args.backends:
+                confs.append((b, 1, h))
+    if "mpi" in args.backends:
+        for p in args.procesos:
+            confs.append(("mpi", p, 1))
+        if args.hibrido:
+            for p in args.procesos:
+                for h in args.hilos:
+                    if h > 1:
+                        confs.append(("mpi", p, h))
+    return confs
+
+
+def comandoFiltro(args, backend, procesos, hilos, entrada, salida):
+    filtro = [os.path.join(args.build, "filtro"), "--tiempos", "--backend", backend,
+              "--threads", str(hilos), entrada, salida, args.filtro]
+    if backend == "mpi":
+        return shlex.split(args.mpirun) + ["-np", str(procesos)] + filtro
+    return filtro
+
+
+def medir(args, dir_trabajo, modo, ancho, alto_base, formato):
+    resultados = []
+    seriales = {}
+
+    def serial(entrada):
+        # Referencia serial de cada entrada, una sola vez
+        if entrada not in seriales:
+            referencia = entrada + ".serial"
+            seriales[entrada] = mejorDe(comandoFiltro(args, "serial", 1, 1, entrada, referencia), args.repeticiones)
+        return seriales[entrada], entrada + ".serial"
+
+    base = generar(args, dir_trabajo, ancho, alto_base, formato)
+    t_base, _ = serial(base)
+
+    for backend, procesos, hilos in configuraciones(args):
+        trabajadores = procesos * hilos
+        alto = alto_base * trabajadores if modo == "debil" else alto_base
+        entrada = generar(args, dir_trabajo, ancho, alto, formato)
+        t_serial, referencia = serial(entrada)
+
+        salida = entrada + "." + backend
+        t = mejorDe(comandoFiltro(args, backend, procesos, hilos, entrada, salida), args.repeticiones)
+        identica = filecmp.cmp(referencia, salida, shallow=False)
+        os.remove(salida)
+
+        # Fuerte: S = T1(n) / Tp(n), E = S / p
+        # Debil: E = T1(n) / Tp(p * n) con el serial de la imagen base, S = p * E
+        r = {
+            "modo": modo, "formato": formato, "ancho": ancho, "alto": alto,
+            "backend": backend, "procesos": procesos, "hilos": hilos,
+            "tiempos": t, "tiempos_serial": t_serial, "identica": identica,
+        }
+        for sufijo, fase in (("", "total"), ("_filtro", "filtro")):
+            if t[fase] <= 0:
+                r["speedup" + sufijo] = r["eficiencia" + sufijo] = 0.0
+            elif modo == "debil":
+                r["eficiencia" + sufijo] = t_base[fase] / t[fase]
+                r["speedup" + sufijo] = trabajadores * r["eficiencia" + sufijo]
+            else:
+                r["speedup" + sufijo] = t_serial[fase] / t[fase]
+                r["eficiencia" + sufijo] = r["speedup" + sufijo] / trabajadores
+        resultados.append(r)
+
+        print("%-6s %s %5dx%-6d %-8s p=%-2d h=%-2d total=%8.4f filtro=%8.4f speedup=%5.2f ef=%5.2f %s" % (
+            modo, formato, ancho, alto, backend, procesos, hilos, t["total"], t["filtro"],
+            r["speedup"], r["eficiencia"], "ok" if identica else "DIFERENTE"))
+    return resultados
+
+
+def listaEnteros(texto):
+    return [int(v) for v in texto.split(",") if v]
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("--build", default="build/release", help="directorio con filtro y generar_imagen")
+    p.add_argument("--tamanos", default="2048x2048", help="ANCHOxALTO separados por coma")
+    p.add_argument("--formatos", default="P2", help="P2,P3,P5,P6")
+    p.add_argument("--filtro", default="blur")
+    p.add_argument("--backends", default="pthreads,openmp,mpi")
+    p.add_argument("--hilos", type=listaEnteros, default=[1, 2, 4])
+    p.add_argument("--procesos", type=listaEnteros, default=[1, 2, 4])
+    p.add_argument("--hibrido", action="store_true", help="medir tambien MPI con varios hilos por proceso")
+    p.add_argument("--modo", choices=("fuerte", "debil", "ambos"), default="ambos")
+    p.add_argument("--repeticiones", type=int, default=3)
+    p.add_argument("--mpirun", default="mpirun --oversubscribe")
+    p.add_argument("--salida", help="archivo JSON con todos los resultados")
+    p.add_argument("--dir-trabajo", help="donde generar las imagenes (por defecto un temporal)")
+    args = p.parse_args()
+    args.backends = args.backends.split(",")
+
+    modos = ("fuerte", "debil") if args.modo == "ambos" else (args.modo,)
+    dir_trabajo = args.dir_trabajo or tempfile.mkdtemp(prefix="escalado_")
+    os.makedirs(dir_trabajo, exist_ok=True)
+
+    resultados = []
+    for modo in modos:
+        for tamano in args.tamanos.split(","):
+            ancho, alto = (int(v) for v in tamano.split("x"))
+            for formato in args.formatos.split(","):
+                resultados.extend(medir(args, dir_trabajo, modo, ancho, alto, formato))
+
+    if args.salida:
+        with open(args.salida, "w") as f:
+            json.dump({"filtro": args.filtro, "resultados": resultados}, f, indent=2)
+
+    diferentes = [r for r in resultados if not r["identica"]]
+    if diferentes:
+        print("%d corridas con salida distinta a la serial" % len(diferentes))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,53 @@
+# Target entrenar_pgo: genera imagenes de muestra y corre todos los programas
+# sobre ellas para producir los perfiles de PGO.
+
+set(PGO_DIR ${CMAKE_BINARY_DIR}/pgo_muestras)
+set(PGO_SALIDA ${PGO_DIR}/salida)
+set(PGO_FILTROS blur laplace sharpen)
+
+set(PGO_COMANDOS
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${PGO_DIR} ${PGO_SALIDA}
+    COMMAND generar_imagen ${PGO_DIR}/muestra.pgm 1024 768 P2
+    COMMAND generar_imagen ${PGO_DIR}/muestra.ppm 1024 768 P3
+    COMMAND generar_imagen ${PGO_DIR}/muestra_bin.ppm 2048 1536 P6
+    COMMAND generar_imagen ${PGO_DIR}/muestra_16.pgm 1024 768 P5 4095
+)
+
+set(PGO_BACKENDS serial pthreads)
+if(FILTRO_CON_OPENMP)
+    list(APPEND PGO_BACKENDS openmp)
+endif()
+
+foreach(muestra muestra.pgm muestra.ppm muestra_bin.ppm muestra_16.pgm)
+    foreach(filtro ${PGO_FILTROS})
+        foreach(backend ${PGO_BACKENDS})
+            list(APPEND PGO_COMANDOS COMMAND filtro --backend ${backend} --threads 4
+                 ${PGO_DIR}/${muestra} ${PGO_SALIDA}/${backend}_${filtro}_${muestra} ${filtro})
+        endforeach()
+        list(APPEND PGO_COMANDOS
+             COMMAND filtro_streaming ${PGO_DIR}/${muestra} ${PGO_SALIDA}/st_${filtro}_${muestra} ${filtro}
+             COMMAND filtro_pipeline ${PGO_DIR}/${muestra} ${PGO_SALIDA}/pip_${filtro}_${muestra} ${filtro} 4)
+    endforeach()
+endforeach()
+
+list(APPEND PGO_COMANDOS
+     COMMAND filtro ${PGO_DIR}/muestra.ppm ${PGO_SALIDA}/cadena.ppm blur,sharpen,laplace
+     COMMAND filtro_lote ${PGO_DIR} ${PGO_SALIDA} sharpen 4
+     COMMAND filtros_pthreads ${PGO_DIR}/muestra.ppm ${PGO_SALIDA}/pth.ppm blur
+     COMMAND base ${PGO_DIR}/muestra.ppm ${PGO_SALIDA}/base.ppm)
+
+# Con un solo slot, mpirun se niega a lanzar 2 procesos sin --oversubscribe
+if(FILTRO_CON_MPI AND MPIEXEC_MAX_NUMPROCS LESS 2)
+    message(STATUS "entrenar_pgo: MPI training skipped (MPIEXEC_MAX_NUMPROCS < 2)")
+elseif(FILTRO_CON_MPI)
+    list(APPEND PGO_COMANDOS
+         COMMAND ${MPIEXEC_EXECUTABLE} ${MPIEXEC_NUMPROC_FLAG} 2 ${MPIEXEC_PREFLAGS}
+                 $<TARGET_FILE:filtro_openmpi> ${MPIEXEC_POSTFLAGS}
+                 ${PGO_DIR}/muestra.ppm ${PGO_SALIDA}/mpi.ppm blur)
+endif()
+
+add_custom_target(entrenar_pgo
+    ${PGO_COMANDOS}
+    WORKING_DIRECTORY ${CMAKE_BINARY_DIR}
+    COMMENT "Entrenando PGO con imagenes de muestra"
+    VERBATIM)
@@ -2,219 +2,299 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <time.h>
 
-#define MAX_FILENAME 256
-#define BUFFER_SIZE 1024
-#define MAX_MAGIC 3
-
-int blurKernel[3][3] = {
-    {1, 1, 1},
-    {1, 1, 1},
-    {1, 1, 1}
-};
-int blurDiv = 9;
-
-int laplaceKernel[3][3] = {
-    { 0, -1,  0},
-    {-1,  4, -1},
-    { 0, -1,  0}
-};
-int laplaceDiv = 1;
-
-int sharpenKernel[3][3] = {
-    { 0, -1,  0},
-    {-1,  5, -1},
-    { 0, -1,  0}
-};
-int sharpenDiv = 1;
-
-class Imagen {
-private:
-    char magic[MAX_MAGIC];
-    int width;
-    int height;
-    int max_color;
-    int* pixels;
-    int pixel_count;
-    int channels;
-
-public:
-
-    Imagen() : width(0), height(0), max_color(0), pixels(nullptr), pixel_count(0), channels(1) {
-        magic[0] = '\0';
-    }
-    
-    ~Imagen() {
-        liberarMemoria();
-    }
-    
-    void liberarMemoria() {
-        if (pixels != nullptr) {
-            delete[] pixels;
-            pixels = nullptr;
-        }
-        pixel_count = 0;
-    }
-    
-    bool cargarDesdeArchivo(const char* filename) {
-        liberarMemoria();
-        
-        FILE *file = fopen(filename, "r");
-        if (file == NULL) {
-            std::cout << "Error, incorrect path or incorrect file." << std::endl;
-            return false;
-        }
+#include "nucleo/afinidad.h"
+#include "nucleo/autoajuste.h"
+#include "nucleo/backend.h"
+#include "nucleo/cache_resultados.h"
+#include "nucleo/estadisticas.h"
+#include "nucleo/region.h"
 
-        char magic_buffer[MAX_MAGIC];
-        fscanf(file, "%2s", magic_buffer);
-        strncpy(magic, magic_buffer, MAX_MAGIC);
-        
-        fscanf(file, "%d %d", &width, &height);
-        fscanf(file, "%d", &max_color);
-
-        channels = 1;
-        pixel_count = width * height;
-        if (strcmp(magic, "P3") == 0) { 
-            channels = 3;
-            pixel_count = width * height * channels;
-        }
+void mostrarUso(const char* programa) {
+    std::cout << "Uso: " << programa << " [--backend <nombre>] [--threads <n>] [--iterations <n>] [--tiempos]"
+              << " [--roi x,y,w,h [--componer]] [--cache <dir> [--cache-max <MB>] [--cache-stats]]"
+              << " [--fijar-hilos] [--numa local|intercalar|<nodo>] [--autotune] [--perfil <archivo>]"
+              << " [--estadisticas] <input_file> <output_file> <filter[,filter...]>" << std::endl;
+    std::cout << "Filtros: " << listaFiltros() << std::endl;
+    std::cout << "  median, min y max aceptan un lado de ventana impar: median5, min7, max255" << std::endl;
+    std::cout << "Backends: " << backendsDisponibles() << std::endl;
+    std::cout << "  --roi filtra solo esa region y escribe el recorte; con --componer escribe la"
+              << " imagen completa con la region filtrada. La entrada puede ser PNM o teselado (.pnmt)" << std::endl;
+    std::cout << "  --cache guarda los resultados por contenido de la entrada y filtros; un acierto"
+              << " enlaza la salida sin filtrar (limite por defecto 1024 MB)" << std::endl;
+    std::cout << "  --fijar-hilos fija cada hilo a una CPU; --numa ubica cada franja en el nodo de su"
+              << " hilo (local, implica --fijar-hilos), intercala las paginas o las fija a un nodo" << std::endl;
+    std::cout << "  --autotune mide backends, hilos y teselas sobre una muestra de la entrada y guarda la"
+              << " mejor en el perfil del host; sin --backend ni --threads se usa el perfil" << std::endl;
+    std::cout << "  Perfil por defecto: " << rutaPerfilPorDefecto() << std::endl;
+    std::cout << "  --estadisticas escribe <output_file>.estadisticas.json con histograma, minimo, maximo,"
+              << " media y recortes por canal, calculados al filtrar (no con --roi ni --cache)" << std::endl;
+}
 
-        pixels = new int[pixel_count];
+double segundosDesde(const struct timespec& inicio) {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (ahora.tv_sec - inicio.tv_sec) + (ahora.tv_nsec - inicio.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    std::string backend_nombre = "serial";
+    int num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    bool backend_explicito = false;
+    bool threads_explicito = false;
+    bool autotune = false;
+    std::string ruta_perfil = rutaPerfilPorDefecto();
+    const char* posicionales[3];
+    int num_posicionales = 0;
+    int iteraciones = 1;
+    bool tiempos = false;
+    Region roi;
+    bool con_roi = false;
+    bool componer = false;
+    const char* dir_cache = nullptr;
+    uint64_t max_cache = CACHE_MAX_BYTES_POR_DEFECTO;
+    bool estadisticas_cache = false;
+    bool con_estadisticas = false;
+    ConfigAfinidad afinidad = {false, MEMORIA_SISTEMA, 0, 1};
 
-        int value;
-        for (int i = 0; i < pixel_count; i++) {
-            if (fscanf(file, "%d", &value) != 1) {
-                std::cout << "Error reading pixels." << std::endl;
-                liberarMemoria();
-                fclose(file);
-                return false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+            backend_nombre = argv[++i];
+            backend_explicito = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+            threads_explicito = true;
+        } else if (strcmp(argv[i], "--autotune") == 0) {
+            autotune = true;
+        } else if (strcmp(argv[i], "--perfil") == 0 && i + 1 < argc) {
+            ruta_perfil = argv[++i];
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iteraciones = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tiempos") == 0) {
+            tiempos = true;
+        } else if (strcmp(argv[i], "--roi") == 0 && i + 1 < argc) {
+            con_roi = parsearRegion(argv[++i], roi);
+            if (!con_roi) {
+                std::cout << "Invalid region: " << argv[i] << std::endl;
+                return 1;
             }
-            pixels[i] = value;
-        }
-        
-        fclose(file);
-        return true;
-    }
-    
-    bool guardarEnArchivo(const char* filename) {
-        FILE *output = fopen(filename, "w");
-        if (output == NULL) {
-            std::cout << "Error creating output file." << std::endl;
-            return false;
+        } else if (strcmp(argv[i], "--componer") == 0) {
+            componer = true;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            dir_cache = argv[++i];
+        } else if (strcmp(argv[i], "--cache-max") == 0 && i + 1 < argc) {
+            max_cache = strtoull(argv[++i], NULL, 10) * 1024 * 1024;
+        } else if (strcmp(argv[i], "--cache-stats") == 0) {
+            estadisticas_cache = true;
+        } else if (strcmp(argv[i], "--estadisticas") == 0) {
+            con_estadisticas = true;
+        } else if (strcmp(argv[i], "--fijar-hilos") == 0) {
+            afinidad.fijar_hilos = true;
+        } else if (strcmp(argv[i], "--numa") == 0 && i + 1 < argc) {
+            if (!parsearPoliticaMemoria(argv[++i], afinidad)) {
+                std::cout << "Invalid NUMA policy: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            mostrarUso(argv[0]);
+            return 1;
+        } else if (num_posicionales < 3) {
+            posicionales[num_posicionales++] = argv[i];
+        } else {
+            mostrarUso(argv[0]);
+            return 1;
         }
+    }
 
-        fprintf(output, "%s\n%d %d\n%d\n", magic, width, height, max_color);
+    if (num_posicionales != 3 || iteraciones < 1 || (componer && !con_roi) ||
+        (estadisticas_cache && dir_cache == nullptr) || (con_estadisticas && (con_roi || dir_cache != nullptr))) {
+        mostrarUso(argv[0]);
+        return 1;
+    }
 
-        for (int i = 0; i < pixel_count; i++) {
-            fprintf(output, "%d\n", pixels[i]);
-        }
+    std::vector<Filtro> filtros;
+    bool ok = parsearCadenaFiltros(posicionales[2], filtros);
+
+    // La cadena completa se repite `iteraciones` veces; los backends agrupan
+    // los pasos para recorrer la imagen una vez por grupo
+    std::vector<Filtro> pasos;
+    for (int it = 0; ok && it < iteraciones; it++) {
+        pasos.insert(pasos.end(), filtros.begin(), filtros.end());
+    }
 
-        fclose(output);
-        return true;
-    }
-    
-    
-    const char* getTipo() const {
-        if (strcmp(magic, "P2") == 0) return "PGM";
-        if (strcmp(magic, "P3") == 0) return "PPM";;
-    }
-    
-    
-
-    void copiarDesde(const Imagen& otra) {
-        liberarMemoria();
-        
-        strncpy(magic, otra.magic, MAX_MAGIC);
-        width = otra.width;
-        height = otra.height;
-        max_color = otra.max_color;
-        pixel_count = otra.pixel_count;
-        channels = otra.channels;
-        
-        if (pixel_count > 0) {
-            pixels = new int[pixel_count];
-            for (int i = 0; i < pixel_count; i++) {
-                pixels[i] = otra.pixels[i];
+    // Perfil del host: con --autotune se mide y se guarda; si no, se carga.
+    // Lo que se paso en la linea de comandos gana sobre el perfil.
+    if (ok && autotune) {
+        if (backend_nombre == "mpi") {
+            std::cout << "--autotune does not support the mpi backend" << std::endl;
+            return 1;
+        }
+        // La clase de imagen del perfil sale del encabezado de la entrada
+        // completa, no de la muestra
+        LectorRegiones lector;
+        Imagen muestra;
+        ConfigAutoajuste mejor;
+        if (!lector.abrir(posicionales[0]) || !leerMuestra(posicionales[0], muestra)) return 1;
+        const EncabezadoPNM& enc = lector.getEncabezado();
+        std::cout << "Autotune sobre " << muestra.getWidth() << "x" << muestra.getHeight() << ":" << std::endl;
+        if (autoajustar(muestra, pasos, num_threads, mejor, true)) {
+            PerfilHost perfil;
+            perfil.cargar(ruta_perfil);
+            perfil.poner(claseImagen(enc.width, enc.height, enc.channels), mejor);
+            if (perfil.guardar(ruta_perfil)) {
+                std::cout << "Mejor: " << mejor.backend << " hilos=" << mejor.num_threads
+                          << " pasos_por_bloque=" << mejor.filtros.pasos_por_bloque << " tesela="
+                          << mejor.filtros.tesela_ancho << "x" << mejor.filtros.tesela_alto
+                          << ", guardado en " << ruta_perfil << std::endl;
             }
+            bool mismo_backend = !backend_explicito || backend_nombre == mejor.backend;
+            if (!backend_explicito) backend_nombre = mejor.backend;
+            if (!threads_explicito && mismo_backend) num_threads = mejor.num_threads;
         }
-    }
-    
-   
-    Imagen copiar() const {
-        Imagen nueva;
-        nueva.copiarDesde(*this);
-        return nueva;
-    }
-    
-
-    int aplicarKernel(int x, int y, int kernel[3][3], int divisor, int channel) const {
-        int sum = 0;
-        for (int ky = -1; ky <= 1; ky++) {
-            for (int kx = -1; kx <= 1; kx++) {
-                int nx = x + kx;
-                int ny = y + ky;
-                if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
-                    int idx = (ny * width + nx) * channels + channel;
-                    sum += pixels[idx] * kernel[ky + 1][kx + 1];
-                }
+    } else if (ok) {
+        PerfilHost perfil;
+        LectorRegiones lector;
+        ConfigAutoajuste config;
+        if (perfil.cargar(ruta_perfil) && !perfil.vacio() && lector.abrir(posicionales[0])) {
+            const EncabezadoPNM& enc = lector.getEncabezado();
+            if (perfil.buscar(claseImagen(enc.width, enc.height, enc.channels), config)) {
+                configurarAjusteFiltros(config.filtros);
+                bool mismo_backend = !backend_explicito || backend_nombre == config.backend;
+                if (!backend_explicito) backend_nombre = config.backend;
+                if (!threads_explicito && mismo_backend) num_threads = config.num_threads;
             }
         }
-        sum /= divisor;
-        if (sum < 0) sum = 0;
-        if (sum > max_color) sum = max_color;
-        return sum;
     }
-    
 
+    // Sin --threads, el backend mpi reparte los nucleos del nodo entre los
+    // ranks que lo comparten en lugar de darle todos a cada uno
+    if (backend_nombre == "mpi" && !threads_explicito) num_threads = 0;
 
-    void aplicar(int n) {
-        int* nuevos_pixels = new int[pixel_count];
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                for (int c = 0; c < channels; c++) {
-                    int index = (y * width + x) * channels + c;
+    Backend* backend = crearBackend(backend_nombre.c_str(), num_threads);
+    if (backend == nullptr) {
+        std::cout << "Unknown backend: " << backend_nombre << std::endl;
+        std::cout << "Backends: " << backendsDisponibles() << std::endl;
+        return 1;
+    }
+    if (!backend->inicializar(&argc, &argv)) {
+        delete backend;
+        return 1;
+    }
+    if (num_threads < 1) num_threads = backend->getNumThreads();
 
-                    if (n == 1){
-                    nuevos_pixels[index] = aplicarKernel(x, y, blurKernel, blurDiv, c);
-                    }
-                    else if (n == 2){
-                    nuevos_pixels[index] = aplicarKernel(x, y, laplaceKernel, laplaceDiv, c);
-                    }
+    // La carga y el guardado ASCII usan los mismos hilos que el filtro
+    configurarHilosPNM(num_threads);
+    // Los buffers se reparten en las mismas franjas que los hilos del backend
+    afinidad.num_threads = num_threads;
+    if (afinidad.politica == MEMORIA_LOCAL) afinidad.fijar_hilos = true;
+
+    // Los avisos de NUMA, como los demas, solo desde el raiz
+    if (afinidad.politica == MEMORIA_NODO && afinidad.nodo >= numNodosNUMA()) {
+        if (backend->esRaiz()) std::cout << "NUMA node out of range: " << afinidad.nodo << std::endl;
+        backend->finalizar();
+        delete backend;
+        return 1;
+    }
+    if (afinidad.politica != MEMORIA_SISTEMA && !numaDisponible() && backend->esRaiz()) {
+        std::cout << "NUMA placement not available, only pinning threads" << std::endl;
+    }
+    configurarAfinidad(afinidad);
 
-                    else if (n == 3){
-                    nuevos_pixels[index] = aplicarKernel(x, y, sharpenKernel, sharpenDiv, c);
-                    }
+    // Tiempo de pared de cada fase, medido en el raiz
+    struct timespec inicio, fase;
+    double t_carga = 0, t_filtro = 0, t_guardado = 0;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
 
-                }
-            }
+    // Con cache, el raiz busca el resultado antes de cargar nada. La clave
+    // incluye todo lo que cambia la salida, no el backend ni los hilos.
+    CacheResultados* cache = nullptr;
+    uint64_t clave = 0;
+    bool con_clave = false;
+    bool acierto = false;
+    if (ok && backend->esRaiz() && dir_cache != nullptr) {
+        cache = new CacheResultados(dir_cache, max_cache);
+        std::string especificacion = especificacionFiltros(pasos);
+        if (con_roi) {
+            especificacion += "|roi " + std::to_string(roi.x) + "," + std::to_string(roi.y) + "," +
+                              std::to_string(roi.width) + "," + std::to_string(roi.height) +
+                              (componer ? " componer" : "");
         }
-        
-        delete[] pixels;
-        pixels = nuevos_pixels;
+        con_clave = cache->calcularClave(posicionales[0], especificacion, clave);
+        acierto = con_clave && cache->servir(clave, posicionales[1]);
     }
-   
-};
+    // Todos los ranks siguen solo si el raiz no acerto
+    bool filtrar = backend->consenso(!acierto);
 
-int main(int argc, char* argv[]) {
+    // Con region solo se leen sus filas y columnas mas un borde igual a la
+    // suma de los radios: fuera de ese borde el resultado dentro de la region
+    // no cambia
     Imagen imagen;
-    if (!imagen.cargarDesdeArchivo(argv[1])) {
-        return 1;
+    Region leida = {0, 0, 0, 0};
+    if (ok && filtrar && backend->esRaiz() && con_roi) {
+        LectorRegiones lector;
+        ok = lector.abrir(posicionales[0]);
+        const EncabezadoPNM& enc = lector.getEncabezado();
+        if (ok && ((long)roi.x + roi.width > enc.width || (long)roi.y + roi.height > enc.height)) {
+            std::cout << "Region out of image bounds." << std::endl;
+            ok = false;
+        }
+        long borde = 0;
+        for (size_t i = 0; i < pasos.size(); i++) borde += pasos[i].radio;
+        if (borde > enc.width + enc.height) borde = enc.width + enc.height;
+        leida = expandirRegion(roi, (int)borde, enc.width, enc.height);
+        if (ok) ok = lector.leer(leida, imagen);
+    } else if (ok && filtrar && backend->esRaiz()) {
+        ok = imagen.cargarDesdeArchivo(posicionales[0]);
+    }
+    ok = backend->consenso(ok);
+    t_carga = segundosDesde(inicio);
+
+    clock_gettime(CLOCK_MONOTONIC, &fase);
+    // Las estadisticas salen de la pasada final; solo falta juntarlas
+    EstadisticasImagen estadisticas;
+    if (ok && filtrar) {
+        ok = backend->aplicarPasos(imagen, pasos, con_estadisticas ? &estadisticas : nullptr);
     }
-    const char* filtro = argv[3];
-    
-    if (strcmp(filtro, "blur") == 0) {
-        imagen.aplicar(1);
+    if (con_estadisticas && filtrar) {
+        backend->reducirEstadisticas(estadisticas);
     }
-    else if (strcmp(filtro, "laplace") == 0) {
-        imagen.aplicar(2);
+    t_filtro = segundosDesde(fase);
+
+    clock_gettime(CLOCK_MONOTONIC, &fase);
+    if (ok && filtrar && backend->esRaiz() && con_roi) {
+        Region interior = {roi.x - leida.x, roi.y - leida.y, roi.width, roi.height};
+        Imagen recorte;
+        recortarRegion(imagen, interior, recorte);
+        ok = componer ? componerRegion(posicionales[0], posicionales[1], roi, recorte)
+                      : recorte.guardarEnArchivo(posicionales[1]);
+    } else if (ok && filtrar && backend->esRaiz()) {
+        ok = imagen.guardarEnArchivo(posicionales[1]);
     }
-    else if (strcmp(filtro, "sharpen") == 0) {
-        imagen.aplicar(3);
+    if (ok && con_estadisticas && filtrar && backend->esRaiz()) {
+        std::string ruta = std::string(posicionales[1]) + ".estadisticas.json";
+        ok = estadisticas.escribirJSON(ruta.c_str(), imagen.getWidth(), imagen.getHeight());
     }
-    if (!imagen.guardarEnArchivo(argv[2])) {
-        return 1;
+    if (ok && filtrar && con_clave) cache->guardar(clave, posicionales[1]);
+    t_guardado = segundosDesde(fase);
+
+    if (tiempos && ok && backend->esRaiz()) {
+        std::cout << "Tiempos (s): carga=" << t_carga << " filtro=" << t_filtro
+                  << " guardado=" << t_guardado << " total=" << segundosDesde(inicio)
+                  << " backend=" << backend->nombre() << " procesos=" << backend->getNumProcesos()
+                  << " hilos=" << backend->getNumThreads() << (acierto ? " cache=acierto" : "") << std::endl;
+    }
+    if (estadisticas_cache && cache != nullptr) {
+        EstadisticasCache e = cache->leerEstadisticas();
+        std::cout << "Cache: aciertos=" << e.aciertos << " fallos=" << e.fallos << " expulsiones=" << e.expulsiones
+                  << " entradas=" << e.entradas << " bytes=" << e.bytes << std::endl;
     }
-    
+    delete cache;
 
-    return 0;
-}
\ No newline at end of file
+    backend->finalizar();
+    delete backend;
+    return ok ? 0 : 1;
+}
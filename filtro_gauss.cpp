@@ -0,0 +1,120 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "nucleo/piramide.h"
+
+// Desenfoque gaussiano de una imagen a varias intensidades. La piramide de la
+// fuente se construye una sola vez por ejecucion y, con --cache, se guarda en
+// disco para las siguientes.
+
+void mostrarUso(const char* programa) {
+    std::cout << "Uso: " << programa << " [--cache <dir>] [--threads <n>] [--tiempos]"
+              << " <input_file> <output_file> <sigma[,sigma...]>" << std::endl;
+    std::cout << "Con varios sigma se escribe <output>_s<sigma>.<ext> por cada uno" << std::endl;
+}
+
+double segundosDesde(const struct timespec& inicio) {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (ahora.tv_sec - inicio.tv_sec) + (ahora.tv_nsec - inicio.tv_nsec) / 1e9;
+}
+
+bool parsearSigmas(const char* cadena, std::vector<std::string>& textos, std::vector<double>& sigmas) {
+    std::string actual;
+    for (const char* p = cadena; ; p++) {
+        if (*p == ',' || *p == '\0') {
+            char* fin;
+            double sigma = strtod(actual.c_str(), &fin);
+            if (actual.empty() || *fin != '\0' || !(sigma >= 0)) {
+                std::cout << "Invalid sigma: " << actual << std::endl;
+                return false;
+            }
+            textos.push_back(actual);
+            sigmas.push_back(sigma);
+            actual.clear();
+            if (*p == '\0') break;
+        } else {
+            actual += *p;
+        }
+    }
+    return true;
+}
+
+// salida.ppm + "4" -> salida_s4.ppm
+std::string nombreSalida(const std::string& salida, const std::string& sigma) {
+    size_t punto = salida.find_last_of('.');
+    size_t barra = salida.find_last_of('/');
+    if (punto == std::string::npos || (barra != std::string::npos && punto < barra)) {
+        return salida + "_s" + sigma;
+    }
+    return salida.substr(0, punto) + "_s" + sigma + salida.substr(punto);
+}
+
+int main(int argc, char* argv[]) {
+    const char* dir_cache = nullptr;
+    const char* posicionales[3];
+    int num_posicionales = 0;
+    bool tiempos = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            dir_cache = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+#ifdef _OPENMP
+            omp_set_num_threads(atoi(argv[i + 1]));
+#endif
+            i++;
+        } else if (strcmp(argv[i], "--tiempos") == 0) {
+            tiempos = true;
+        } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            mostrarUso(argv[0]);
+            return 1;
+        } else if (num_posicionales < 3) {
+            posicionales[num_posicionales++] = argv[i];
+        } else {
+            mostrarUso(argv[0]);
+            return 1;
+        }
+    }
+    if (num_posicionales != 3) {
+        mostrarUso(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> textos;
+    std::vector<double> sigmas;
+    if (!parsearSigmas(posicionales[2], textos, sigmas)) return 1;
+
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+
+    Imagen fuente;
+    if (!fuente.cargarDesdeArchivo(posicionales[0])) return 1;
+
+    CachePiramides cache(dir_cache);
+    for (size_t i = 0; i < sigmas.size(); i++) {
+        struct timespec fase;
+        clock_gettime(CLOCK_MONOTONIC, &fase);
+        Imagen destino;
+        if (!desenfoqueGaussiano(fuente, sigmas[i], destino, &cache)) return 1;
+        double t_filtro = segundosDesde(fase);
+
+        std::string salida = sigmas.size() == 1 ? posicionales[1] : nombreSalida(posicionales[1], textos[i]);
+        if (!destino.guardarEnArchivo(salida.c_str())) return 1;
+        if (tiempos) {
+            std::cout << "sigma=" << textos[i] << " filtro=" << t_filtro << " s -> " << salida << std::endl;
+        }
+    }
+    if (tiempos) {
+        std::cout << "Tiempo total (s): " << segundosDesde(inicio) << std::endl;
+    }
+    return 0;
+}
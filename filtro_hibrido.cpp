@@ -0,0 +1,62 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mpi.h>
+#include <omp.h>
+
+#include "nucleo/backend.h"
+
+int main(int argc, char* argv[]) {
+    int num_threads = (argc == 5) ? atoi(argv[4]) : omp_get_max_threads();
+    if (num_threads < 1) num_threads = 1;
+
+    // Un rank por nodo o socket y num_threads hilos OpenMP dentro de cada uno
+    Backend* backend = crearBackendMPI(num_threads);
+    backend->inicializar(&argc, &argv);
+    bool root = backend->esRaiz();
+    
+    if (argc != 4 && argc != 5) {
+        if (root) {
+            std::cout << "Uso: " << argv[0] << " <input_file> <output_file> <filter> [threads_per_rank]" << std::endl;
+            std::cout << "Filtros: " << listaFiltros() << std::endl;
+        }
+        backend->finalizar();
+        delete backend;
+        return 1;
+    }
+    
+    const char* input_file = argv[1];
+    const char* output_file = argv[2];
+    const char* filtro_nombre = argv[3];
+
+    Filtro filtro;
+    bool ok = buscarFiltro(filtro_nombre, filtro);
+    if (!ok && root) {
+        std::cout << "Unknown filter: " << filtro_nombre << std::endl;
+    }
+    
+    Imagen imagenCompleta;
+    if (ok && root) {
+        ok = imagenCompleta.cargarDesdeArchivo(input_file);
+    }
+    ok = backend->consenso(ok);
+    
+    double start_time = MPI_Wtime();
+    if (ok) {
+        ok = backend->aplicar(imagenCompleta, filtro);
+    }
+    double end_time = MPI_Wtime();
+
+    if (ok && root) {
+        ok = imagenCompleta.guardarEnArchivo(output_file);
+        
+        std::cout << "Tiempo de ejecución: " << (end_time - start_time) << " segundos" << std::endl;
+        std::cout << "Procesado con " << backend->getNumProcesos() << " procesos y "
+                  << backend->getNumThreads() << " hilos por proceso" << std::endl;
+    }
+    
+    backend->finalizar();
+    delete backend;
+    return ok ? 0 : 1;
+}
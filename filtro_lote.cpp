@@ -0,0 +1,320 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "nucleo/cache_resultados.h"
+#include "nucleo/imagen.h"
+#include "nucleo/pnm.h"
+
+#define NUM_THREADS 4
+// Imagenes con menos muestras que esto se procesan una por hilo; las mas
+// grandes se reparten por filas entre todos los hilos
+#ifndef UMBRAL_IMAGEN_GRANDE
+#define UMBRAL_IMAGEN_GRANDE (1024 * 1024)
+#endif
+
+struct Trabajo {
+    std::string entrada;
+    std::string salida;
+    long muestras;
+    long bytes;
+    uint64_t clave;  // en la cache de resultados
+    bool con_clave;
+    bool escrito;    // la salida quedo completa
+};
+
+// Estado del lote compartido por todos los hilos
+struct Lote {
+    std::vector<Trabajo> pequenos;
+    std::vector<Trabajo> grandes;
+    Filtro filtro;
+    int num_threads;
+    std::atomic<size_t> siguiente_pequeno;
+    std::atomic<int> errores;
+
+    // Imagen grande actual, repartida por filas entre todos los hilos
+    Imagen grande;
+    BufferPixeles destino_grande;
+    pthread_barrier_t barrera;
+    bool terminar;
+
+    // La barrera se arma cuando se sabe cuantos hilos arrancaron; hasta
+    // entonces los hilos esperan aca antes de la fase 2
+    pthread_mutex_t mutex_arranque = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t arranque = PTHREAD_COND_INITIALIZER;
+    bool barrera_lista = false;
+};
+
+struct ArgHilo {
+    Lote* lote;
+    int id;
+};
+
+void* hiloLote(void* arg) {
+    ArgHilo* a = (ArgHilo*)arg;
+    Lote& lote = *a->lote;
+    // Los buffers de cada imagen vuelven al pool al reemplazarse, asi que
+    // la siguiente carga del mismo tamano no pide memoria al sistema
+    Imagen imagen;
+
+    // Fase 1: paralelismo entre imagenes. Cada carga y guardado ASCII va
+    // secuencial: con un parseo en paralelo por worker habria num_threads
+    // veces mas hilos que nucleos
+    configurarHilosPNM(1);
+    for (;;) {
+        size_t i = lote.siguiente_pequeno.fetch_add(1);
+        if (i >= lote.pequenos.size()) break;
+        Trabajo& t = lote.pequenos[i];
+        if (!imagen.cargarDesdeArchivo(t.entrada.c_str())) {
+            lote.errores++;
+            continue;
+        }
+        imagen.aplicar(lote.filtro);
+        t.escrito = imagen.guardarEnArchivo(t.salida.c_str());
+        if (!t.escrito) lote.errores++;
+    }
+
+    pthread_mutex_lock(&lote.mutex_arranque);
+    while (!lote.barrera_lista) pthread_cond_wait(&lote.arranque, &lote.mutex_arranque);
+    pthread_mutex_unlock(&lote.mutex_arranque);
+
+    // Fase 2: paralelismo dentro de cada imagen grande
+    for (;;) {
+        pthread_barrier_wait(&lote.barrera);
+        if (lote.terminar) break;
+        int height = lote.grande.getHeight();
+        int start_y = (int)((long)height * a->id / lote.num_threads);
+        int end_y = (int)((long)height * (a->id + 1) / lote.num_threads);
+        Plano plano = lote.grande.getPlano();
+        int* destino = lote.destino_grande.escritura() + (long)start_y * plano.rowCount();
+        filtrarFilas(lote.filtro, plano, destino, start_y, end_y);
+        pthread_barrier_wait(&lote.barrera);
+    }
+    return NULL;
+}
+
+bool esImagenPNM(const char* nombre) {
+    const char* punto = strrchr(nombre, '.');
+    return punto != NULL && (strcmp(punto, ".pgm") == 0 || strcmp(punto, ".ppm") == 0);
+}
+
+std::string nombreBase(const std::string& ruta) {
+    size_t barra = ruta.find_last_of('/');
+    return barra == std::string::npos ? ruta : ruta.substr(barra + 1);
+}
+
+// Acepta un directorio con .pgm/.ppm o un manifiesto con una ruta por linea
+bool listarEntradas(const char* origen, const char* dir_salida, std::vector<Trabajo>& trabajos) {
+    struct stat info;
+    if (stat(origen, &info) != 0) {
+        std::cout << "Error, incorrect path: " << origen << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> entradas;
+    if (S_ISDIR(info.st_mode)) {
+        DIR* dir = opendir(origen);
+        if (dir == NULL) {
+            std::cout << "Error opening directory: " << origen << std::endl;
+            return false;
+        }
+        struct dirent* ent;
+        while ((ent = readdir(dir)) != NULL) {
+            if (esImagenPNM(ent->d_name)) {
+                entradas.push_back(std::string(origen) + "/" + ent->d_name);
+            }
+        }
+        closedir(dir);
+        std::sort(entradas.begin(), entradas.end());
+    } else {
+        FILE* manifiesto = fopen(origen, "r");
+        if (manifiesto == NULL) {
+            std::cout << "Error opening manifest: " << origen << std::endl;
+            return false;
+        }
+        char linea[4096];
+        while (fgets(linea, sizeof(linea), manifiesto) != NULL) {
+            linea[strcspn(linea, "\r\n")] = '\0';
+            if (linea[0] != '\0' && linea[0] != '#') entradas.push_back(linea);
+        }
+        fclose(manifiesto);
+    }
+
+    for (size_t i = 0; i < entradas.size(); i++) {
+        Trabajo t;
+        t.entrada = entradas[i];
+        t.salida = std::string(dir_salida) + "/" + nombreBase(entradas[i]);
+        t.bytes = (stat(t.entrada.c_str(), &info) == 0) ? (long)info.st_size : 0;
+
+        // Solo el encabezado, para decidir como se va a repartir
+        t.muestras = 0;
+        LectorPNM lector;
+        if (lector.abrir(t.entrada.c_str())) {
+            const EncabezadoPNM& enc = lector.getEncabezado();
+            t.muestras = (long)enc.height * enc.rowCount();
+        }
+        trabajos.push_back(t);
+    }
+    return true;
+}
+
+double segundosDesde(const struct timespec& inicio) {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (ahora.tv_sec - inicio.tv_sec) + (ahora.tv_nsec - inicio.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    // Opciones antes de los argumentos posicionales
+    const char* dir_cache = nullptr;
+    uint64_t max_cache = CACHE_MAX_BYTES_POR_DEFECTO;
+    while (argc > 2 && strncmp(argv[1], "--cache", 7) == 0) {
+        if (strcmp(argv[1], "--cache") == 0) {
+            dir_cache = argv[2];
+        } else if (strcmp(argv[1], "--cache-max") == 0) {
+            max_cache = strtoull(argv[2], NULL, 10) * 1024 * 1024;
+        } else {
+            break;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc != 4 && argc != 5) {
+        std::cout << "Uso: " << argv[0] << " [--cache <dir> [--cache-max <MB>]]"
+                  << " <input_dir|manifest> <output_dir> <filter> [threads]" << std::endl;
+        std::cout << "Filtros: " << listaFiltros() << std::endl;
+        return 1;
+    }
+
+    Lote* lote = new Lote();
+    if (!buscarFiltro(argv[3], lote->filtro)) {
+        std::cout << "Unknown filter: " << argv[3] << std::endl;
+        delete lote;
+        return 1;
+    }
+    lote->num_threads = (argc == 5) ? atoi(argv[4]) : NUM_THREADS;
+    if (lote->num_threads < 1) lote->num_threads = 1;
+
+    std::vector<Trabajo> trabajos;
+    if (!listarEntradas(argv[1], argv[2], trabajos)) {
+        delete lote;
+        return 1;
+    }
+
+    // Los aciertos de la cache se sirven aca y no entran al lote
+    CacheResultados* cache = dir_cache != nullptr ? new CacheResultados(dir_cache, max_cache) : nullptr;
+    std::string especificacion = especificacionFiltros(std::vector<Filtro>(1, lote->filtro));
+    size_t aciertos = 0;
+    long total_bytes = 0;
+    for (size_t i = 0; i < trabajos.size(); i++) {
+        total_bytes += trabajos[i].bytes;
+        trabajos[i].con_clave = false;
+        trabajos[i].escrito = false;
+        if (cache != nullptr) {
+            trabajos[i].con_clave = cache->calcularClave(trabajos[i].entrada.c_str(), especificacion, trabajos[i].clave);
+            if (trabajos[i].con_clave && cache->servir(trabajos[i].clave, trabajos[i].salida.c_str())) {
+                aciertos++;
+                continue;
+            }
+        }
+        if (trabajos[i].muestras >= UMBRAL_IMAGEN_GRANDE) {
+            lote->grandes.push_back(trabajos[i]);
+        } else {
+            lote->pequenos.push_back(trabajos[i]);
+        }
+    }
+    lote->siguiente_pequeno = 0;
+    lote->errores = 0;
+    lote->terminar = false;
+
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+
+    std::vector<pthread_t> threads(lote->num_threads);
+    std::vector<ArgHilo> args(lote->num_threads);
+    int iniciados = 0;
+    for (int i = 0; i < lote->num_threads; i++) {
+        args[i].lote = lote;
+        args[i].id = i;
+        int rc = pthread_create(&threads[i], NULL, hiloLote, &args[i]);
+        if (rc) {
+            std::cout << "Error creating thread " << i << std::endl;
+            break;
+        }
+        iniciados++;
+    }
+    if (iniciados == 0) {
+        delete cache;
+        delete lote;
+        return 1;
+    }
+    // Las imagenes grandes se reparten solo entre los hilos que arrancaron
+    lote->num_threads = iniciados;
+    pthread_barrier_init(&lote->barrera, NULL, iniciados + 1);
+    pthread_mutex_lock(&lote->mutex_arranque);
+    lote->barrera_lista = true;
+    pthread_cond_broadcast(&lote->arranque);
+    pthread_mutex_unlock(&lote->mutex_arranque);
+
+    // Las imagenes grandes se cargan y guardan desde el hilo principal, con
+    // el parseo y el formato ASCII repartidos en tantos hilos como el lote;
+    // los workers se suman al filtrado cuando terminan con las pequenas
+    configurarHilosPNM(lote->num_threads);
+    for (size_t i = 0; i < lote->grandes.size(); i++) {
+        Trabajo& t = lote->grandes[i];
+        if (!lote->grande.cargarDesdeArchivo(t.entrada.c_str())) {
+            lote->errores++;
+            continue;
+        }
+        lote->destino_grande = BufferPixeles(lote->grande.getPixelCount());
+        pthread_barrier_wait(&lote->barrera);
+        pthread_barrier_wait(&lote->barrera);
+        lote->grande.reemplazarPixeles(std::move(lote->destino_grande));
+        t.escrito = lote->grande.guardarEnArchivo(t.salida.c_str());
+        if (!t.escrito) lote->errores++;
+    }
+    lote->terminar = true;
+    pthread_barrier_wait(&lote->barrera);
+
+    for (int i = 0; i < lote->num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&lote->barrera);
+
+    if (cache != nullptr) {
+        for (size_t i = 0; i < lote->pequenos.size(); i++) {
+            const Trabajo& t = lote->pequenos[i];
+            if (t.con_clave && t.escrito) cache->guardar(t.clave, t.salida.c_str());
+        }
+        for (size_t i = 0; i < lote->grandes.size(); i++) {
+            const Trabajo& t = lote->grandes[i];
+            if (t.con_clave && t.escrito) cache->guardar(t.clave, t.salida.c_str());
+        }
+    }
+
+    double segundos = segundosDesde(inicio);
+    int errores = lote->errores.load();
+    std::cout << "Imagenes procesadas: " << trabajos.size() - errores << " de " << trabajos.size()
+              << " (" << lote->pequenos.size() << " pequenas, " << lote->grandes.size() << " grandes, "
+              << aciertos << " desde la cache)" << std::endl;
+    std::cout << "Tiempo total: " << segundos << " segundos" << std::endl;
+    if (segundos > 0) {
+        std::cout << "Throughput: " << trabajos.size() / segundos << " imagenes/s, "
+                  << total_bytes / (1024.0 * 1024.0) / segundos << " MB/s" << std::endl;
+    }
+
+    delete cache;
+    delete lote;
+    return errores == 0 ? 0 : 1;
+}
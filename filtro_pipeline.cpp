@@ -0,0 +1,618 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef FILTRO_IO_URING
+#include <liburing.h>
+#endif
+
+#include "nucleo/filtros.h"
+#include "nucleo/pnm.h"
+
+#define NUM_THREADS 4
+#define FILAS_POR_BLOQUE 64
+#define BLOQUES_EN_VUELO 16
+#define IO_BUFFER_SIZE (1 << 20)
+
+// Fuente de bytes con doble buffer sobre el descriptor de un LectorPNM, desde
+// el inicio de los datos binarios. Con io_uring la lectura del siguiente
+// buffer queda en vuelo mientras se decodifica el actual; sin io_uring se
+// usa pread().
+class FuenteArchivo {
+private:
+    int fd;
+    char* buffers[2];
+    size_t longitud[2];
+    int actual;
+    size_t pos;
+    off_t offset;
+    bool fin;
+#ifdef FILTRO_IO_URING
+    struct io_uring ring;
+    bool ring_activo;
+    bool pendiente;
+#endif
+
+    void pedirSiguiente() {
+        int otro = 1 - actual;
+#ifdef FILTRO_IO_URING
+        if (ring_activo) {
+            struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            io_uring_prep_read(sqe, fd, buffers[otro], IO_BUFFER_SIZE, offset);
+            io_uring_submit(&ring);
+            pendiente = true;
+            return;
+        }
+#endif
+        ssize_t n = pread(fd, buffers[otro], IO_BUFFER_SIZE, offset);
+        longitud[otro] = n > 0 ? (size_t)n : 0;
+        offset += longitud[otro];
+    }
+
+    bool recibirSiguiente() {
+        int otro = 1 - actual;
+#ifdef FILTRO_IO_URING
+        if (ring_activo && pendiente) {
+            struct io_uring_cqe* cqe;
+            io_uring_wait_cqe(&ring, &cqe);
+            longitud[otro] = cqe->res > 0 ? (size_t)cqe->res : 0;
+            offset += longitud[otro];
+            io_uring_cqe_seen(&ring, cqe);
+            pendiente = false;
+        }
+#endif
+        if (longitud[otro] == 0) {
+            fin = true;
+            return false;
+        }
+        actual = otro;
+        pos = 0;
+        pedirSiguiente();
+        return true;
+    }
+
+public:
+    FuenteArchivo() : fd(-1), actual(0), pos(0), offset(0), fin(false) {
+        buffers[0] = buffers[1] = nullptr;
+        longitud[0] = longitud[1] = 0;
+#ifdef FILTRO_IO_URING
+        ring_activo = false;
+        pendiente = false;
+#endif
+    }
+
+    ~FuenteArchivo() {
+#ifdef FILTRO_IO_URING
+        if (ring_activo) {
+            if (pendiente) {
+                struct io_uring_cqe* cqe;
+                io_uring_wait_cqe(&ring, &cqe);
+                io_uring_cqe_seen(&ring, cqe);
+            }
+            io_uring_queue_exit(&ring);
+        }
+#endif
+        delete[] buffers[0];
+        delete[] buffers[1];
+    }
+
+    // El descriptor sigue siendo del que lo abrio
+    void abrir(int descriptor, off_t desde) {
+        fd = descriptor;
+        offset = desde;
+        buffers[0] = new char[IO_BUFFER_SIZE];
+        buffers[1] = new char[IO_BUFFER_SIZE];
+#ifdef FILTRO_IO_URING
+        ring_activo = io_uring_queue_init(2, &ring, 0) == 0;
+#endif
+        // Deja el buffer 0 "vacio" y el 1 en vuelo
+        actual = 0;
+        longitud[0] = 0;
+        pedirSiguiente();
+    }
+
+    bool leerBytes(unsigned char* destino, size_t n) {
+        while (n > 0) {
+            if (pos >= longitud[actual] && !recibirSiguiente()) return false;
+            size_t parte = longitud[actual] - pos;
+            if (parte > n) parte = n;
+            memcpy(destino, buffers[actual] + pos, parte);
+            pos += parte;
+            destino += parte;
+            n -= parte;
+        }
+        return true;
+    }
+};
+
+// Sumidero de bytes con doble buffer sobre el descriptor de un EscritorPNM,
+// despues del encabezado. Con io_uring la escritura de un buffer lleno queda
+// en vuelo mientras se codifica el siguiente.
+class SumideroArchivo {
+private:
+    int fd;
+    char* buffers[2];
+    size_t usado;
+    int actual;
+    off_t offset;
+    bool error;
+#ifdef FILTRO_IO_URING
+    struct io_uring ring;
+    bool ring_activo;
+    bool pendiente;
+
+    void esperarEscritura() {
+        if (!pendiente) return;
+        struct io_uring_cqe* cqe;
+        io_uring_wait_cqe(&ring, &cqe);
+        if (cqe->res < 0) error = true;
+        io_uring_cqe_seen(&ring, cqe);
+        pendiente = false;
+    }
+#endif
+
+public:
+    SumideroArchivo() : fd(-1), usado(0), actual(0), offset(0), error(false) {
+        buffers[0] = buffers[1] = nullptr;
+#ifdef FILTRO_IO_URING
+        ring_activo = false;
+        pendiente = false;
+#endif
+    }
+
+    ~SumideroArchivo() {
+        cerrar();
+        delete[] buffers[0];
+        delete[] buffers[1];
+    }
+
+    // El descriptor sigue siendo del que lo abrio. Sin io_uring, o si la
+    // salida no admite posiciones (desde < 0, un pipe), se escribe con
+    // write() desde la posicion actual.
+    void abrir(int descriptor, off_t desde) {
+        fd = descriptor;
+        offset = desde;
+        buffers[0] = new char[IO_BUFFER_SIZE];
+        buffers[1] = new char[IO_BUFFER_SIZE];
+#ifdef FILTRO_IO_URING
+        ring_activo = desde >= 0 && io_uring_queue_init(2, &ring, 0) == 0;
+#endif
+    }
+
+    void vaciar() {
+        if (usado == 0) return;
+#ifdef FILTRO_IO_URING
+        if (ring_activo) {
+            esperarEscritura();
+            struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            io_uring_prep_write(sqe, fd, buffers[actual], usado, offset);
+            io_uring_submit(&ring);
+            pendiente = true;
+            offset += usado;
+            actual = 1 - actual;
+            usado = 0;
+            return;
+        }
+#endif
+        size_t escrito = 0;
+        while (escrito < usado) {
+            ssize_t n = write(fd, buffers[actual] + escrito, usado - escrito);
+            if (n <= 0) {
+                error = true;
+                break;
+            }
+            escrito += n;
+        }
+        offset += usado;
+        usado = 0;
+    }
+
+    void escribir(const unsigned char* datos, size_t n) {
+        while (n > 0) {
+            if (usado == IO_BUFFER_SIZE) vaciar();
+            size_t parte = IO_BUFFER_SIZE - usado;
+            if (parte > n) parte = n;
+            memcpy(buffers[actual] + usado, datos, parte);
+            usado += parte;
+            datos += parte;
+            n -= parte;
+        }
+    }
+
+    // Vacia lo pendiente; el descriptor lo cierra el EscritorPNM
+    bool cerrar() {
+        if (fd < 0) return !error;
+        vaciar();
+#ifdef FILTRO_IO_URING
+        if (ring_activo) {
+            esperarEscritura();
+            io_uring_queue_exit(&ring);
+            ring_activo = false;
+        }
+#endif
+        fd = -1;
+        return !error;
+    }
+};
+
+// Un bloque de filas con hasta `radio` filas de borde arriba y abajo
+struct Bloque {
+    int indice;
+    int start_row;
+    int end_row;
+    int halo_arriba;
+    int halo_abajo;
+    int* entrada;  // halo_arriba + (end_row - start_row) + halo_abajo filas
+    int* salida;   // (end_row - start_row) filas
+};
+
+// Cola acotada multiproductor/multiconsumidor sin locks (Vyukov).
+// La capacidad debe ser potencia de 2.
+class ColaAcotada {
+private:
+    struct Celda {
+        std::atomic<size_t> secuencia;
+        Bloque* dato;
+    };
+
+    Celda* celdas;
+    size_t mascara;
+    alignas(64) std::atomic<size_t> cabeza;
+    alignas(64) std::atomic<size_t> cola;
+
+public:
+    explicit ColaAcotada(size_t capacidad) : celdas(new Celda[capacidad]), mascara(capacidad - 1), cabeza(0), cola(0) {
+        for (size_t i = 0; i < capacidad; i++) {
+            celdas[i].secuencia.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~ColaAcotada() {
+        delete[] celdas;
+    }
+
+    bool intentarPush(Bloque* dato) {
+        size_t pos = cola.load(std::memory_order_relaxed);
+        for (;;) {
+            Celda& celda = celdas[pos & mascara];
+            size_t seq = celda.secuencia.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (cola.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    celda.dato = dato;
+                    celda.secuencia.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = cola.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool intentarPop(Bloque*& dato) {
+        size_t pos = cabeza.load(std::memory_order_relaxed);
+        for (;;) {
+            Celda& celda = celdas[pos & mascara];
+            size_t seq = celda.secuencia.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (cabeza.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    dato = celda.dato;
+                    celda.secuencia.store(pos + mascara + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = cabeza.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void push(Bloque* dato) {
+        while (!intentarPush(dato)) sched_yield();
+    }
+
+    Bloque* pop() {
+        Bloque* dato;
+        while (!intentarPop(dato)) sched_yield();
+        return dato;
+    }
+};
+
+// Estado compartido por las tres etapas. El encabezado, y en ASCII tambien
+// las muestras, pasan por LectorPNM y EscritorPNM; en binario los datos van
+// por la fuente y el sumidero sobre sus mismos descriptores.
+struct Pipeline {
+    LectorPNM lector;
+    EscritorPNM escritor;
+    FuenteArchivo fuente;
+    SumideroArchivo sumidero;
+    EncabezadoPNM encabezado;
+    Filtro filtro;
+    int num_bloques;
+    int num_workers;
+    ColaAcotada libres;
+    ColaAcotada pendientes;
+    ColaAcotada terminados;
+    std::atomic<bool> error_lectura;
+
+    Pipeline() : num_bloques(0), num_workers(NUM_THREADS),
+                 libres(BLOQUES_EN_VUELO), pendientes(BLOQUES_EN_VUELO), terminados(BLOQUES_EN_VUELO),
+                 error_lectura(false) {
+        memset(&encabezado, 0, sizeof(encabezado));
+    }
+
+    int rowCount() const { return encabezado.rowCount(); }
+};
+
+// En ASCII LectorPNM::leerFila valida cada muestra contra max_color
+bool leerFila(Pipeline& p, int* fila, unsigned char* buffer_binario) {
+    if (!p.encabezado.binario) return p.lector.leerFila(fila);
+
+    int count = p.rowCount();
+    int bytes = p.encabezado.bytesPorMuestra();
+    if (!p.fuente.leerBytes(buffer_binario, (size_t)count * bytes)) {
+        std::cout << "Error reading pixels." << std::endl;
+        return false;
+    }
+    decodificarMuestras(buffer_binario, fila, count, bytes);
+    return true;
+}
+
+// Etapa 1: parsea filas y llena bloques. Lee `radio` filas por adelantado
+// para poner el borde inferior de cada bloque y guarda las ultimas `radio`
+// filas para el borde superior del siguiente.
+void* hiloLector(void* arg) {
+    Pipeline& p = *(Pipeline*)arg;
+    int count = p.rowCount();
+    int height = p.encabezado.height;
+    int radio = p.filtro.radio;
+    unsigned char* buffer_binario = p.encabezado.binario ? new unsigned char[(size_t)count * 2] : nullptr;
+    int* anteriores = new int[(size_t)radio * count];
+    int* adelantadas = new int[(size_t)radio * count];
+    int num_adelantadas = 0;
+    bool ok = true;
+
+    for (int b = 0; b < p.num_bloques; b++) {
+        Bloque* bloque = p.libres.pop();
+        bloque->indice = b;
+        bloque->start_row = b * FILAS_POR_BLOQUE;
+        bloque->end_row = bloque->start_row + FILAS_POR_BLOQUE;
+        if (bloque->end_row > height) bloque->end_row = height;
+        bloque->halo_arriba = bloque->start_row < radio ? bloque->start_row : radio;
+        bloque->halo_abajo = height - bloque->end_row < radio ? height - bloque->end_row : radio;
+
+        int filas = bloque->end_row - bloque->start_row;
+        memcpy(bloque->entrada, anteriores + (size_t)(radio - bloque->halo_arriba) * count,
+               sizeof(int) * (size_t)bloque->halo_arriba * count);
+
+        // Filas interiores: primero las leidas por adelantado, luego del archivo
+        int* interior = bloque->entrada + (size_t)bloque->halo_arriba * count;
+        memcpy(interior, adelantadas, sizeof(int) * (size_t)num_adelantadas * count);
+        for (int r = num_adelantadas; r < filas; r++) {
+            if (ok) ok = leerFila(p, interior + (size_t)r * count, buffer_binario);
+        }
+
+        int* abajo = interior + (size_t)filas * count;
+        for (int r = 0; r < bloque->halo_abajo; r++) {
+            if (ok) ok = leerFila(p, abajo + (size_t)r * count, buffer_binario);
+        }
+        num_adelantadas = bloque->halo_abajo;
+        memcpy(adelantadas, abajo, sizeof(int) * (size_t)num_adelantadas * count);
+
+        // Los bloques completos tienen al menos `radio` filas
+        if (filas >= radio) {
+            memcpy(anteriores, interior + (size_t)(filas - radio) * count, sizeof(int) * (size_t)radio * count);
+        }
+
+        if (!ok) p.error_lectura.store(true);
+        p.pendientes.push(bloque);
+    }
+
+    // Un centinela por worker
+    for (int i = 0; i < p.num_workers; i++) {
+        p.pendientes.push(nullptr);
+    }
+
+    delete[] anteriores;
+    delete[] adelantadas;
+    delete[] buffer_binario;
+    return NULL;
+}
+
+void filtrarBloque(const Pipeline& p, Bloque* bloque) {
+    Plano plano;
+    plano.datos = bloque->entrada;
+    plano.width = p.encabezado.width;
+    plano.height = bloque->halo_arriba + (bloque->end_row - bloque->start_row) + bloque->halo_abajo;
+    plano.channels = p.encabezado.channels;
+    plano.max_color = p.encabezado.max_color;
+    filtrarFilas(p.filtro, plano, bloque->salida, bloque->halo_arriba,
+                 plano.height - bloque->halo_abajo);
+}
+
+// Etapa 2: filtra bloques en cualquier orden
+void* hiloWorker(void* arg) {
+    Pipeline& p = *(Pipeline*)arg;
+    for (;;) {
+        Bloque* bloque = p.pendientes.pop();
+        if (bloque == nullptr) break;
+        filtrarBloque(p, bloque);
+        p.terminados.push(bloque);
+    }
+    return NULL;
+}
+
+// Etapa 3 (hilo principal): escribe los bloques en orden y los devuelve a la
+// cola de libres. Despues de un error de escritura sigue vaciando la cola.
+bool escribirBloques(Pipeline& p) {
+    Bloque* en_espera[BLOQUES_EN_VUELO];
+    int esperando = 0;
+    int count = p.rowCount();
+    int bytes = p.encabezado.bytesPorMuestra();
+    unsigned char* buffer_binario =
+        p.encabezado.binario ? new unsigned char[(size_t)FILAS_POR_BLOQUE * count * bytes] : nullptr;
+    bool ok = true;
+
+    for (int siguiente = 0; siguiente < p.num_bloques; siguiente++) {
+        Bloque* bloque = nullptr;
+        for (int i = 0; i < esperando; i++) {
+            if (en_espera[i]->indice == siguiente) {
+                bloque = en_espera[i];
+                en_espera[i] = en_espera[--esperando];
+                break;
+            }
+        }
+        while (bloque == nullptr) {
+            Bloque* llegado = p.terminados.pop();
+            if (llegado->indice == siguiente) {
+                bloque = llegado;
+            } else {
+                en_espera[esperando++] = llegado;
+            }
+        }
+
+        int filas = bloque->end_row - bloque->start_row;
+        if (ok && p.encabezado.binario) {
+            size_t muestras = (size_t)filas * count;
+            codificarMuestras(bloque->salida, buffer_binario, (long)muestras, bytes);
+            p.sumidero.escribir(buffer_binario, muestras * bytes);
+        } else if (ok) {
+            ok = p.escritor.escribirFilas(bloque->salida, filas);
+        }
+        p.libres.push(bloque);
+    }
+
+    delete[] buffer_binario;
+    return ok;
+}
+
+// El encabezado de la salida lo escribe el EscritorPNM; en binario los datos
+// siguen por el sumidero a partir de ahi
+bool abrirSalida(Pipeline& p, const char* filename) {
+    if (!p.escritor.abrir(filename, p.encabezado)) return false;
+    if (!p.encabezado.binario) return true;
+    FILE* output = p.escritor.getFile();
+    if (fflush(output) != 0) {
+        std::cout << "Error writing header." << std::endl;
+        return false;
+    }
+    p.sumidero.abrir(fileno(output), ftell(output));
+    return true;
+}
+
+// No deja una salida truncada. Solo borra archivos regulares: la salida
+// puede ser /dev/stdout o un pipe con nombre
+void borrarSalidaIncompleta(const char* ruta) {
+    struct stat info;
+    if (lstat(ruta, &info) == 0 && S_ISREG(info.st_mode)) unlink(ruta);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 4 && argc != 5) {
+        std::cout << "Uso: " << argv[0] << " <input_file> <output_file> <filter> [workers]" << std::endl;
+        std::cout << "Filtros: " << listaFiltros() << std::endl;
+        return 1;
+    }
+
+    Pipeline* pipeline = new Pipeline();
+    Pipeline& p = *pipeline;
+
+    if (!buscarFiltro(argv[3], p.filtro)) {
+        std::cout << "Unknown filter: " << argv[3] << std::endl;
+        delete pipeline;
+        return 1;
+    }
+    // El borde de un bloque sale solo del bloque anterior y del siguiente
+    if (p.filtro.radio > FILAS_POR_BLOQUE) {
+        std::cout << "Filter window too large for filtro_pipeline: " << argv[3] << std::endl;
+        delete pipeline;
+        return 1;
+    }
+    if (argc == 5) {
+        p.num_workers = atoi(argv[4]);
+        if (p.num_workers < 1) p.num_workers = 1;
+    }
+
+    if (!p.lector.abrir(argv[1])) {
+        delete pipeline;
+        return 1;
+    }
+    p.encabezado = p.lector.getEncabezado();
+    if (p.encabezado.binario) p.fuente.abrir(fileno(p.lector.getFile()), p.lector.getInicioDatos());
+    if (!abrirSalida(p, argv[2])) {
+        if (p.escritor.getFile() != nullptr) {
+            p.escritor.cerrar();
+            borrarSalidaIncompleta(argv[2]);
+        }
+        delete pipeline;
+        return 1;
+    }
+
+    p.num_bloques = (p.encabezado.height + FILAS_POR_BLOQUE - 1) / FILAS_POR_BLOQUE;
+    int count = p.rowCount();
+    Bloque bloques[BLOQUES_EN_VUELO];
+    for (int i = 0; i < BLOQUES_EN_VUELO; i++) {
+        bloques[i].entrada = new int[(size_t)(FILAS_POR_BLOQUE + 2 * p.filtro.radio) * count];
+        bloques[i].salida = new int[(size_t)FILAS_POR_BLOQUE * count];
+        p.libres.push(&bloques[i]);
+    }
+
+    // Primero los workers: el lector manda un centinela por cada uno que
+    // arranco. Si no arranca ninguno, o no arranca el lector, se aborta.
+    pthread_t lector;
+    pthread_t* workers = new pthread_t[p.num_workers];
+    int iniciados = 0;
+    for (int i = 0; i < p.num_workers; i++) {
+        if (pthread_create(&workers[i], NULL, hiloWorker, &p) != 0) {
+            std::cout << "Error creating thread " << i << std::endl;
+            break;
+        }
+        iniciados++;
+    }
+    p.num_workers = iniciados;
+    bool lector_iniciado = iniciados > 0 && pthread_create(&lector, NULL, hiloLector, &p) == 0;
+    if (iniciados > 0 && !lector_iniciado) {
+        std::cout << "Error creating reader thread" << std::endl;
+    }
+
+    bool escrito = false;
+    if (lector_iniciado) {
+        escrito = escribirBloques(p);
+        pthread_join(lector, NULL);
+    } else {
+        for (int i = 0; i < iniciados; i++) p.pendientes.push(nullptr);
+    }
+    for (int i = 0; i < iniciados; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    delete[] workers;
+
+    for (int i = 0; i < BLOQUES_EN_VUELO; i++) {
+        delete[] bloques[i].entrada;
+        delete[] bloques[i].salida;
+    }
+
+    // Los errores de lectura y de escritura ASCII ya se informaron
+    bool ok = lector_iniciado && escrito && !p.error_lectura.load();
+    if (!p.sumidero.cerrar() && ok) {
+        std::cout << "Error writing pixels." << std::endl;
+        ok = false;
+    }
+    if (!p.escritor.cerrar() && ok) {
+        std::cout << "Error closing output file: " << argv[2] << std::endl;
+        ok = false;
+    }
+    if (!ok) borrarSalidaIncompleta(argv[2]);
+
+    delete pipeline;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,385 @@
+#include <iostream>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nucleo/buffer_pixeles.h"
+#include "nucleo/filtros.h"
+#include "nucleo/servidor.h"
+
+// Imagen mas grande que acepta el servidor, en muestras
+#define MAX_MUESTRAS_SERVIDOR (1L << 31)
+
+// Hilos que quedan vivos entre trabajos. El hilo principal es el hilo 0 y
+// los demas esperan en la barrera; cada grupo de pasos es una ronda.
+struct Motor {
+    int num_threads;
+    pthread_barrier_t barrera;
+    bool terminar;
+
+    // Ronda actual
+    const Filtro* pasos;
+    int num_pasos;
+    Plano plano;
+    int* destino;
+    bool validar;  // en lugar de filtrar, revisar que las muestras esten en rango
+    std::vector<char> fuera_de_rango;
+};
+
+struct ArgHilo {
+    Motor* motor;
+    int id;
+};
+
+void ejecutarRonda(Motor& motor, int id) {
+    int height = motor.plano.height;
+    int start_y = (int)((long)height * id / motor.num_threads);
+    int end_y = (int)((long)height * (id + 1) / motor.num_threads);
+    long row_size = motor.plano.rowCount();
+    if (motor.validar) {
+        const int* p = motor.plano.fila(start_y);
+        long count = (end_y - start_y) * row_size;
+        unsigned max_color = (unsigned)motor.plano.max_color;
+        bool fuera = false;
+        for (long i = 0; i < count; i++) fuera |= (unsigned)p[i] > max_color;
+        motor.fuera_de_rango[id] = fuera;
+    } else {
+        filtrarPasos(motor.pasos, motor.num_pasos, motor.plano, motor.destino + start_y * row_size, start_y, end_y);
+    }
+}
+
+void* hiloMotor(void* arg) {
+    ArgHilo* a = (ArgHilo*)arg;
+    Motor& motor = *a->motor;
+    for (;;) {
+        pthread_barrier_wait(&motor.barrera);
+        if (motor.terminar) break;
+        ejecutarRonda(motor, a->id);
+        pthread_barrier_wait(&motor.barrera);
+    }
+    return NULL;
+}
+
+void ronda(Motor& motor) {
+    pthread_barrier_wait(&motor.barrera);
+    ejecutarRonda(motor, 0);
+    pthread_barrier_wait(&motor.barrera);
+}
+
+struct Servidor {
+    Motor motor;
+    // Buffers intermedios de las cadenas con varios grupos; quedan del
+    // trabajo anterior y se reusan si el tamano no cambia
+    BufferPixeles intermedios[2];
+    size_t muestras_intermedios;
+    std::vector<double> latencias_us;
+};
+
+double microsegundosDesde(const struct timespec& inicio) {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (ahora.tv_sec - inicio.tv_sec) * 1e6 + (ahora.tv_nsec - inicio.tv_nsec) / 1e3;
+}
+
+void llenarEstadisticas(Servidor& servidor, RespuestaServidor& respuesta) {
+    std::vector<double> copia = servidor.latencias_us;
+    respuesta.trabajos = copia.size();
+    respuesta.p50_us = percentil(copia.data(), copia.size(), 50);
+    respuesta.p90_us = percentil(copia.data(), copia.size(), 90);
+    respuesta.p99_us = percentil(copia.data(), copia.size(), 99);
+    respuesta.max_us = copia.empty() ? 0 : copia.back();
+}
+
+void imprimirEstadisticas(Servidor& servidor) {
+    RespuestaServidor r;
+    llenarEstadisticas(servidor, r);
+    std::cout << "Trabajos: " << r.trabajos << "  latencia p50=" << r.p50_us << " us  p90=" << r.p90_us
+              << " us  p99=" << r.p99_us << " us  max=" << r.max_us << " us" << std::endl;
+}
+
+bool fallar(RespuestaServidor& respuesta, const std::string& mensaje) {
+    respuesta.ok = 0;
+    strncpy(respuesta.mensaje, mensaje.c_str(), sizeof(respuesta.mensaje) - 1);
+    respuesta.mensaje[sizeof(respuesta.mensaje) - 1] = '\0';
+    return false;
+}
+
+// Mapea un buffer del cliente; tiene que tener el tamano sellado y alcanzar.
+// La entrada ademas tiene que estar sellada contra escrituras: se valida y
+// despues se filtra, y no puede cambiar entre las dos pasadas.
+void* mapearBuffer(int fd, size_t bytes, bool escritura, RespuestaServidor& respuesta) {
+    struct stat info;
+    int sellos = fcntl(fd, F_GET_SEALS);
+    if (sellos < 0 || (sellos & F_SEAL_SHRINK) == 0) {
+        fallar(respuesta, "Shared buffers must be sealed against shrinking");
+        return nullptr;
+    }
+    if (!escritura && (sellos & F_SEAL_WRITE) == 0) {
+        fallar(respuesta, "Input buffer must be sealed against writes");
+        return nullptr;
+    }
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < bytes) {
+        fallar(respuesta, "Shared buffer too small for the image");
+        return nullptr;
+    }
+    void* datos = mmap(NULL, bytes, escritura ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (datos == MAP_FAILED) {
+        fallar(respuesta, std::string("Error mapping shared buffer: ") + strerror(errno));
+        return nullptr;
+    }
+    return datos;
+}
+
+// Filtra de la entrada compartida a la salida compartida. El ultimo grupo de
+// pasos escribe directo en la salida; los anteriores alternan entre los dos
+// buffers intermedios.
+bool filtrarTrabajo(Servidor& servidor, const PeticionServidor& peticion, const int* fds, int num_fds,
+                    RespuestaServidor& respuesta) {
+    if (num_fds != 2) return fallar(respuesta, "Filter requests need an input and an output buffer");
+    if (peticion.width < 1 || peticion.height < 1 || (peticion.channels != 1 && peticion.channels != 3) ||
+        peticion.max_color < 1 || peticion.max_color > 65535 || peticion.iteraciones < 1) {
+        return fallar(respuesta, "Invalid image parameters");
+    }
+    long muestras = (long)peticion.width * peticion.height * peticion.channels;
+    if (muestras > MAX_MUESTRAS_SERVIDOR) return fallar(respuesta, "Image too large");
+
+    char cadena[MAX_CADENA_SERVIDOR + 1];
+    memcpy(cadena, peticion.filtros, MAX_CADENA_SERVIDOR);
+    cadena[MAX_CADENA_SERVIDOR] = '\0';
+    std::vector<Filtro> filtros;
+    if (!parsearCadenaFiltros(cadena, filtros)) {
+        return fallar(respuesta, std::string("Unknown filter chain: ") + cadena);
+    }
+    std::vector<Filtro> pasos;
+    for (int it = 0; it < peticion.iteraciones; it++) {
+        pasos.insert(pasos.end(), filtros.begin(), filtros.end());
+    }
+
+    // La entrada esta sellada contra escrituras: no puede ser tambien la salida
+    struct stat info_entrada, info_salida;
+    if (fstat(fds[0], &info_entrada) == 0 && fstat(fds[1], &info_salida) == 0 &&
+        info_entrada.st_dev == info_salida.st_dev && info_entrada.st_ino == info_salida.st_ino) {
+        return fallar(respuesta, "Input and output must be different buffers");
+    }
+
+    size_t bytes = bytesBufferCompartido(peticion.width, peticion.height, peticion.channels);
+    const int* entrada = (const int*)mapearBuffer(fds[0], bytes, false, respuesta);
+    if (entrada == nullptr) return false;
+    int* salida = (int*)mapearBuffer(fds[1], bytes, true, respuesta);
+    if (salida == nullptr) {
+        munmap((void*)entrada, bytes);
+        return false;
+    }
+
+    Motor& motor = servidor.motor;
+    Plano plano;
+    plano.datos = entrada;
+    plano.width = peticion.width;
+    plano.height = peticion.height;
+    plano.channels = peticion.channels;
+    plano.max_color = peticion.max_color;
+
+    // Los filtros de rango indexan histogramas con las muestras
+    bool ok = true;
+    motor.plano = plano;
+    motor.validar = true;
+    ronda(motor);
+    motor.validar = false;
+    for (int i = 0; i < motor.num_threads; i++) ok = ok && !motor.fuera_de_rango[i];
+    if (!ok) fallar(respuesta, "Input samples out of range");
+
+    std::vector<int> grupos;
+    int total = (int)pasos.size();
+    for (int i = 0; ok && i < total;) {
+        grupos.push_back(agruparPasos(&pasos[i], total - i, INT_MAX));
+        i += grupos.back();
+    }
+    if (ok && grupos.size() > 1 && servidor.muestras_intermedios != (size_t)muestras) {
+        servidor.intermedios[0] = BufferPixeles(muestras);
+        servidor.intermedios[1] = BufferPixeles(muestras);
+        servidor.muestras_intermedios = muestras;
+    }
+
+    int primero = 0;
+    for (size_t g = 0; ok && g < grupos.size(); g++) {
+        bool ultimo = g + 1 == grupos.size();
+        motor.pasos = &pasos[primero];
+        motor.num_pasos = grupos[g];
+        motor.destino = ultimo ? salida : servidor.intermedios[g % 2].escritura();
+        ronda(motor);
+        plano.datos = motor.destino;
+        motor.plano = plano;
+        primero += grupos[g];
+    }
+    munmap((void*)entrada, bytes);
+    munmap(salida, bytes);
+    return ok;
+}
+
+volatile sig_atomic_t detener = 0;
+
+void manejarSenal(int) {
+    detener = 1;
+}
+
+// Atiende un mensaje de un cliente. Devuelve false si hay que cerrar la conexion.
+bool atenderCliente(Servidor& servidor, int sock, bool& terminar) {
+    PeticionServidor peticion;
+    int fds[2];
+    int num_fds;
+    if (!recibirMensaje(sock, &peticion, sizeof(peticion), fds, num_fds)) return false;
+
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    RespuestaServidor respuesta;
+    memset(&respuesta, 0, sizeof(respuesta));
+    respuesta.magia = MAGIA_SERVIDOR;
+    respuesta.ok = 1;
+
+    bool es_trabajo = false;
+    if (peticion.magia != MAGIA_SERVIDOR || peticion.version != VERSION_SERVIDOR) {
+        fallar(respuesta, "Unknown protocol version");
+    } else if (peticion.operacion == OP_FILTRAR) {
+        es_trabajo = filtrarTrabajo(servidor, peticion, fds, num_fds, respuesta);
+    } else if (peticion.operacion == OP_ESTADISTICAS) {
+        llenarEstadisticas(servidor, respuesta);
+    } else if (peticion.operacion == OP_TERMINAR) {
+        terminar = true;
+    } else {
+        fallar(respuesta, "Unknown operation");
+    }
+    for (int i = 0; i < num_fds; i++) close(fds[i]);
+
+    if (es_trabajo) {
+        respuesta.latencia_us = microsegundosDesde(inicio);
+        servidor.latencias_us.push_back(respuesta.latencia_us);
+    }
+    return enviarMensaje(sock, &respuesta, sizeof(respuesta), NULL, 0);
+}
+
+int main(int argc, char* argv[]) {
+    int num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char* ruta = SOCKET_SERVIDOR_POR_DEFECTO;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            ruta = argv[++i];
+        } else {
+            std::cout << "Uso: " << argv[0] << " [--threads <n>] [--socket <ruta>]" << std::endl;
+            std::cout << "Filtros: " << listaFiltros() << std::endl;
+            return 1;
+        }
+    }
+    if (num_threads < 1) num_threads = 1;
+
+    struct sockaddr_un dir;
+    if (strlen(ruta) >= sizeof(dir.sun_path)) {
+        std::cout << "Socket path too long: " << ruta << std::endl;
+        return 1;
+    }
+    int escucha = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (escucha < 0) {
+        std::cout << "Error creating socket: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    memset(&dir, 0, sizeof(dir));
+    dir.sun_family = AF_UNIX;
+    strcpy(dir.sun_path, ruta);
+    unlink(ruta);
+    // Solo el mismo usuario puede conectarse: los clientes escriben la
+    // memoria que lee el servidor
+    mode_t mascara = umask(0077);
+    int rc = bind(escucha, (struct sockaddr*)&dir, sizeof(dir));
+    umask(mascara);
+    if (rc != 0 || listen(escucha, 16) != 0) {
+        std::cout << "Error listening on " << ruta << ": " << strerror(errno) << std::endl;
+        close(escucha);
+        return 1;
+    }
+
+    struct sigaction accion;
+    memset(&accion, 0, sizeof(accion));
+    accion.sa_handler = manejarSenal;
+    sigaction(SIGINT, &accion, NULL);
+    sigaction(SIGTERM, &accion, NULL);
+
+    Servidor* servidor = new Servidor();
+    servidor->muestras_intermedios = 0;
+    Motor& motor = servidor->motor;
+    motor.num_threads = num_threads;
+    motor.terminar = false;
+    motor.validar = false;
+    motor.fuera_de_rango.assign(num_threads, 0);
+    pthread_barrier_init(&motor.barrera, NULL, num_threads);
+    std::vector<pthread_t> threads(num_threads);
+    std::vector<ArgHilo> args(num_threads);
+    for (int i = 1; i < num_threads; i++) {
+        args[i].motor = &motor;
+        args[i].id = i;
+        if (pthread_create(&threads[i], NULL, hiloMotor, &args[i]) != 0) {
+            std::cout << "Error creating thread " << i << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Escuchando en " << ruta << " con " << num_threads << " hilos" << std::endl;
+
+    // Un trabajo a la vez, con todos los hilos; los clientes se atienden por
+    // turno, un mensaje cada uno
+    std::vector<struct pollfd> conexiones(1);
+    conexiones[0].fd = escucha;
+    conexiones[0].events = POLLIN;
+    bool terminar = false;
+    while (!terminar && !detener) {
+        if (poll(conexiones.data(), conexiones.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cout << "Error in poll: " << strerror(errno) << std::endl;
+            break;
+        }
+        for (size_t i = conexiones.size(); i-- > 1;) {
+            if (conexiones[i].revents == 0) continue;
+            bool seguir = (conexiones[i].revents & POLLIN) != 0 && atenderCliente(*servidor, conexiones[i].fd, terminar);
+            if (!seguir) {
+                close(conexiones[i].fd);
+                conexiones.erase(conexiones.begin() + i);
+            }
+        }
+        if (conexiones[0].revents & POLLIN) {
+            int cliente = accept4(escucha, NULL, NULL, SOCK_CLOEXEC);
+            if (cliente >= 0) {
+                struct pollfd nueva;
+                nueva.fd = cliente;
+                nueva.events = POLLIN;
+                nueva.revents = 0;
+                conexiones.push_back(nueva);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < conexiones.size(); i++) close(conexiones[i].fd);
+    unlink(ruta);
+
+    motor.terminar = true;
+    pthread_barrier_wait(&motor.barrera);
+    for (int i = 1; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&motor.barrera);
+
+    imprimirEstadisticas(*servidor);
+    delete servidor;
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "nucleo/filtros.h"
+#include "nucleo/pnm.h"
+
+// Un filtro de la cadena. Guarda solo las ultimas 2 * radio + 1 filas
+// recibidas en una ventana y emite la fila y en cuanto recibe la fila
+// y + radio.
+class EtapaFiltro {
+private:
+    Filtro filtro;
+    EncabezadoPNM encabezado;
+    std::vector<int> ventana;
+    int filas_ventana;      // filas validas en la ventana
+    int max_filas_ventana;
+    int primera_fila;       // fila de la imagen que esta en ventana[0]
+    int filas_recibidas;
+    int filas_emitidas;
+
+    void emitir(int y, int* salida) {
+        Plano plano;
+        plano.datos = ventana.data();
+        plano.width = encabezado.width;
+        plano.height = filas_ventana;
+        plano.channels = encabezado.channels;
+        plano.max_color = encabezado.max_color;
+        filtrarFilas(filtro, plano, salida, y - primera_fila, y - primera_fila + 1);
+        filas_emitidas++;
+    }
+
+public:
+    EtapaFiltro() : filas_ventana(0), max_filas_ventana(0),
+                    primera_fila(0), filas_recibidas(0), filas_emitidas(0) {}
+
+    void configurar(const Filtro& f, const EncabezadoPNM& enc) {
+        filtro = f;
+        encabezado = enc;
+        max_filas_ventana = 2 * filtro.radio + 1;
+        ventana.assign((size_t)max_filas_ventana * encabezado.rowCount(), 0);
+    }
+
+    // Recibe la siguiente fila de entrada. Devuelve true si se produjo una
+    // fila de salida en `salida`.
+    bool recibirFila(const int* entrada, int* salida) {
+        int row_count = encabezado.rowCount();
+        int* datos = ventana.data();
+        if (filas_ventana == max_filas_ventana) {
+            memmove(datos, datos + row_count, sizeof(int) * (size_t)(filas_ventana - 1) * row_count);
+            filas_ventana--;
+            primera_fila++;
+        }
+        memcpy(datos + (size_t)filas_ventana * row_count, entrada, sizeof(int) * row_count);
+        filas_ventana++;
+        filas_recibidas++;
+
+        int y = filas_recibidas - 1 - filtro.radio;
+        if (y < 0) return false;
+        emitir(y, salida);
+        return true;
+    }
+
+    // Despues de la ultima fila de entrada emite las filas que no tienen
+    // vecinas inferiores. Devuelve false cuando ya no quedan.
+    bool siguientePendiente(int* salida) {
+        if (filas_emitidas >= encabezado.height) return false;
+        emitir(filas_emitidas, salida);
+        return true;
+    }
+};
+
+// Empuja una fila por las etapas [etapa, num_etapas) hasta el escritor
+bool propagarFila(std::vector<EtapaFiltro>& etapas, std::vector<std::vector<int>>& salidas, size_t etapa,
+                  const int* fila, EscritorPNM& escritor) {
+    if (etapa == etapas.size()) {
+        return escritor.escribirFila(fila);
+    }
+    if (etapas[etapa].recibirFila(fila, salidas[etapa].data())) {
+        return propagarFila(etapas, salidas, etapa + 1, salidas[etapa].data(), escritor);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 4) {
+        std::cout << "Uso: " << argv[0] << " <input_file> <output_file> <filter[,filter...]>" << std::endl;
+        std::cout << "Filtros: " << listaFiltros() << std::endl;
+        return 1;
+    }
+
+    std::vector<Filtro> filtros;
+    if (!parsearCadenaFiltros(argv[3], filtros)) {
+        return 1;
+    }
+
+    LectorPNM lector;
+    if (!lector.abrir(argv[1])) {
+        return 1;
+    }
+    const EncabezadoPNM& enc = lector.getEncabezado();
+    int row_count = enc.rowCount();
+
+    std::vector<EtapaFiltro> etapas(filtros.size());
+    std::vector<std::vector<int>> salidas(filtros.size(), std::vector<int>(row_count));
+    for (size_t i = 0; i < filtros.size(); i++) {
+        etapas[i].configurar(filtros[i], enc);
+    }
+
+    EscritorPNM escritor;
+    if (!escritor.abrir(argv[2], enc)) {
+        return 1;
+    }
+
+    std::vector<int> fila(row_count);
+    bool ok = true;
+    for (int y = 0; y < enc.height && ok; y++) {
+        ok = lector.leerFila(fila.data()) && propagarFila(etapas, salidas, 0, fila.data(), escritor);
+    }
+
+    // Vaciar la cadena: cada etapa emite sus ultimas filas y las pasa a las siguientes
+    for (size_t i = 0; i < etapas.size() && ok; i++) {
+        while (ok && etapas[i].siguientePendiente(salidas[i].data())) {
+            ok = propagarFila(etapas, salidas, i + 1, salidas[i].data(), escritor);
+        }
+    }
+
+    if (!escritor.cerrar()) {
+        std::cout << "Error closing output file." << std::endl;
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Driver para compiladores sin libFuzzer (GCC): pasa cada archivo de los
+// argumentos (o de los directorios) una vez por LLVMFuzzerTestOneInput. Sirve
+// para reproducir un crash o repasar un corpus con ASan/UBSan.
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static bool ejecutarArchivo(const char* ruta) {
+    FILE* archivo = fopen(ruta, "rb");
+    if (!archivo) {
+        std::cerr << "Error opening file: " << ruta << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> datos;
+    uint8_t bloque[65536];
+    size_t leidos;
+    while ((leidos = fread(bloque, 1, sizeof(bloque), archivo)) > 0) {
+        datos.insert(datos.end(), bloque, bloque + leidos);
+    }
+    fclose(archivo);
+    LLVMFuzzerTestOneInput(datos.data(), datos.size());
+    return true;
+}
+
+static int ejecutarRuta(const std::string& ruta) {
+    struct stat info;
+    if (stat(ruta.c_str(), &info) != 0) {
+        std::cerr << "Error opening file: " << ruta << std::endl;
+        return -1;
+    }
+    if (!S_ISDIR(info.st_mode)) return ejecutarArchivo(ruta.c_str()) ? 1 : -1;
+
+    DIR* dir = opendir(ruta.c_str());
+    if (!dir) return -1;
+    int total = 0;
+    struct dirent* entrada;
+    while ((entrada = readdir(dir)) != nullptr) {
+        if (entrada->d_name[0] == '.') continue;
+        int n = ejecutarRuta(ruta + "/" + entrada->d_name);
+        if (n < 0) {
+            closedir(dir);
+            return -1;
+        }
+        total += n;
+    }
+    closedir(dir);
+    return total;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Uso: " << argv[0] << " <archivo|directorio>..." << std::endl;
+        return 1;
+    }
+    int total = 0;
+    for (int i = 1; i < argc; i++) {
+        int n = ejecutarRuta(argv[i]);
+        if (n < 0) return 1;
+        total += n;
+    }
+    std::cerr << total << " entradas ejecutadas" << std::endl;
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../nucleo/filtros.h"
+#include "../nucleo/referencia.h"
+
+// Objetivo de fuzzing de la convolucion: los primeros bytes eligen el filtro,
+// las dimensiones, los canales, max_color y un corte de filas; el resto son
+// las muestras. filtrarFilas tiene que dar lo mismo que filtrarReferencia.
+
+static uint32_t leerU16(const uint8_t*& data, size_t& size) {
+    uint32_t valor = 0;
+    for (int i = 0; i < 2 && size > 0; i++, data++, size--) valor |= (uint32_t)*data << (8 * i);
+    return valor;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const int maximos[] = {1, 15, 255, 1000, 65535};
+    if (size < 8) return 0;
+
+    // listaFiltros() separa con ", "
+    static std::vector<Filtro> filtros;
+    if (filtros.empty()) {
+        std::string nombres;
+        for (const char* p = listaFiltros(); *p; p++) {
+            if (*p != ' ') nombres += *p;
+        }
+        if (!parsearCadenaFiltros(nombres.c_str(), filtros) || filtros.empty()) abort();
+    }
+    const Filtro& filtro = filtros[data[0] % filtros.size()];
+    int channels = (data[1] & 1) ? 3 : 1;
+    int max_color = maximos[(data[1] >> 1) % 5];
+    data += 2;
+    size -= 2;
+
+    Plano plano;
+    plano.width = 1 + (int)(leerU16(data, size) % 256);
+    plano.height = 1 + (int)(leerU16(data, size) % 256);
+    plano.channels = channels;
+    plano.max_color = max_color;
+    int corte = (int)(leerU16(data, size) % (uint32_t)(plano.height + 1));
+
+    long n = (long)plano.width * plano.height * channels;
+    std::vector<int> pixels(n);
+    for (long i = 0; i < n; i++) {
+        uint32_t muestra = size >= 2 ? leerU16(data, size) : (uint32_t)i * 2654435761u;
+        pixels[i] = (int)(muestra % (uint32_t)(max_color + 1));
+    }
+    plano.datos = pixels.data();
+
+    std::vector<int> esperado(n), obtenido(n);
+    filtrarReferencia(filtro, plano, esperado.data());
+    // Dos llamadas separadas para cubrir los bordes de cada rango de filas
+    filtrarFilas(filtro, plano, obtenido.data(), 0, corte);
+    filtrarFilas(filtro, plano, obtenido.data() + (long)corte * plano.rowCount(), corte, plano.height);
+    if (memcmp(esperado.data(), obtenido.data(), n * sizeof(int)) != 0) abort();
+    return 0;
+}
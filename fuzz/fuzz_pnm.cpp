@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+#include "../nucleo/imagen.h"
+
+// Objetivo de fuzzing del lector PNM: los bytes de entrada se escriben a un
+// archivo temporal y se cargan. Si la carga funciona, la imagen se guarda y se
+// vuelve a cargar, y las dos tienen que ser iguales.
+
+static std::string rutaTemporal(const char* sufijo) {
+    const char* dir = getenv("TMPDIR");
+    std::string ruta = (dir != nullptr && dir[0] != '\0') ? dir : "/tmp";
+    return ruta + "/fuzz_pnm_" + std::to_string((long)getpid()) + sufijo;
+}
+
+static bool escribirArchivo(const std::string& ruta, const uint8_t* data, size_t size) {
+    FILE* archivo = fopen(ruta.c_str(), "wb");
+    if (!archivo) return false;
+    bool ok = fwrite(data, 1, size, archivo) == size;
+    return fclose(archivo) == 0 && ok;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const std::string entrada = rutaTemporal(".pnm");
+    static const std::string salida = rutaTemporal("_salida.pnm");
+    // El lector imprime cada error por std::cout; no hace falta verlos
+    static bool silenciado = freopen("/dev/null", "w", stdout) != nullptr;
+    (void)silenciado;
+
+    if (!escribirArchivo(entrada, data, size)) return 0;
+
+    Imagen imagen;
+    if (!imagen.cargarDesdeArchivo(entrada.c_str())) return 0;
+    // Encabezados validos pero enormes no aportan nada y agotan la memoria
+    if (imagen.getPixelCount() > (1 << 22)) return 0;
+
+    Imagen leida;
+    if (!imagen.guardarEnArchivo(salida.c_str()) || !leida.cargarDesdeArchivo(salida.c_str())) abort();
+    if (leida.getWidth() != imagen.getWidth() || leida.getHeight() != imagen.getHeight() ||
+        leida.getChannels() != imagen.getChannels() || leida.getMaxColor() != imagen.getMaxColor()) {
+        abort();
+    }
+    const int* a = imagen.getPixels();
+    const int* b = leida.getPixels();
+    for (int i = 0; i < imagen.getPixelCount(); i++) {
+        if (a[i] != b[i]) abort();
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../nucleo/filtros.h"
+#include "../nucleo/pnm.h"
+#include "../nucleo/servidor.h"
+
+// Cliente minimo de filtro_servidor: lee el PNM directo al buffer compartido
+// de entrada, manda el trabajo `repeticiones` veces y escribe la salida desde
+// el buffer compartido de salida. Sirve para probar el servidor y medir la
+// latencia de ida y vuelta.
+
+void uso(const char* programa) {
+    std::cout << "Uso: " << programa << " [--socket <ruta>] [--iterations <n>] [--repeticiones <n>]"
+              << " <input_file> <output_file> <filters>" << std::endl;
+    std::cout << "     " << programa << " [--socket <ruta>] --estadisticas | --terminar" << std::endl;
+    std::cout << "Filtros: " << listaFiltros() << std::endl;
+}
+
+bool pedir(int sock, const PeticionServidor& peticion, const int* fds, int num_fds, RespuestaServidor& respuesta) {
+    int ninguno[2];
+    int recibidos;
+    if (!enviarMensaje(sock, &peticion, sizeof(peticion), fds, num_fds) ||
+        !recibirMensaje(sock, &respuesta, sizeof(respuesta), ninguno, recibidos)) {
+        std::cout << "Connection to the server lost" << std::endl;
+        return false;
+    }
+    if (!respuesta.ok) {
+        std::cout << "Server error: " << respuesta.mensaje << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void imprimirLatencias(const char* titulo, uint64_t trabajos, double p50, double p90, double p99, double maximo) {
+    std::cout << titulo << ": " << trabajos << " trabajos  p50=" << p50 << " us  p90=" << p90
+              << " us  p99=" << p99 << " us  max=" << maximo << " us" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    const char* ruta = SOCKET_SERVIDOR_POR_DEFECTO;
+    int iteraciones = 1;
+    int repeticiones = 1;
+    bool estadisticas = false;
+    bool terminar = false;
+    const char* posicionales[3];
+    int num_posicionales = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            ruta = argv[++i];
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iteraciones = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeticiones") == 0 && i + 1 < argc) {
+            repeticiones = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--estadisticas") == 0) {
+            estadisticas = true;
+        } else if (strcmp(argv[i], "--terminar") == 0) {
+            terminar = true;
+        } else if (argv[i][0] != '-' && num_posicionales < 3) {
+            posicionales[num_posicionales++] = argv[i];
+        } else {
+            num_posicionales = -1;
+            break;
+        }
+    }
+    bool control = estadisticas || terminar;
+    if ((control ? num_posicionales != 0 : num_posicionales != 3) || iteraciones < 1 || repeticiones < 1 ||
+        (estadisticas && terminar)) {
+        uso(argv[0]);
+        return 1;
+    }
+    if (!control && strlen(posicionales[2]) >= MAX_CADENA_SERVIDOR) {
+        std::cout << "Filter chain too long" << std::endl;
+        return 1;
+    }
+
+    int sock = conectarServidor(ruta);
+    if (sock < 0) return 1;
+
+    RespuestaServidor respuesta;
+    if (control) {
+        PeticionServidor peticion = nuevaPeticion(estadisticas ? OP_ESTADISTICAS : OP_TERMINAR);
+        bool ok = pedir(sock, peticion, NULL, 0, respuesta);
+        if (ok && estadisticas) {
+            imprimirLatencias("Servidor", respuesta.trabajos, respuesta.p50_us, respuesta.p90_us,
+                              respuesta.p99_us, respuesta.max_us);
+        }
+        close(sock);
+        return ok ? 0 : 1;
+    }
+
+    LectorPNM lector;
+    if (!lector.abrir(posicionales[0])) {
+        close(sock);
+        return 1;
+    }
+    EncabezadoPNM enc = lector.getEncabezado();
+    if (!validarTamanoImagen(enc.width, enc.height, enc.channels)) {
+        close(sock);
+        return 1;
+    }
+    size_t bytes = bytesBufferCompartido(enc.width, enc.height, enc.channels);
+    int fds[2] = {-1, -1};
+    int* escritura = (int*)crearBufferCompartido(bytes, fds[0]);
+    int* salida = escritura != nullptr ? (int*)crearBufferCompartido(bytes, fds[1]) : nullptr;
+    bool ok = salida != nullptr && lector.leerFilas(escritura, enc.height);
+    lector.cerrar();
+    // Una vez escrita, la entrada se sella; sellarEntrada desmapea la escritura
+    const void* entrada = nullptr;
+    if (ok) {
+        entrada = sellarEntrada(fds[0], escritura, bytes);
+        ok = entrada != nullptr;
+    } else if (escritura != nullptr) {
+        munmap(escritura, bytes);
+    }
+
+    PeticionServidor peticion = nuevaPeticion(OP_FILTRAR);
+    peticion.width = enc.width;
+    peticion.height = enc.height;
+    peticion.channels = enc.channels;
+    peticion.max_color = enc.max_color;
+    peticion.iteraciones = iteraciones;
+    strcpy(peticion.filtros, posicionales[2]);
+
+    // Ida y vuelta medida en el cliente; la latencia del servidor viene en
+    // cada respuesta
+    std::vector<double> ida_vuelta, servidor;
+    for (int r = 0; ok && r < repeticiones; r++) {
+        struct timespec inicio, fin;
+        clock_gettime(CLOCK_MONOTONIC, &inicio);
+        ok = pedir(sock, peticion, fds, 2, respuesta);
+        clock_gettime(CLOCK_MONOTONIC, &fin);
+        ida_vuelta.push_back((fin.tv_sec - inicio.tv_sec) * 1e6 + (fin.tv_nsec - inicio.tv_nsec) / 1e3);
+        servidor.push_back(respuesta.latencia_us);
+    }
+    close(sock);
+
+    if (ok) {
+        EscritorPNM escritor;
+        ok = escritor.abrir(posicionales[1], enc) && escritor.escribirFilas(salida, enc.height);
+        ok = escritor.cerrar() && ok;
+    }
+    if (ok && repeticiones > 1) {
+        std::vector<double>* series[2] = {&ida_vuelta, &servidor};
+        const char* titulos[2] = {"Ida y vuelta", "Servidor"};
+        for (int i = 0; i < 2; i++) {
+            std::vector<double>& v = *series[i];
+            double p50 = percentil(v.data(), v.size(), 50);
+            double p90 = percentil(v.data(), v.size(), 90);
+            double p99 = percentil(v.data(), v.size(), 99);
+            imprimirLatencias(titulos[i], v.size(), p50, p90, p99, v.back());
+        }
+    }
+
+    if (entrada != nullptr) munmap((void*)entrada, bytes);
+    if (salida != nullptr) munmap(salida, bytes);
+    for (int i = 0; i < 2; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../nucleo/pnm.h"
+
+// Genera un PNM sintetico (degradado con ruido) para entrenar PGO y para
+// los benchmarks. Con la misma semilla siempre genera la misma imagen.
+int main(int argc, char* argv[]) {
+    if (argc < 4 || argc > 7) {
+        std::cout << "Uso: " << argv[0] << " <output_file> <width> <height> [P2|P3|P5|P6] [max_color] [semilla]" << std::endl;
+        return 1;
+    }
+
+    EncabezadoPNM enc;
+    strncpy(enc.magic, argc > 4 ? argv[4] : "P2", MAX_MAGIC - 1);
+    enc.magic[MAX_MAGIC - 1] = '\0';
+    enc.width = atoi(argv[2]);
+    enc.height = atoi(argv[3]);
+    enc.max_color = argc > 5 ? atoi(argv[5]) : 255;
+    unsigned int semilla = argc > 6 ? (unsigned int)atoi(argv[6]) : 1;
+
+    if (strcmp(enc.magic, "P2") == 0 || strcmp(enc.magic, "P5") == 0) {
+        enc.channels = 1;
+    } else if (strcmp(enc.magic, "P3") == 0 || strcmp(enc.magic, "P6") == 0) {
+        enc.channels = 3;
+    } else {
+        std::cout << "Unsupported format: " << enc.magic << std::endl;
+        return 1;
+    }
+    enc.binario = enc.magic[1] == '5' || enc.magic[1] == '6';
+    if (enc.width < 1 || enc.height < 1 || enc.max_color < 1 || enc.max_color > 65535) {
+        std::cout << "Invalid size or max color." << std::endl;
+        return 1;
+    }
+
+    EscritorPNM escritor;
+    if (!escritor.abrir(argv[1], enc)) {
+        return 1;
+    }
+
+    int row_count = enc.rowCount();
+    int* fila = new int[row_count];
+    unsigned int estado = semilla;
+    bool ok = true;
+    for (int y = 0; y < enc.height && ok; y++) {
+        for (int i = 0; i < row_count; i++) {
+            estado = estado * 1103515245u + 12345u;
+            int x = i / enc.channels;
+            long degradado = ((long)x * enc.max_color / enc.width + (long)y * enc.max_color / enc.height) / 2;
+            int ruido = (int)((estado >> 16) % 32) - 16;
+            long valor = degradado + ruido;
+            if (valor < 0) valor = 0;
+            if (valor > enc.max_color) valor = enc.max_color;
+            fila[i] = (int)valor;
+        }
+        ok = escritor.escribirFila(fila);
+    }
+    delete[] fila;
+
+    if (!escritor.cerrar() || !ok) {
+        std::cout << "Error writing pixels." << std::endl;
+        return 1;
+    }
+    return 0;
+}
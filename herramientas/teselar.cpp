@@ -0,0 +1,59 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../nucleo/region.h"
+
+// Convierte un PNM al formato teselado y un archivo teselado de vuelta a PNM
+// binario, de a franjas de filas: la imagen completa nunca esta en memoria.
+int main(int argc, char* argv[]) {
+    int tesela_ancho = TESELA_POR_DEFECTO;
+    int tesela_alto = TESELA_POR_DEFECTO;
+    const char* posicionales[2];
+    int num_posicionales = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tesela") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &tesela_ancho, &tesela_alto) != 2) tesela_ancho = 0;
+        } else if (argv[i][0] != '-' && num_posicionales < 2) {
+            posicionales[num_posicionales++] = argv[i];
+        } else {
+            num_posicionales = -1;
+            break;
+        }
+    }
+    if (num_posicionales != 2 || tesela_ancho < 1 || tesela_alto < 1) {
+        std::cout << "Uso: " << argv[0] << " [--tesela <ancho>x<alto>] <input_file> <output_file>" << std::endl;
+        std::cout << "  PNM -> teselado (.pnmt), o teselado -> PNM binario" << std::endl;
+        return 1;
+    }
+
+    LectorRegiones lector;
+    if (!lector.abrir(posicionales[0])) return 1;
+    EncabezadoPNM enc = lector.getEncabezado();
+    bool a_teselado = !esArchivoTeselado(posicionales[0]);
+
+    EscritorTeselado teselado;
+    EscritorPNM pnm;
+    bool ok = a_teselado ? teselado.abrir(posicionales[1], enc, tesela_ancho, tesela_alto)
+                         : pnm.abrir(posicionales[1], enc);
+
+    // Al teselar, cada franja es una fila de teselas
+    int filas_franja = a_teselado ? tesela_alto : TESELA_POR_DEFECTO;
+    if (filas_franja > enc.height) filas_franja = enc.height > 0 ? enc.height : 1;
+    std::vector<int> franja((size_t)filas_franja * enc.rowCount());
+    for (int y = 0; ok && y < enc.height; y += filas_franja) {
+        int filas = enc.height - y < filas_franja ? enc.height - y : filas_franja;
+        Region region = {0, y, enc.width, filas};
+        ok = lector.leer(region, franja.data());
+        if (ok) ok = a_teselado ? teselado.escribirFranja(franja.data(), filas) : pnm.escribirFilas(franja.data(), filas);
+    }
+
+    bool cerrado = a_teselado ? teselado.cerrar() : pnm.cerrar();
+    if (ok && !cerrado) {
+        std::cout << "Error closing output file: " << posicionales[1] << std::endl;
+    }
+    return ok && cerrado ? 0 : 1;
+}
@@ -0,0 +1,961 @@
+#include <iostream>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../nucleo/backend.h"
+#include "../nucleo/cache_resultados.h"
+#include "../nucleo/estadisticas.h"
+#include "../nucleo/incremental.h"
+#include "../nucleo/piramide.h"
+#include "../nucleo/referencia.h"
+#include "../nucleo/region.h"
+#include "../nucleo/servidor.h"
+
+extern char** environ;
+
+// Oraculo diferencial: genera imagenes aleatorias (incluidas 1xN, Nx1 y
+// anchos impares), las filtra con la implementacion de referencia y compara
+// byte a byte contra filtrarFilas (completo y por rangos de filas), contra
+// cada backend con distintos hilos (tambien aplicarPasos con una cadena
+// aleatoria de pasos), contra una ida y vuelta por cada formato
+// PNM, contra la lectura de regiones de PNM y de archivos teselados y contra
+// el refiltrado incremental de una version retocada. Las estadisticas de la
+// pasada final (--estadisticas) se comparan contra las recalculadas de la
+// salida de referencia. Tambien cada nivel de la piramide contra una
+// reduccion de referencia, la cache de resultados (fallo, acierto, entrada
+// alterada y expulsion) y las ida y vuelta por filtro_servidor. Una vez por
+// corrida pasa por filtro_streaming, en segundo plano, una imagen de mas de
+// INT_MAX muestras. Con MPI se corre con mpirun y el backend mpi entra en la
+// comparacion.
+//
+// Termina con 1 en la primera diferencia e imprime la semilla del caso para
+// reproducirlo.
+
+struct Caso {
+    unsigned int semilla;
+    int width;
+    int height;
+    int channels;
+    int max_color;
+    std::string filtro;
+    std::vector<std::string> pasos;  // cadena para aplicarPasos
+};
+
+static void describir(const Caso& caso) {
+    std::cout << "  semilla=" << caso.semilla << " " << caso.width << "x" << caso.height
+              << " canales=" << caso.channels << " max_color=" << caso.max_color
+              << " filtro=" << caso.filtro << " pasos=" << caso.pasos.size() << std::endl;
+}
+
+// Primer indice distinto, o -1
+static long compararMuestras(const int* a, const int* b, long n) {
+    for (long i = 0; i < n; i++) {
+        if (a[i] != b[i]) return i;
+    }
+    return -1;
+}
+
+static bool reportarDiferencia(const Caso& caso, const char* camino, const int* esperado, const int* obtenido, long n) {
+    long i = compararMuestras(esperado, obtenido, n);
+    if (i < 0) return true;
+    std::cout << "DIFERENCIA en " << camino << ": muestra " << i << " esperado " << esperado[i]
+              << " obtenido " << obtenido[i] << std::endl;
+    describir(caso);
+    return false;
+}
+
+// Histograma y recortes contra los de la referencia; minimo, maximo, media y
+// muestras contra los recalculados de la salida de referencia
+static bool reportarEstadisticas(const Caso& caso, const char* camino, const EstadisticasImagen& esperadas,
+                                 const int* salida, long n, const EstadisticasImagen& obtenidas) {
+    std::string error;
+    if (obtenidas.channels != caso.channels || obtenidas.max_color != caso.max_color ||
+        obtenidas.histograma.size() != esperadas.histograma.size()) {
+        error = "forma";
+    }
+    for (size_t i = 0; error.empty() && i < esperadas.histograma.size(); i++) {
+        if (obtenidas.histograma[i] != esperadas.histograma[i]) {
+            error = "histograma[" + std::to_string(i) + "] esperado " + std::to_string(esperadas.histograma[i]) +
+                    " obtenido " + std::to_string(obtenidas.histograma[i]);
+        }
+    }
+    for (int c = 0; error.empty() && c < caso.channels; c++) {
+        uint64_t muestras = 0;
+        int minimo = -1, maximo = -1;
+        double suma = 0;
+        for (long i = c; i < n; i += caso.channels) {
+            if (minimo < 0 || salida[i] < minimo) minimo = salida[i];
+            if (salida[i] > maximo) maximo = salida[i];
+            suma += salida[i];
+            muestras++;
+        }
+        double media = muestras > 0 ? suma / muestras : 0;
+        std::string canal = " canal " + std::to_string(c);
+        if (obtenidas.recortadas_cero[c] != esperadas.recortadas_cero[c] ||
+            obtenidas.recortadas_max[c] != esperadas.recortadas_max[c]) {
+            error = "recortes" + canal + " esperado " + std::to_string(esperadas.recortadas_cero[c]) + "/" +
+                    std::to_string(esperadas.recortadas_max[c]) + " obtenido " +
+                    std::to_string(obtenidas.recortadas_cero[c]) + "/" + std::to_string(obtenidas.recortadas_max[c]);
+        } else if (obtenidas.muestras(c) != muestras) {
+            error = "muestras" + canal;
+        } else if (obtenidas.minimo(c) != minimo || obtenidas.maximo(c) != maximo) {
+            error = "minimo/maximo" + canal;
+        } else if (obtenidas.media(c) != media) {
+            error = "media" + canal;
+        }
+    }
+    if (error.empty()) return true;
+    std::cout << "DIFERENCIA en " << camino << ": " << error << std::endl;
+    describir(caso);
+    return false;
+}
+
+// Lados chicos con preferencia por los bordes: 1, 2, 3 e impares
+static int ladoAleatorio(std::mt19937& rng) {
+    static const int especiales[] = {1, 2, 3, 4, 5, 7, 63, 64, 65};
+    if (rng() % 3 == 0) return especiales[rng() % (sizeof(especiales) / sizeof(especiales[0]))];
+    return 1 + (int)(rng() % 200);
+}
+
+static Caso generarCaso(unsigned int semilla, const std::vector<std::string>& filtros) {
+    static const int maximos[] = {1, 15, 255, 1000, 65535};
+    std::mt19937 rng(semilla);
+    Caso caso;
+    caso.semilla = semilla;
+    caso.width = ladoAleatorio(rng);
+    caso.height = ladoAleatorio(rng);
+    caso.channels = (rng() % 2) ? 3 : 1;
+    caso.max_color = maximos[rng() % 5];
+    caso.filtro = filtros[rng() % filtros.size()];
+    int num_pasos = 2 + (int)(rng() % 19);
+    for (int i = 0; i < num_pasos; i++) caso.pasos.push_back(filtros[rng() % filtros.size()]);
+    return caso;
+}
+
+static void llenarImagen(const Caso& caso, Imagen& imagen) {
+    imagen.setMetadata(caso.channels == 3 ? "P3" : "P2", caso.width, caso.height, caso.max_color, caso.channels);
+    imagen.allocatePixels();
+    std::mt19937 rng(caso.semilla * 2654435761u);
+    int* pixels = imagen.getPixelsEscritura();
+    for (int i = 0; i < imagen.getPixelCount(); i++) {
+        pixels[i] = (int)(rng() % (unsigned int)(caso.max_color + 1));
+    }
+}
+
+// filtrarFilas sobre la imagen completa y partida en rangos aleatorios
+static bool verificarFiltrarFilas(const Caso& caso, const Filtro& filtro, const Imagen& imagen, const int* esperado) {
+    Plano plano = imagen.getPlano();
+    long n = imagen.getPixelCount();
+    std::vector<int> salida(n > 0 ? n : 1);
+
+    filtrarFilas(filtro, plano, salida.data(), 0, plano.height);
+    if (!reportarDiferencia(caso, "filtrarFilas", esperado, salida.data(), n)) return false;
+
+    std::mt19937 rng(caso.semilla + 17);
+    std::fill(salida.begin(), salida.end(), -1);
+    int y = 0;
+    while (y < plano.height) {
+        int filas = 1 + (int)(rng() % (unsigned int)plano.height);
+        if (y + filas > plano.height) filas = plano.height - y;
+        filtrarFilas(filtro, plano, salida.data() + (long)y * plano.rowCount(), y, y + filas);
+        y += filas;
+    }
+    return reportarDiferencia(caso, "filtrarFilas por rangos", esperado, salida.data(), n);
+}
+
+// Guardar y volver a cargar en el formato ASCII y en el binario
+static bool verificarIdaVuelta(const Caso& caso, const Imagen& original, const std::string& dir) {
+    const char* formatos[2];
+    formatos[0] = caso.channels == 3 ? "P3" : "P2";
+    formatos[1] = caso.channels == 3 ? "P6" : "P5";
+
+    for (int f = 0; f < 2; f++) {
+        Imagen imagen;
+        imagen.copiarDesde(original);
+        imagen.setMetadata(formatos[f], caso.width, caso.height, caso.max_color, caso.channels);
+        std::string ruta = dir + "/verificar_" + formatos[f] + ".pnm";
+        Imagen leida;
+        if (!imagen.guardarEnArchivo(ruta.c_str()) || !leida.cargarDesdeArchivo(ruta.c_str())) {
+            std::cout << "ERROR de E/S en la ida y vuelta " << formatos[f] << std::endl;
+            describir(caso);
+            return false;
+        }
+        remove(ruta.c_str());
+        std::string camino = std::string("ida y vuelta ") + formatos[f];
+        if (leida.getWidth() != caso.width || leida.getHeight() != caso.height ||
+            leida.getMaxColor() != caso.max_color || leida.getChannels() != caso.channels) {
+            std::cout << "DIFERENCIA en " << camino << ": encabezado" << std::endl;
+            describir(caso);
+            return false;
+        }
+        if (!reportarDiferencia(caso, camino.c_str(), original.getPixels(), leida.getPixels(), original.getPixelCount())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Regiones aleatorias leidas del PNM ASCII, del binario y de un teselado con
+// teselas de tamano aleatorio, contra el recorte de la imagen en memoria
+static bool verificarRegiones(const Caso& caso, const Imagen& original, const std::string& dir) {
+    std::mt19937 rng(caso.semilla + 31);
+    std::string ruta_teselado = dir + "/verificar.pnmt";
+    {
+        EscritorTeselado escritor;
+        int tesela_alto = 1 + (int)(rng() % 70);
+        bool ok = escritor.abrir(ruta_teselado.c_str(), original.getEncabezado(), 1 + (int)(rng() % 70), tesela_alto);
+        for (int y = 0; ok && y < caso.height; y += tesela_alto) {
+            int filas = caso.height - y < tesela_alto ? caso.height - y : tesela_alto;
+            ok = escritor.escribirFranja(original.getPixels() + (size_t)y * caso.width * caso.channels, filas);
+        }
+        if (!escritor.cerrar() || !ok) {
+            std::cout << "ERROR de E/S al escribir el teselado" << std::endl;
+            describir(caso);
+            return false;
+        }
+    }
+
+    const char* formatos[2];
+    formatos[0] = caso.channels == 3 ? "P3" : "P2";
+    formatos[1] = caso.channels == 3 ? "P6" : "P5";
+    for (int f = 0; f < 3; f++) {
+        std::string ruta = ruta_teselado;
+        if (f < 2) {
+            Imagen imagen;
+            imagen.copiarDesde(original);
+            imagen.setMetadata(formatos[f], caso.width, caso.height, caso.max_color, caso.channels);
+            ruta = dir + "/verificar_region_" + formatos[f] + ".pnm";
+            if (!imagen.guardarEnArchivo(ruta.c_str())) return false;
+        }
+        LectorRegiones lector;
+        if (!lector.abrir(ruta.c_str())) {
+            describir(caso);
+            return false;
+        }
+        // En ASCII las regiones van en orden de y y sin repetir filas
+        int y = 0;
+        for (int r = 0; r < 4 && y < caso.height; r++) {
+            Region region;
+            region.x = (int)(rng() % (unsigned int)caso.width);
+            region.width = 1 + (int)(rng() % (unsigned int)(caso.width - region.x));
+            region.y = y + (int)(rng() % (unsigned int)(caso.height - y));
+            region.height = 1 + (int)(rng() % (unsigned int)(caso.height - region.y));
+            if (f == 0) y = region.y + region.height;
+
+            Imagen leida, esperada;
+            recortarRegion(original, region, esperada);
+            std::string camino = std::string("region de ") + (f < 2 ? formatos[f] : "teselado");
+            if (!lector.leer(region, leida)) {
+                std::cout << "ERROR al leer la " << camino << std::endl;
+                describir(caso);
+                return false;
+            }
+            if (!reportarDiferencia(caso, camino.c_str(), esperada.getPixels(), leida.getPixels(),
+                                    esperada.getPixelCount())) {
+                return false;
+            }
+        }
+        remove(ruta.c_str());
+    }
+    return true;
+}
+
+// Retoca rectangulos aleatorios y compara el refiltrado incremental (con los
+// rectangulos dados, con las diferencias contra la original y con la
+// deteccion por hashes) contra la referencia
+static bool verificarIncremental(const Caso& caso, const Filtro& filtro, const Imagen& original,
+                                 const int* esperado) {
+    std::mt19937 rng(caso.semilla + 47);
+    int tesela = 1 + (int)(rng() % 70);
+    std::vector<Filtro> pasos(1, filtro);
+    FiltroIncremental sesion(pasos, tesela);
+    sesion.actualizar(original);
+    if (!reportarDiferencia(caso, "incremental inicial", esperado, sesion.getSalida().getPixels(),
+                            original.getPixelCount())) {
+        return false;
+    }
+
+    Imagen retocada;
+    retocada.copiarDesde(original);
+    std::vector<Region> cambios;
+    int num_cambios = 1 + (int)(rng() % 3);
+    int* pixels = retocada.getPixelsEscritura();
+    for (int c = 0; c < num_cambios; c++) {
+        Region cambio;
+        cambio.x = (int)(rng() % (unsigned int)caso.width);
+        cambio.y = (int)(rng() % (unsigned int)caso.height);
+        cambio.width = 1 + (int)(rng() % (unsigned int)(caso.width - cambio.x));
+        cambio.height = 1 + (int)(rng() % (unsigned int)(caso.height - cambio.y));
+        cambios.push_back(cambio);
+        for (int y = cambio.y; y < cambio.y + cambio.height; y++) {
+            for (int i = cambio.x * caso.channels; i < (cambio.x + cambio.width) * caso.channels; i++) {
+                pixels[(size_t)y * caso.width * caso.channels + i] = (int)(rng() % (unsigned int)(caso.max_color + 1));
+            }
+        }
+    }
+    std::vector<int> esperado_retocado(original.getPixelCount());
+    filtrarReferencia(filtro, retocada.getPlano(), esperado_retocado.data());
+
+    Imagen salida;
+    salida.copiarDesde(sesion.getSalida());
+    refiltrarRegiones(pasos, retocada, cambios, salida, tesela);
+    if (!reportarDiferencia(caso, "refiltrarRegiones", esperado_retocado.data(), salida.getPixels(),
+                            original.getPixelCount())) {
+        return false;
+    }
+    salida.copiarDesde(sesion.getSalida());
+    refiltrarRegiones(pasos, retocada, regionesCambiadas(original, retocada, tesela), salida, tesela);
+    if (!reportarDiferencia(caso, "refiltrarRegiones por diferencias", esperado_retocado.data(), salida.getPixels(),
+                            original.getPixelCount())) {
+        return false;
+    }
+    sesion.actualizar(retocada);
+    return reportarDiferencia(caso, "incremental por hashes", esperado_retocado.data(),
+                              sesion.getSalida().getPixels(), original.getPixelCount());
+}
+
+// Cada nivel contra la reduccion de referencia del nivel de referencia
+// anterior, y los niveles guardados y vueltos a cargar
+static bool verificarPiramide(const Caso& caso, const Imagen& original, const std::string& dir) {
+    Piramide piramide;
+    piramide.construir(original);
+    std::vector<int> anterior(original.getPixels(), original.getPixels() + original.getPixelCount());
+    int width = caso.width;
+    int height = caso.height;
+    int k = 1;
+    for (; width > 1 || height > 1; k++) {
+        Plano plano = original.getPlano();
+        plano.datos = anterior.data();
+        plano.width = width;
+        plano.height = height;
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        std::vector<int> esperado((size_t)width * height * caso.channels);
+        reducirReferencia(plano, esperado.data());
+        std::string camino = "piramide nivel " + std::to_string(k);
+        if (k >= piramide.getNumNiveles() || piramide.nivel(k).getWidth() != width ||
+            piramide.nivel(k).getHeight() != height) {
+            std::cout << "DIFERENCIA en " << camino << ": tamano" << std::endl;
+            describir(caso);
+            return false;
+        }
+        if (!reportarDiferencia(caso, camino.c_str(), esperado.data(), piramide.nivel(k).getPixels(),
+                                (long)esperado.size())) {
+            return false;
+        }
+        anterior.swap(esperado);
+    }
+    if (piramide.getNumNiveles() != k) {
+        std::cout << "DIFERENCIA en piramide: " << piramide.getNumNiveles() << " niveles, esperados " << k << std::endl;
+        describir(caso);
+        return false;
+    }
+
+    std::string prefijo = dir + "/verificar_piramide";
+    Piramide cargada;
+    if (!piramide.guardar(prefijo) || !cargada.cargar(original, prefijo)) {
+        std::cout << "ERROR de E/S en la piramide guardada" << std::endl;
+        describir(caso);
+        return false;
+    }
+    bool ok = true;
+    for (int n = 1; n < piramide.getNumNiveles(); n++) {
+        const Imagen& nivel = piramide.nivel(n);
+        std::string ruta = prefijo + "_" + std::to_string(n) + (caso.channels == 3 ? ".ppm" : ".pgm");
+        remove(ruta.c_str());
+        if (ok) ok = reportarDiferencia(caso, "piramide cargada", nivel.getPixels(), cargada.nivel(n).getPixels(),
+                                        nivel.getPixelCount());
+    }
+    return ok;
+}
+
+// Borra un directorio sin subdirectorios
+static void borrarDirectorio(const std::string& ruta) {
+    DIR* dir = opendir(ruta.c_str());
+    if (dir == NULL) return;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strcmp(ent->d_name, ".") != 0 && strcmp(ent->d_name, "..") != 0) {
+            unlink((ruta + "/" + ent->d_name).c_str());
+        }
+    }
+    closedir(dir);
+    rmdir(ruta.c_str());
+}
+
+static bool fallaCache(const Caso& caso, const char* que) {
+    std::cout << "DIFERENCIA en cache de resultados: " << que << std::endl;
+    describir(caso);
+    return false;
+}
+
+// Un fallo, un acierto con la salida de referencia, una entrada alterada en
+// el lugar que servir() tiene que descartar y la expulsion de la entrada de
+// uso mas viejo al pasar del limite
+static bool verificarCache(const Caso& caso, const Imagen& original, const int* esperado, const std::string& dir) {
+    std::string dir_cache = dir + "/verificar_cache_" + std::to_string(getpid());
+    borrarDirectorio(dir_cache);
+    std::string entrada = dir + "/verificar_cache_entrada.pnm";
+    std::string salida = dir + "/verificar_cache_salida.pnm";
+    std::string servida = dir + "/verificar_cache_servida.pnm";
+    const char* binario = caso.channels == 3 ? "P6" : "P5";
+
+    Imagen imagen, filtrada;
+    imagen.copiarDesde(original);
+    imagen.setMetadata(binario, caso.width, caso.height, caso.max_color, caso.channels);
+    filtrada.copiarDesde(imagen);
+    std::copy(esperado, esperado + original.getPixelCount(), filtrada.getPixelsEscritura());
+    bool ok = imagen.guardarEnArchivo(entrada.c_str()) && filtrada.guardarEnArchivo(salida.c_str());
+    if (!ok) {
+        std::cout << "ERROR de E/S en la cache de resultados" << std::endl;
+        return false;
+    }
+
+    {
+        CacheResultados cache(dir_cache.c_str());
+        uint64_t clave;
+        Imagen leida;
+        if (!cache.calcularClave(entrada.c_str(), caso.filtro, clave)) ok = fallaCache(caso, "clave");
+        if (ok && cache.servir(clave, servida.c_str())) ok = fallaCache(caso, "acierto sin entrada");
+        if (ok && !cache.guardar(clave, salida.c_str())) ok = fallaCache(caso, "guardar");
+        if (ok && (!cache.servir(clave, servida.c_str()) || !leida.cargarDesdeArchivo(servida.c_str()))) {
+            ok = fallaCache(caso, "fallo con entrada");
+        }
+        if (ok) ok = reportarDiferencia(caso, "cache de resultados", esperado, leida.getPixels(), original.getPixelCount());
+
+        // La servida es un enlace a la entrada: alterar su ultimo byte altera la entrada
+        FILE* file = ok ? fopen(servida.c_str(), "r+b") : NULL;
+        if (file != NULL) {
+            fseek(file, -1, SEEK_END);
+            int c = fgetc(file);
+            fseek(file, -1, SEEK_END);
+            fputc(c ^ 1, file);
+            fclose(file);
+            if (cache.servir(clave, servida.c_str())) ok = fallaCache(caso, "acierto con la entrada alterada");
+            if (ok && cache.servir(clave, servida.c_str())) ok = fallaCache(caso, "la entrada alterada no se borro");
+        }
+        EstadisticasCache e = cache.leerEstadisticas();
+        if (ok && (e.aciertos != 1 || e.fallos != 3 || e.entradas != 0)) ok = fallaCache(caso, "contadores");
+    }
+
+    // Tres entradas del mismo tamano con fechas de uso distintas, la primera
+    // usada de nuevo; la cuarta tiene que expulsar a la segunda
+    struct stat info;
+    if (ok && stat(salida.c_str(), &info) == 0) {
+        uint64_t bytes = (uint64_t)info.st_size;
+        CacheResultados cache(dir_cache.c_str(), 3 * bytes + bytes / 2);
+        uint64_t claves[4];
+        for (int i = 0; ok && i < 4; i++) {
+            // Cada entrada con su propio archivo: guardar la enlaza a la salida
+            ok = cache.calcularClave(entrada.c_str(), "lru" + std::to_string(i), claves[i]) &&
+                 filtrada.guardarEnArchivo(salida.c_str());
+            if (ok && i == 3 && !cache.servir(claves[0], servida.c_str())) ok = fallaCache(caso, "fallo antes de expulsar");
+            if (ok && !cache.guardar(claves[i], salida.c_str())) ok = fallaCache(caso, "guardar");
+            if (ok && i < 3) {
+                struct timespec fechas[2];
+                fechas[0].tv_sec = fechas[1].tv_sec = time(NULL) - 1000 + i;
+                fechas[0].tv_nsec = fechas[1].tv_nsec = 0;
+                utimensat(AT_FDCWD, salida.c_str(), fechas, 0);
+            }
+        }
+        for (int i = 0; ok && i < 4; i++) {
+            if (cache.servir(claves[i], servida.c_str()) != (i != 1)) ok = fallaCache(caso, "expulsion");
+        }
+        if (ok && cache.leerEstadisticas().expulsiones != 1) ok = fallaCache(caso, "contador de expulsiones");
+    }
+
+    remove(entrada.c_str());
+    remove(salida.c_str());
+    remove(servida.c_str());
+    borrarDirectorio(dir_cache);
+    return ok;
+}
+
+// filtro_servidor lanzado por verificar, con el socket en el directorio temporal
+struct ServidorPrueba {
+    pid_t pid;
+    int sock;
+    std::string ruta;
+};
+
+static bool iniciarServidor(const std::string& ejecutable, const std::string& dir, int hilos, ServidorPrueba& servidor) {
+    servidor.ruta = dir + "/verificar_servidor_" + std::to_string(getpid()) + ".sock";
+    servidor.sock = -1;
+    std::string texto_hilos = std::to_string(hilos);
+    const char* args[] = {ejecutable.c_str(), "--threads", texto_hilos.c_str(), "--socket", servidor.ruta.c_str(), NULL};
+    posix_spawn_file_actions_t acciones;
+    posix_spawn_file_actions_init(&acciones);
+    posix_spawn_file_actions_addopen(&acciones, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    int rc = posix_spawn(&servidor.pid, ejecutable.c_str(), &acciones, NULL, (char* const*)args, environ);
+    posix_spawn_file_actions_destroy(&acciones);
+    if (rc != 0) {
+        std::cout << "ERROR al lanzar " << ejecutable << ": " << strerror(rc) << std::endl;
+        return false;
+    }
+    // Hasta 5 s para que escuche
+    for (int i = 0; i < 500 && servidor.sock < 0; i++) {
+        usleep(10000);
+        servidor.sock = conectarServidor(servidor.ruta.c_str());
+    }
+    if (servidor.sock < 0) {
+        std::cout << "ERROR: filtro_servidor no escucha en " << servidor.ruta << std::endl;
+        kill(servidor.pid, SIGTERM);
+        waitpid(servidor.pid, NULL, 0);
+        return false;
+    }
+    return true;
+}
+
+static bool terminarServidor(ServidorPrueba& servidor) {
+    PeticionServidor peticion = nuevaPeticion(OP_TERMINAR);
+    RespuestaServidor respuesta;
+    int fds[2];
+    int num_fds;
+    bool ok = enviarMensaje(servidor.sock, &peticion, sizeof(peticion), NULL, 0) &&
+              recibirMensaje(servidor.sock, &respuesta, sizeof(respuesta), fds, num_fds) && respuesta.ok;
+    close(servidor.sock);
+    int estado = 0;
+    ok = waitpid(servidor.pid, &estado, 0) == servidor.pid && WIFEXITED(estado) && WEXITSTATUS(estado) == 0 && ok;
+    if (!ok) std::cout << "ERROR al terminar filtro_servidor" << std::endl;
+    return ok;
+}
+
+// Una peticion con la imagen del caso; sellada == false manda la entrada sin
+// F_SEAL_WRITE. Devuelve si el servidor la acepto y deja la salida.
+static bool pedirAlServidor(int sock, const Caso& caso, const Imagen& original, const std::string& cadena,
+                            bool sellada, std::vector<int>& salida, std::string& mensaje) {
+    size_t bytes = bytesBufferCompartido(caso.width, caso.height, caso.channels);
+    int fds[2] = {-1, -1};
+    int* escritura = (int*)crearBufferCompartido(bytes, fds[0]);
+    int* resultado = escritura != nullptr ? (int*)crearBufferCompartido(bytes, fds[1]) : nullptr;
+    const void* entrada = nullptr;
+    if (resultado != nullptr) {
+        std::copy(original.getPixels(), original.getPixels() + original.getPixelCount(), escritura);
+        entrada = sellada ? sellarEntrada(fds[0], escritura, bytes) : escritura;
+    } else if (escritura != nullptr) {
+        munmap(escritura, bytes);
+    }
+
+    bool ok = false;
+    mensaje = "error de E/S";
+    if (entrada != nullptr) {
+        PeticionServidor peticion = nuevaPeticion(OP_FILTRAR);
+        peticion.width = caso.width;
+        peticion.height = caso.height;
+        peticion.channels = caso.channels;
+        peticion.max_color = caso.max_color;
+        peticion.iteraciones = 1;
+        strncpy(peticion.filtros, cadena.c_str(), MAX_CADENA_SERVIDOR - 1);
+        RespuestaServidor respuesta;
+        int recibidos[2];
+        int num_recibidos;
+        if (enviarMensaje(sock, &peticion, sizeof(peticion), fds, 2) &&
+            recibirMensaje(sock, &respuesta, sizeof(respuesta), recibidos, num_recibidos)) {
+            ok = respuesta.ok != 0;
+            mensaje = respuesta.mensaje;
+            if (ok) salida.assign(resultado, resultado + original.getPixelCount());
+        }
+        munmap((void*)entrada, bytes);
+    }
+    if (resultado != nullptr) munmap(resultado, bytes);
+    for (int i = 0; i < 2; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+    return ok;
+}
+
+// El filtro del caso y la cadena de pasos por el servidor contra la
+// referencia, y una entrada sin sellar que el servidor tiene que rechazar
+static bool verificarServidor(const Caso& caso, int sock, const Imagen& original, const int* esperado,
+                              const int* esperado_pasos) {
+    std::string cadena;
+    for (size_t i = 0; i < caso.pasos.size(); i++) cadena += (i > 0 ? "," : "") + caso.pasos[i];
+    std::vector<int> salida;
+    std::string mensaje;
+    for (int e = 0; e < 2; e++) {
+        const char* camino = e == 0 ? "servidor" : "servidor cadena";
+        if (!pedirAlServidor(sock, caso, original, e == 0 ? caso.filtro : cadena, true, salida, mensaje)) {
+            std::cout << "ERROR en " << camino << ": " << mensaje << std::endl;
+            describir(caso);
+            return false;
+        }
+        if (!reportarDiferencia(caso, camino, e == 0 ? esperado : esperado_pasos, salida.data(),
+                                original.getPixelCount())) {
+            return false;
+        }
+    }
+    if (pedirAlServidor(sock, caso, original, caso.filtro, false, salida, mensaje)) {
+        std::cout << "DIFERENCIA en servidor: acepto una entrada sin F_SEAL_WRITE" << std::endl;
+        describir(caso);
+        return false;
+    }
+    return true;
+}
+
+// Una imagen P5 de mas de INT_MAX muestras por filtro_streaming, con la salida
+// por un pipe. El archivo es disperso: solo las primeras y las ultimas filas
+// tienen datos, y esas filas de la salida se comparan contra la referencia
+// aplicada a un recorte con las mismas filas en cero al lado. Corre en
+// segundo plano mientras se verifican los casos.
+struct StreamingPrueba {
+    pid_t pid;
+    int tubo;
+    pthread_t hilo;
+    bool con_hilo;
+    unsigned int semilla;
+    std::string entrada;
+    std::string encabezado;
+    std::vector<unsigned char> arriba, abajo;  // entrada de cada punta
+    // Lo que devolvio filtro_streaming: del medio solo se cuentan los bytes
+    std::string leido_encabezado;
+    std::vector<unsigned char> salida_arriba, salida_abajo;
+    long recibidos;
+};
+
+#define ANCHO_STREAMING 4096
+#define ALTO_STREAMING (INT_MAX / ANCHO_STREAMING + 2)
+#define FILAS_STREAMING 16  // con datos en cada punta; mas que la suma de radios
+#define CADENA_STREAMING "blur"
+
+static void* leerSalidaStreaming(void* arg) {
+    StreamingPrueba& prueba = *(StreamingPrueba*)arg;
+    size_t puntas = (size_t)FILAS_STREAMING * ANCHO_STREAMING;
+    std::vector<unsigned char> bloque(1 << 20);
+    ssize_t n;
+    while ((n = read(prueba.tubo, bloque.data(), bloque.size())) > 0) {
+        const unsigned char* p = bloque.data();
+        size_t resto = (size_t)n;
+        while (resto > 0 && prueba.leido_encabezado.size() < prueba.encabezado.size()) {
+            prueba.leido_encabezado += (char)*p++;
+            resto--;
+        }
+        size_t primeras = std::min(resto, puntas - prueba.salida_arriba.size());
+        prueba.salida_arriba.insert(prueba.salida_arriba.end(), p, p + primeras);
+        // Las ultimas `puntas` recibidas
+        std::vector<unsigned char>& ultimas = prueba.salida_abajo;
+        ultimas.insert(ultimas.end(), p, p + resto);
+        if (ultimas.size() > puntas) ultimas.erase(ultimas.begin(), ultimas.end() - puntas);
+        prueba.recibidos += (long)resto;
+    }
+    return NULL;
+}
+
+static bool iniciarStreamingGrande(const std::string& ejecutable, const std::string& dir, unsigned int semilla,
+                                   StreamingPrueba& prueba) {
+    size_t puntas = (size_t)FILAS_STREAMING * ANCHO_STREAMING;
+    prueba.pid = -1;
+    prueba.tubo = -1;
+    prueba.con_hilo = false;
+    prueba.semilla = semilla;
+    prueba.recibidos = 0;
+    std::mt19937 rng(semilla);
+    prueba.arriba.resize(puntas);
+    prueba.abajo.resize(puntas);
+    for (size_t i = 0; i < puntas; i++) {
+        prueba.arriba[i] = (unsigned char)rng();
+        prueba.abajo[i] = (unsigned char)rng();
+    }
+
+    prueba.entrada = dir + "/verificar_streaming_" + std::to_string(getpid()) + ".pgm";
+    prueba.encabezado = "P5\n" + std::to_string(ANCHO_STREAMING) + " " + std::to_string(ALTO_STREAMING) + "\n255\n";
+    const std::string& encabezado = prueba.encabezado;
+    off_t datos = (off_t)encabezado.size();
+    off_t total = (off_t)ANCHO_STREAMING * ALTO_STREAMING;
+    int fd = open(prueba.entrada.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0 && pwrite(fd, encabezado.data(), encabezado.size(), 0) == (ssize_t)encabezado.size() &&
+              pwrite(fd, prueba.arriba.data(), puntas, datos) == (ssize_t)puntas &&
+              pwrite(fd, prueba.abajo.data(), puntas, datos + total - (off_t)puntas) == (ssize_t)puntas;
+    if (fd >= 0) close(fd);
+    int tubo[2];
+    if (!ok || pipe(tubo) != 0) {
+        std::cout << "ERROR al crear " << prueba.entrada << std::endl;
+        remove(prueba.entrada.c_str());
+        return false;
+    }
+
+    const char* args[] = {ejecutable.c_str(), prueba.entrada.c_str(), "/dev/stdout", CADENA_STREAMING, NULL};
+    posix_spawn_file_actions_t acciones;
+    posix_spawn_file_actions_init(&acciones);
+    posix_spawn_file_actions_adddup2(&acciones, tubo[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&acciones, tubo[0]);
+    posix_spawn_file_actions_addclose(&acciones, tubo[1]);
+    int rc = posix_spawn(&prueba.pid, ejecutable.c_str(), &acciones, NULL, (char* const*)args, environ);
+    posix_spawn_file_actions_destroy(&acciones);
+    close(tubo[1]);
+    prueba.tubo = tubo[0];
+    if (rc != 0) {
+        std::cout << "ERROR al lanzar " << ejecutable << ": " << strerror(rc) << std::endl;
+        prueba.pid = -1;
+    } else {
+        prueba.con_hilo = pthread_create(&prueba.hilo, NULL, leerSalidaStreaming, &prueba) == 0;
+        // Sin hilo se lee aca, sin solaparse con los casos
+        if (!prueba.con_hilo) leerSalidaStreaming(&prueba);
+    }
+    return rc == 0;
+}
+
+// Espera a filtro_streaming y compara su salida; con cancelar solo lo detiene
+static bool terminarStreamingGrande(StreamingPrueba& prueba, bool cancelar) {
+    if (cancelar && prueba.pid > 0) kill(prueba.pid, SIGTERM);
+    if (prueba.con_hilo) pthread_join(prueba.hilo, NULL);
+    if (prueba.tubo >= 0) close(prueba.tubo);
+    int estado = 0;
+    bool termino = prueba.pid > 0 && waitpid(prueba.pid, &estado, 0) == prueba.pid && WIFEXITED(estado) &&
+                   WEXITSTATUS(estado) == 0;
+    remove(prueba.entrada.c_str());
+    if (cancelar) return false;
+
+    size_t puntas = (size_t)FILAS_STREAMING * ANCHO_STREAMING;
+    long total = (long)ANCHO_STREAMING * ALTO_STREAMING;
+    if (!termino || prueba.leido_encabezado != prueba.encabezado || prueba.recibidos != total) {
+        std::cout << "ERROR en filtro_streaming " << ANCHO_STREAMING << "x" << ALTO_STREAMING << ": "
+                  << (termino ? "salida incompleta" : "termino con error") << " (" << prueba.recibidos << " de "
+                  << total << " bytes)" << std::endl;
+        if (prueba.leido_encabezado != prueba.encabezado) std::cout << "  " << prueba.leido_encabezado << std::endl;
+        return false;
+    }
+
+    std::vector<Filtro> pasos;
+    parsearCadenaFiltros(CADENA_STREAMING, pasos);
+    for (int punta = 0; punta < 2; punta++) {
+        // La punta con FILAS_STREAMING filas en cero del lado del medio
+        std::vector<int> recorte(2 * puntas, 0), temporal(recorte.size());
+        const std::vector<unsigned char>& origen = punta == 0 ? prueba.arriba : prueba.abajo;
+        size_t desplazamiento = punta == 0 ? 0 : puntas;
+        for (size_t i = 0; i < puntas; i++) recorte[desplazamiento + i] = origen[i];
+        Plano plano;
+        plano.width = ANCHO_STREAMING;
+        plano.height = 2 * FILAS_STREAMING;
+        plano.channels = 1;
+        plano.max_color = 255;
+        for (size_t i = 0; i < pasos.size(); i++) {
+            plano.datos = recorte.data();
+            filtrarReferencia(pasos[i], plano, temporal.data());
+            recorte.swap(temporal);
+        }
+
+        const std::vector<unsigned char>& salida = punta == 0 ? prueba.salida_arriba : prueba.salida_abajo;
+        std::vector<int> obtenido(salida.begin(), salida.end());
+        long indice = compararMuestras(recorte.data() + desplazamiento, obtenido.data(), (long)puntas);
+        if (indice >= 0) {
+            long fila = (punta == 0 ? 0 : ALTO_STREAMING - FILAS_STREAMING) + indice / ANCHO_STREAMING;
+            std::cout << "DIFERENCIA en filtro_streaming " << ANCHO_STREAMING << "x" << ALTO_STREAMING << " "
+                      << CADENA_STREAMING << ": fila " << fila << " columna " << indice % ANCHO_STREAMING
+                      << " esperado=" << recorte[desplazamiento + indice] << " obtenido=" << obtenido[indice]
+                      << " semilla=" << prueba.semilla << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::vector<std::string> separar(const char* lista) {
+    std::vector<std::string> partes;
+    std::string actual;
+    for (const char* p = lista; ; p++) {
+        if (*p == ',' || *p == '\0') {
+            if (!actual.empty()) partes.push_back(actual);
+            actual.clear();
+            if (*p == '\0') break;
+        } else if (*p != ' ') {
+            actual += *p;
+        }
+    }
+    return partes;
+}
+
+int main(int argc, char* argv[]) {
+    int casos = 200;
+    unsigned int semilla = 1;
+    int max_threads = 5;
+    const char* lista_backends = backendsDisponibles();
+    // Ademas de los filtros por defecto, ventanas de rango mas grandes: 5x5
+    // (red de ordenamiento) y de 7x7 en adelante (histogramas)
+    std::string filtros_por_defecto = std::string(listaFiltros()) + ", median5, median7, median15, min5, max9, erode21";
+    const char* lista_filtros = filtros_por_defecto.c_str();
+    const char* dir = getenv("TMPDIR");
+    std::string dir_temporal = (dir != nullptr && dir[0] != '\0') ? dir : "/tmp";
+    // Por defecto filtro_servidor y filtro_streaming del mismo directorio que
+    // verificar
+    std::string dir_ejecutables = argv[0];
+    size_t barra = dir_ejecutables.find_last_of('/');
+    dir_ejecutables = barra == std::string::npos ? std::string(".") : dir_ejecutables.substr(0, barra);
+    std::string ejecutable_servidor = dir_ejecutables + "/filtro_servidor";
+    std::string ejecutable_streaming = dir_ejecutables + "/filtro_streaming";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--casos") == 0 && i + 1 < argc) {
+            casos = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--semilla") == 0 && i + 1 < argc) {
+            semilla = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--backends") == 0 && i + 1 < argc) {
+            lista_backends = argv[++i];
+        } else if (strcmp(argv[i], "--filtros") == 0 && i + 1 < argc) {
+            lista_filtros = argv[++i];
+        } else if (strcmp(argv[i], "--servidor") == 0 && i + 1 < argc) {
+            ejecutable_servidor = argv[++i];
+        } else if (strcmp(argv[i], "--streaming") == 0 && i + 1 < argc) {
+            ejecutable_streaming = argv[++i];
+        } else {
+            std::cout << "Uso: " << argv[0] << " [--casos N] [--semilla S] [--threads N]"
+                      << " [--backends a,b] [--filtros a,b] [--servidor <filtro_servidor>]"
+                      << " [--streaming <filtro_streaming>]" << std::endl;
+            std::cout << "Backends: " << backendsDisponibles() << std::endl;
+            return 1;
+        }
+    }
+    if (max_threads < 1) max_threads = 1;
+
+    std::vector<std::string> filtros = separar(lista_filtros);
+    std::vector<std::string> nombres = separar(lista_backends);
+    std::vector<Backend*> backends;
+    bool raiz = true;
+    for (size_t i = 0; i < nombres.size(); i++) {
+        Backend* backend = crearBackend(nombres[i].c_str(), max_threads);
+        if (backend == nullptr) {
+            std::cout << "Unknown backend: " << nombres[i] << std::endl;
+            return 1;
+        }
+        // Solo el backend MPI inicializa algo; con mpirun todos los ranks
+        // generan los mismos casos y solo el raiz compara. Estas instancias
+        // quedan para el consenso y para finalizar al terminar
+        if (!backend->inicializar(&argc, &argv)) return 1;
+        raiz = raiz && backend->esRaiz();
+        backends.push_back(backend);
+    }
+
+    ServidorPrueba servidor;
+    bool ok = true;
+    if (raiz) ok = iniciarServidor(ejecutable_servidor, dir_temporal, max_threads, servidor);
+    bool con_servidor = raiz && ok;
+    StreamingPrueba streaming;
+    if (ok && raiz) ok = iniciarStreamingGrande(ejecutable_streaming, dir_temporal, semilla, streaming);
+    bool con_streaming = raiz && ok;
+    for (size_t b = 0; b < backends.size(); b++) ok = backends[b]->consenso(ok);
+    for (int c = 0; ok && c < casos; c++) {
+        Caso caso = generarCaso(semilla + c, filtros);
+        Filtro filtro;
+        if (!buscarFiltro(caso.filtro.c_str(), filtro)) {
+            std::cout << "Unknown filter: " << caso.filtro << std::endl;
+            ok = false;
+            break;
+        }
+
+        Imagen original;
+        llenarImagen(caso, original);
+        std::vector<int> esperado(original.getPixelCount() > 0 ? original.getPixelCount() : 1);
+        EstadisticasImagen estadisticas_filtro;
+        filtrarReferencia(filtro, original.getPlano(), esperado.data(), &estadisticas_filtro);
+
+        // La cadena de pasos, aplicada paso a paso con la referencia
+        std::vector<Filtro> pasos(caso.pasos.size());
+        for (size_t i = 0; i < pasos.size(); i++) buscarFiltro(caso.pasos[i].c_str(), pasos[i]);
+        std::vector<int> esperado_pasos(original.getPixels(), original.getPixels() + original.getPixelCount());
+        std::vector<int> temporal(esperado_pasos.size());
+        EstadisticasImagen estadisticas_pasos;  // solo las del ultimo paso
+        for (size_t i = 0; i < pasos.size(); i++) {
+            Plano plano = original.getPlano();
+            plano.datos = esperado_pasos.data();
+            filtrarReferencia(pasos[i], plano, temporal.data(), i + 1 == pasos.size() ? &estadisticas_pasos : nullptr);
+            esperado_pasos.swap(temporal);
+        }
+
+        if (raiz) {
+            ok = verificarFiltrarFilas(caso, filtro, original, esperado.data()) &&
+                 verificarIdaVuelta(caso, original, dir_temporal) &&
+                 verificarRegiones(caso, original, dir_temporal) &&
+                 verificarIncremental(caso, filtro, original, esperado.data()) &&
+                 verificarPiramide(caso, original, dir_temporal) &&
+                 verificarCache(caso, original, esperado.data(), dir_temporal) &&
+                 verificarServidor(caso, servidor.sock, original, esperado.data(), esperado_pasos.data());
+        }
+
+        // Cada caso usa otra cantidad de hilos; los backends del caso se
+        // crean aparte porque el MPI ya quedo inicializado arriba
+        int hilos = 1 + c % max_threads;
+        // y otro ajuste de bloqueo temporal, como los que elige --autotune
+        static const int altos[] = {16, 32, 128, 256};
+        static const int anchos[] = {32, 64, 512, 1 << 20};
+        AjusteFiltros ajuste = {1 + c % 9, altos[c % 4], anchos[(c / 4) % 4]};
+        configurarAjusteFiltros(ajuste);
+        for (size_t b = 0; b < nombres.size(); b++) {
+            Backend* backend = crearBackend(nombres[b].c_str(), hilos);
+            backend->inicializar(&argc, &argv);
+            // Los backends de un solo proceso corren solo en el raiz
+            bool participa = raiz || backend->getNumProcesos() > 1;
+            if (participa) {
+                Imagen imagen;
+                imagen.copiarDesde(original);
+                ok = backend->consenso(ok) && backend->aplicar(imagen, filtro);
+                if (ok && backend->esRaiz()) {
+                    std::string camino = std::string(backend->nombre()) + " hilos=" + std::to_string(hilos);
+                    ok = reportarDiferencia(caso, camino.c_str(), esperado.data(), imagen.getPixels(),
+                                            original.getPixelCount());
+                }
+
+                Imagen iterada;
+                iterada.copiarDesde(original);
+                ok = backend->consenso(ok) && backend->aplicarPasos(iterada, pasos);
+                if (ok && backend->esRaiz()) {
+                    std::string camino = std::string(backend->nombre()) + " aplicarPasos hilos=" + std::to_string(hilos);
+                    ok = reportarDiferencia(caso, camino.c_str(), esperado_pasos.data(), iterada.getPixels(),
+                                            original.getPixelCount());
+                }
+
+                // Con estadisticas: un paso solo y la cadena, donde solo
+                // cuenta la pasada final
+                for (int e = 0; e < 2; e++) {
+                    const std::vector<Filtro> un_paso(1, filtro);
+                    const std::vector<Filtro>& cadena = e == 0 ? un_paso : pasos;
+                    Imagen con_estadisticas;
+                    con_estadisticas.copiarDesde(original);
+                    ok = backend->consenso(ok);
+                    EstadisticasImagen obtenidas;
+                    if (ok) ok = backend->aplicarPasos(con_estadisticas, cadena, &obtenidas);
+                    ok = backend->consenso(ok);
+                    if (ok) backend->reducirEstadisticas(obtenidas);
+                    if (ok && backend->esRaiz()) {
+                        std::string camino = std::string(backend->nombre()) + " estadisticas " +
+                                             (e == 0 ? "un paso" : "aplicarPasos") + " hilos=" + std::to_string(hilos);
+                        const int* salida = e == 0 ? esperado.data() : esperado_pasos.data();
+                        ok = reportarDiferencia(caso, camino.c_str(), salida, con_estadisticas.getPixels(),
+                                                original.getPixelCount()) &&
+                             reportarEstadisticas(caso, camino.c_str(), e == 0 ? estadisticas_filtro : estadisticas_pasos,
+                                                  salida, original.getPixelCount(), obtenidas);
+                    }
+                }
+            }
+            delete backend;
+        }
+        for (size_t b = 0; b < backends.size(); b++) ok = backends[b]->consenso(ok);
+    }
+
+    if (con_servidor && !terminarServidor(servidor)) ok = false;
+    if (con_streaming && !terminarStreamingGrande(streaming, !ok)) ok = false;
+    if (ok && raiz) {
+        std::cout << casos << " casos verificados (semilla " << semilla << ", backends: " << lista_backends
+                  << ")" << std::endl;
+    }
+    for (size_t b = 0; b < backends.size(); b++) {
+        backends[b]->finalizar();
+        delete backends[b];
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+#include "afinidad.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+
+#ifdef FILTRO_CON_NUMA
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+#include "pool_buffers.h"
+
+// Los buffers hasta este tamano salen de arenas compartidas
+#define BYTES_MIN_COLOCAR (POOL_TAM_MINIMO << (POOL_CLASES_PEQUENAS - 1))
+
+static ConfigAfinidad config_afinidad = {false, MEMORIA_SISTEMA, 0, 1};
+static pthread_once_t topologia_detectada = PTHREAD_ONCE_INIT;
+static std::vector<int> cpus_ordenadas;  // CPUs permitidas, ordenadas por nodo
+
+static void detectarTopologia() {
+    cpu_set_t permitidas;
+    CPU_ZERO(&permitidas);
+    if (sched_getaffinity(0, sizeof(permitidas), &permitidas) != 0) {
+        long en_linea = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long cpu = 0; cpu < en_linea && cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &permitidas);
+    }
+    std::vector<std::pair<int, int> > por_nodo;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &permitidas)) por_nodo.push_back(std::make_pair(nodoDeCPU(cpu), cpu));
+    }
+    std::sort(por_nodo.begin(), por_nodo.end());
+    for (size_t i = 0; i < por_nodo.size(); i++) cpus_ordenadas.push_back(por_nodo[i].second);
+    if (cpus_ordenadas.empty()) cpus_ordenadas.push_back(0);
+}
+
+bool parsearPoliticaMemoria(const char* texto, ConfigAfinidad& config) {
+    if (strcmp(texto, "local") == 0) {
+        config.politica = MEMORIA_LOCAL;
+    } else if (strcmp(texto, "intercalar") == 0) {
+        config.politica = MEMORIA_INTERCALADA;
+    } else {
+        char* fin;
+        long nodo = strtol(texto, &fin, 10);
+        if (fin == texto || *fin != '\0' || nodo < 0) return false;
+        config.politica = MEMORIA_NODO;
+        config.nodo = (int)nodo;
+    }
+    return true;
+}
+
+void configurarAfinidad(const ConfigAfinidad& config) {
+    config_afinidad = config;
+    if (config_afinidad.num_threads < 1) config_afinidad.num_threads = 1;
+    // Antes de fijar ningun hilo, con la mascara del proceso
+    pthread_once(&topologia_detectada, detectarTopologia);
+}
+
+const ConfigAfinidad& getConfigAfinidad() {
+    return config_afinidad;
+}
+
+bool numaDisponible() {
+#ifdef FILTRO_CON_NUMA
+    return numa_available() >= 0;
+#else
+    return false;
+#endif
+}
+
+int numNodosNUMA() {
+#ifdef FILTRO_CON_NUMA
+    if (numaDisponible()) return numa_max_node() + 1;
+#endif
+    return 1;
+}
+
+int nodoDeCPU(int cpu) {
+#ifdef FILTRO_CON_NUMA
+    if (numaDisponible()) {
+        int nodo = numa_node_of_cpu(cpu);
+        if (nodo >= 0) return nodo;
+    }
+#endif
+    (void)cpu;
+    return 0;
+}
+
+int cpuParaHilo(int hilo, int total) {
+    pthread_once(&topologia_detectada, detectarTopologia);
+    long n = (long)cpus_ordenadas.size();
+    if (total < 1) total = 1;
+    // Reparto parejo: con mas hilos que CPUs, hilos vecinos comparten CPU
+    return cpus_ordenadas[(long)(hilo % total) * n / total];
+}
+
+FijacionHilo::FijacionHilo(int hilo, int total) : fijado(false) {
+    if (!config_afinidad.fijar_hilos) return;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(previa), &previa) != 0) return;
+    cpu_set_t mascara;
+    CPU_ZERO(&mascara);
+    CPU_SET(cpuParaHilo(hilo, total), &mascara);
+    fijado = pthread_setaffinity_np(pthread_self(), sizeof(mascara), &mascara) == 0;
+}
+
+FijacionHilo::~FijacionHilo() {
+    if (fijado) pthread_setaffinity_np(pthread_self(), sizeof(previa), &previa);
+}
+
+#ifdef FILTRO_CON_NUMA
+static bool mbindRango(char* desde, char* hasta, int modo, const unsigned long* mascara) {
+    long pagina = sysconf(_SC_PAGESIZE);
+    desde = (char*)((uintptr_t)desde / pagina * pagina);
+    if (hasta <= desde) return true;
+    unsigned long max_nodo = (unsigned long)numa_max_node() + 2;
+    return mbind(desde, hasta - desde, modo, mascara, max_nodo, MPOL_MF_MOVE) == 0;
+}
+#endif
+
+bool colocarEnNodo(void* datos, size_t bytes, int nodo) {
+#ifdef FILTRO_CON_NUMA
+    if (!numaDisponible() || nodo < 0 || nodo >= numNodosNUMA() || nodo >= (int)(8 * sizeof(unsigned long))) {
+        return false;
+    }
+    unsigned long mascara = 1UL << nodo;
+    return mbindRango((char*)datos, (char*)datos + bytes, MPOL_BIND, &mascara);
+#else
+    (void)datos;
+    (void)bytes;
+    (void)nodo;
+    return false;
+#endif
+}
+
+void colocarBuffer(int* datos, int filas, long row_count) {
+#ifdef FILTRO_CON_NUMA
+    const ConfigAfinidad& config = config_afinidad;
+    size_t bytes = (size_t)filas * row_count * sizeof(int);
+    int nodos = numNodosNUMA();
+    if (config.politica == MEMORIA_SISTEMA || nodos <= 1 || bytes <= BYTES_MIN_COLOCAR ||
+        nodos > (int)(8 * sizeof(unsigned long))) {
+        return;
+    }
+    char* inicio = (char*)datos;
+    char* fin = inicio + bytes;
+
+    if (config.politica == MEMORIA_INTERCALADA) {
+        unsigned long todos = nodos == (int)(8 * sizeof(unsigned long)) ? ~0UL : (1UL << nodos) - 1;
+        mbindRango(inicio, fin, MPOL_INTERLEAVE, &todos);
+    } else if (config.politica == MEMORIA_NODO) {
+        colocarEnNodo(datos, bytes, config.nodo);
+    } else {
+        // Franjas consecutivas del mismo nodo van en un solo mbind. La pagina
+        // que cae entre dos franjas queda en el nodo de la primera.
+        int total = config.num_threads;
+        long pagina = sysconf(_SC_PAGESIZE);
+        char* desde = inicio;
+        for (int h = 0; h < total;) {
+            int nodo = nodoDeCPU(cpuParaHilo(h, total));
+            int siguiente = h + 1;
+            while (siguiente < total && nodoDeCPU(cpuParaHilo(siguiente, total)) == nodo) siguiente++;
+            long fila_fin = (long)filas * siguiente / total;
+            char* hasta = siguiente == total ? fin
+                                             : (char*)(((uintptr_t)(inicio + fila_fin * row_count * sizeof(int)) +
+                                                        pagina - 1) / pagina * pagina);
+            unsigned long mascara = 1UL << nodo;
+            mbindRango(desde, std::min(hasta, fin), MPOL_PREFERRED, &mascara);
+            desde = hasta;
+            h = siguiente;
+        }
+    }
+#else
+    (void)datos;
+    (void)filas;
+    (void)row_count;
+#endif
+}
@@ -0,0 +1,75 @@
+#ifndef AFINIDAD_H
+#define AFINIDAD_H
+
+// Afinidad de hilos y ubicacion de buffers en maquinas NUMA.
+//
+// Los backends con hilos reparten la imagen en franjas de filas contiguas,
+// una por hilo. Con fijar_hilos, el hilo i de n se fija a una CPU tomada de
+// la lista de CPUs permitidas ordenada por nodo, asi que franjas vecinas caen
+// en el mismo nodo. La politica de memoria ubica las paginas de cada buffer
+// de pixeles grande al pedirlo (mbind con MPOL_MF_MOVE, que tambien mueve las
+// paginas de un buffer reusado del pool):
+//
+// - MEMORIA_LOCAL: cada franja en el nodo de la CPU del hilo que la filtra.
+// - MEMORIA_INTERCALADA: paginas repartidas entre todos los nodos.
+// - MEMORIA_NODO: todo en un nodo.
+//
+// Sin libnuma (FILTRO_CON_NUMA) o con un solo nodo, la politica no hace nada
+// y solo queda la fijacion de hilos.
+
+#include <cstddef>
+#include <sched.h>
+
+enum PoliticaMemoria {
+    MEMORIA_SISTEMA,  // la del kernel: primer toque
+    MEMORIA_LOCAL,
+    MEMORIA_INTERCALADA,
+    MEMORIA_NODO
+};
+
+struct ConfigAfinidad {
+    bool fijar_hilos;
+    PoliticaMemoria politica;
+    int nodo;         // para MEMORIA_NODO
+    int num_threads;  // franjas en que se reparten los buffers
+};
+
+// "local", "intercalar" o el numero de un nodo
+bool parsearPoliticaMemoria(const char* texto, ConfigAfinidad& config);
+
+// Global; por defecto no se fija ni se ubica nada
+void configurarAfinidad(const ConfigAfinidad& config);
+const ConfigAfinidad& getConfigAfinidad();
+
+// true si se compilo con libnuma y el kernel la soporta
+bool numaDisponible();
+int numNodosNUMA();
+int nodoDeCPU(int cpu);
+
+// CPU del hilo `hilo` de `total`
+int cpuParaHilo(int hilo, int total);
+
+// Fija el hilo actual mientras vive el objeto, si la configuracion lo pide,
+// y al destruirse restaura la mascara anterior
+class FijacionHilo {
+private:
+    cpu_set_t previa;
+    bool fijado;
+
+public:
+    FijacionHilo(int hilo, int total);
+    ~FijacionHilo();
+
+    FijacionHilo(const FijacionHilo&) = delete;
+    FijacionHilo& operator=(const FijacionHilo&) = delete;
+};
+
+// Ubica las paginas de un buffer de `filas` filas de `row_count` muestras
+// segun la politica configurada. Los buffers chicos del pool comparten
+// paginas con otros y se dejan como estan.
+void colocarBuffer(int* datos, int filas, long row_count);
+
+// Ubica [datos, datos + bytes) en un nodo, sin mirar la configuracion
+bool colocarEnNodo(void* datos, size_t bytes, int nodo);
+
+#endif
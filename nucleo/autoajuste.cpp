@@ -0,0 +1,238 @@
+#include "autoajuste.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "backend.h"
+#include "region.h"
+
+std::string claseImagen(int width, int height, int channels) {
+    double pixeles = (double)width * height;
+    int nivel = pixeles > 1 ? (int)(std::log2(pixeles) / 2) : 0;
+    return "c" + std::to_string(channels) + "_" + std::to_string(nivel);
+}
+
+std::string rutaPerfilPorDefecto() {
+    const char* explicita = getenv("FILTRO_PERFIL");
+    if (explicita != nullptr && explicita[0] != '\0') return explicita;
+
+    char host[256];
+    if (gethostname(host, sizeof(host)) != 0) strcpy(host, "local");
+    host[sizeof(host) - 1] = '\0';
+    const char* cache = getenv("XDG_CACHE_HOME");
+    std::string dir;
+    if (cache != nullptr && cache[0] != '\0') {
+        dir = cache;
+    } else {
+        const char* home = getenv("HOME");
+        dir = std::string(home != nullptr ? home : "/tmp") + "/.cache";
+    }
+    return dir + "/filtro/perfil_" + host;
+}
+
+bool PerfilHost::cargar(const std::string& ruta) {
+    std::ifstream archivo(ruta.c_str());
+    if (!archivo) return false;
+    std::string linea;
+    while (std::getline(archivo, linea)) {
+        if (linea.empty() || linea[0] == '#') continue;
+        std::istringstream campos(linea);
+        std::string clase;
+        ConfigAutoajuste config;
+        if (campos >> clase >> config.backend >> config.num_threads >> config.filtros.pasos_por_bloque >>
+            config.filtros.tesela_alto >> config.filtros.tesela_ancho >> config.segundos) {
+            entradas[clase] = config;
+        }
+    }
+    return true;
+}
+
+// mkdir -p del directorio que contiene a `ruta`
+static bool crearDirectorioPadre(const std::string& ruta) {
+    for (size_t barra = ruta.find('/', 1); barra != std::string::npos; barra = ruta.find('/', barra + 1)) {
+        std::string dir = ruta.substr(0, barra);
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            std::cout << "Error creating directory: " << dir << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PerfilHost::guardar(const std::string& ruta) const {
+    if (!crearDirectorioPadre(ruta)) return false;
+    std::string temporal = ruta + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream archivo(temporal.c_str());
+        if (!archivo) {
+            std::cout << "Error opening profile file: " << temporal << std::endl;
+            return false;
+        }
+        archivo << "# Perfil de filtro --autotune\n";
+        archivo << "# clase backend hilos pasos_por_bloque tesela_alto tesela_ancho segundos\n";
+        for (std::map<std::string, ConfigAutoajuste>::const_iterator it = entradas.begin(); it != entradas.end(); ++it) {
+            const ConfigAutoajuste& c = it->second;
+            archivo << it->first << " " << c.backend << " " << c.num_threads << " " << c.filtros.pasos_por_bloque
+                    << " " << c.filtros.tesela_alto << " " << c.filtros.tesela_ancho << " " << c.segundos << "\n";
+        }
+        if (!archivo.flush()) {
+            std::cout << "Error writing profile file: " << temporal << std::endl;
+            remove(temporal.c_str());
+            return false;
+        }
+    }
+    if (rename(temporal.c_str(), ruta.c_str()) != 0) {
+        std::cout << "Error writing profile file: " << ruta << std::endl;
+        remove(temporal.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PerfilHost::buscar(const std::string& clase, ConfigAutoajuste& config) const {
+    std::map<std::string, ConfigAutoajuste>::const_iterator exacta = entradas.find(clase);
+    if (exacta != entradas.end()) {
+        config = exacta->second;
+        return true;
+    }
+    size_t guion = clase.find('_');
+    std::string canales = clase.substr(0, guion + 1);
+    int nivel = atoi(clase.c_str() + guion + 1);
+    int mejor_distancia = -1;
+    for (std::map<std::string, ConfigAutoajuste>::const_iterator it = entradas.begin(); it != entradas.end(); ++it) {
+        if (it->first.compare(0, canales.size(), canales) != 0) continue;
+        int distancia = std::abs(atoi(it->first.c_str() + canales.size()) - nivel);
+        if (mejor_distancia < 0 || distancia < mejor_distancia) {
+            mejor_distancia = distancia;
+            config = it->second;
+        }
+    }
+    return mejor_distancia >= 0;
+}
+
+void PerfilHost::poner(const std::string& clase, const ConfigAutoajuste& config) {
+    entradas[clase] = config;
+}
+
+bool leerMuestra(const char* ruta, Imagen& muestra) {
+    LectorRegiones lector;
+    if (!lector.abrir(ruta)) return false;
+    const EncabezadoPNM& enc = lector.getEncabezado();
+    long filas = MUESTRAS_AUTOAJUSTE / enc.rowCount();
+    if (filas < 1) filas = 1;
+    if (filas > enc.height) filas = enc.height;
+    Region region = {0, (int)((enc.height - filas) / 2), enc.width, (int)filas};
+    return lector.leer(region, muestra);
+}
+
+static double segundosDesde(const struct timespec& inicio) {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (ahora.tv_sec - inicio.tv_sec) + (ahora.tv_nsec - inicio.tv_nsec) / 1e9;
+}
+
+// Mejor tiempo de REPETICIONES_AUTOAJUSTE corridas, despues de una de
+// calentamiento; la copia de la muestra no se mide
+static double medir(const char* nombre, int num_threads, const AjusteFiltros& ajuste, const Imagen& muestra,
+                    const std::vector<Filtro>& pasos, bool detalle) {
+    Backend* backend = crearBackend(nombre, num_threads);
+    if (backend == nullptr) return -1;
+    configurarAjusteFiltros(ajuste);
+
+    double mejor = -1;
+    Imagen copia;
+    for (int r = 0; r <= REPETICIONES_AUTOAJUSTE; r++) {
+        copia.copiarDesde(muestra);
+        struct timespec inicio;
+        clock_gettime(CLOCK_MONOTONIC, &inicio);
+        if (!backend->aplicarPasos(copia, pasos)) {
+            mejor = -1;
+            break;
+        }
+        double segundos = segundosDesde(inicio);
+        if (r > 0 && (mejor < 0 || segundos < mejor)) mejor = segundos;
+    }
+    delete backend;
+
+    if (detalle && mejor >= 0) {
+        std::cout << "  " << nombre << " hilos=" << num_threads << " pasos_por_bloque=" << ajuste.pasos_por_bloque
+                  << " tesela=" << ajuste.tesela_ancho << "x" << ajuste.tesela_alto << ": " << mejor << " s"
+                  << std::endl;
+    }
+    return mejor;
+}
+
+static void probar(ConfigAutoajuste& mejor, const char* nombre, int num_threads, const AjusteFiltros& ajuste,
+                   const Imagen& muestra, const std::vector<Filtro>& pasos, bool detalle) {
+    double segundos = medir(nombre, num_threads, ajuste, muestra, pasos, detalle);
+    if (segundos >= 0 && (mejor.segundos < 0 || segundos < mejor.segundos)) {
+        mejor.backend = nombre;
+        mejor.num_threads = num_threads;
+        mejor.filtros = ajuste;
+        mejor.segundos = segundos;
+    }
+}
+
+// Busqueda por coordenadas: primero backend e hilos con el ajuste por
+// defecto, despues los pasos por bloque y por ultimo las teselas. El bloqueo
+// temporal solo cambia algo con mas de un paso.
+bool autoajustar(const Imagen& muestra, const std::vector<Filtro>& pasos, int max_threads,
+                 ConfigAutoajuste& mejor, bool detalle) {
+    if (max_threads < 1) max_threads = 1;
+    AjusteFiltros por_defecto = {BLOQUE_TEMPORAL_PASOS, TESELA_TEMPORAL_ALTO, TESELA_TEMPORAL_ANCHO};
+    mejor.segundos = -1;
+
+    std::vector<int> hilos;
+    for (int n = 2; n < max_threads; n *= 2) hilos.push_back(n);
+    if (max_threads > 1) hilos.push_back(max_threads);
+
+    probar(mejor, "serial", 1, por_defecto, muestra, pasos, detalle);
+    const char* paralelos[] = {"pthreads", "openmp"};
+    for (size_t b = 0; b < sizeof(paralelos) / sizeof(paralelos[0]); b++) {
+        for (size_t i = 0; i < hilos.size(); i++) {
+            probar(mejor, paralelos[b], hilos[i], por_defecto, muestra, pasos, detalle);
+        }
+    }
+    if (mejor.segundos < 0) {
+        configurarAjusteFiltros(por_defecto);
+        std::cout << "Autotune failed: no backend could filter the sample" << std::endl;
+        return false;
+    }
+
+    if (pasos.size() > 1) {
+        std::string backend = mejor.backend;
+        int num_threads = mejor.num_threads;
+        const int candidatos_pasos[] = {1, 2, 4, 8, 16};
+        for (size_t i = 0; i < sizeof(candidatos_pasos) / sizeof(candidatos_pasos[0]); i++) {
+            if (candidatos_pasos[i] == por_defecto.pasos_por_bloque) continue;
+            if (candidatos_pasos[i] > (int)pasos.size() && candidatos_pasos[i] > 1) break;
+            AjusteFiltros ajuste = por_defecto;
+            ajuste.pasos_por_bloque = candidatos_pasos[i];
+            probar(mejor, backend.c_str(), num_threads, ajuste, muestra, pasos, detalle);
+        }
+
+        // Sin bloque temporal las teselas no se usan
+        if (mejor.filtros.pasos_por_bloque > 1) {
+            const int candidatos_teselas[][2] = {{32, 256}, {64, 512}, {128, 1024}, {256, 512}, {64, 1 << 20}};
+            AjusteFiltros base = mejor.filtros;
+            for (size_t i = 0; i < sizeof(candidatos_teselas) / sizeof(candidatos_teselas[0]); i++) {
+                AjusteFiltros ajuste = base;
+                ajuste.tesela_alto = candidatos_teselas[i][0];
+                ajuste.tesela_ancho = candidatos_teselas[i][1];
+                probar(mejor, backend.c_str(), num_threads, ajuste, muestra, pasos, detalle);
+            }
+        }
+    }
+
+    configurarAjusteFiltros(mejor.filtros);
+    return true;
+}
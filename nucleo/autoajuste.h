@@ -0,0 +1,74 @@
+#ifndef AUTOAJUSTE_H
+#define AUTOAJUSTE_H
+
+// Autoajuste (--autotune): mide configuraciones candidatas sobre una muestra
+// de la imagen y guarda la ganadora en un perfil por host, que las corridas
+// siguientes cargan solas.
+//
+// Se ajustan el backend (serial, pthreads, openmp), los hilos, los pasos por
+// bloque temporal (1 = sin fusionar) y el tamano de las teselas de
+// filtrarPasos. MPI no entra: necesita mpirun y su costo depende de la red.
+//
+// El perfil es un archivo de texto con una linea por clase de imagen
+// (canales y tamano en potencias de 4 pixeles):
+//
+//   c3_10 openmp 8 8 128 512 0.0123
+//   clase backend hilos pasos_por_bloque tesela_alto tesela_ancho segundos
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "imagen.h"
+
+// Muestras de la imagen que se usan para medir: suficiente para que cada
+// hilo tenga varias teselas, sin que el ajuste tarde mas que el filtro
+#ifndef MUESTRAS_AUTOAJUSTE
+#define MUESTRAS_AUTOAJUSTE (4L * 1024 * 1024)
+#endif
+// Corridas por candidato; cuenta la mas rapida
+#ifndef REPETICIONES_AUTOAJUSTE
+#define REPETICIONES_AUTOAJUSTE 3
+#endif
+
+struct ConfigAutoajuste {
+    std::string backend;
+    int num_threads;
+    AjusteFiltros filtros;
+    double segundos;  // de la muestra, con la configuracion ganadora
+};
+
+// "c<canales>_<log4 de los pixeles>"
+std::string claseImagen(int width, int height, int channels);
+
+// $FILTRO_PERFIL, o perfil_<host> en $XDG_CACHE_HOME/filtro (o ~/.cache/filtro)
+std::string rutaPerfilPorDefecto();
+
+class PerfilHost {
+private:
+    std::map<std::string, ConfigAutoajuste> entradas;
+
+public:
+    // false si el archivo no existe o no se puede leer; las lineas mal
+    // formadas se ignoran
+    bool cargar(const std::string& ruta);
+    // Crea el directorio si hace falta y reemplaza el archivo de una vez
+    bool guardar(const std::string& ruta) const;
+
+    // La entrada de la clase o, si no hay, la mas cercana en tamano con los
+    // mismos canales
+    bool buscar(const std::string& clase, ConfigAutoajuste& config) const;
+    void poner(const std::string& clase, const ConfigAutoajuste& config);
+    bool vacio() const { return entradas.empty(); }
+};
+
+// Filas centrales de la imagen del archivo, con el ancho completo, hasta
+// MUESTRAS_AUTOAJUSTE muestras
+bool leerMuestra(const char* ruta, Imagen& muestra);
+
+// Mide los candidatos con los pasos dados y hasta max_threads hilos. Deja
+// configurado el ajuste de filtros ganador. Con detalle imprime cada medicion.
+bool autoajustar(const Imagen& muestra, const std::vector<Filtro>& pasos, int max_threads,
+                 ConfigAutoajuste& mejor, bool detalle);
+
+#endif
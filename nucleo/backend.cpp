@@ -0,0 +1,49 @@
+#include "backend.h"
+
+#include <climits>
+#include <cstring>
+
+Backend* crearBackend(const char* nombre, int num_threads) {
+    // El mpi resuelve su valor por defecto al inicializar
+    if (num_threads < 1 && strcmp(nombre, "mpi") != 0) num_threads = 1;
+
+    if (strcmp(nombre, "serial") == 0) {
+        return crearBackendSerial();
+    }
+    if (strcmp(nombre, "pthreads") == 0) {
+        return crearBackendPthreads(num_threads);
+    }
+#ifdef _OPENMP
+    if (strcmp(nombre, "openmp") == 0) {
+        return crearBackendOpenMP(num_threads);
+    }
+#endif
+#ifdef FILTRO_CON_MPI
+    if (strcmp(nombre, "mpi") == 0) {
+        return crearBackendMPI(num_threads);
+    }
+#endif
+    return nullptr;
+}
+
+const char* backendsDisponibles() {
+    return "serial, pthreads"
+#ifdef _OPENMP
+           ", openmp"
+#endif
+#ifdef FILTRO_CON_MPI
+           ", mpi"
+#endif
+        ;
+}
+
+bool Backend::aplicarPasos(Imagen& imagen, const std::vector<Filtro>& pasos, EstadisticasImagen* estadisticas) {
+    int total = (int)pasos.size();
+    for (int i = 0; i < total;) {
+        int num_pasos = agruparPasos(&pasos[i], total - i, INT_MAX);
+        bool final = i + num_pasos == total;
+        if (!aplicarGrupo(imagen, &pasos[i], num_pasos, final ? estadisticas : nullptr)) return false;
+        i += num_pasos;
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include "estadisticas.h"
+#include "imagen.h"
+
+// Motor de ejecucion de un filtro sobre una imagen completa.
+//
+// Para MPI, aplicar() es colectiva: la imagen completa solo existe en el
+// rank raiz (en los demas llega vacia) y el resultado queda en el raiz.
+class Backend {
+public:
+    virtual ~Backend() {}
+
+    virtual const char* nombre() const = 0;
+
+    // Se llaman una vez al principio y al final del programa
+    virtual bool inicializar(int* argc, char*** argv) { (void)argc; (void)argv; return true; }
+    virtual void finalizar() {}
+
+    // Solo el raiz carga y guarda archivos
+    virtual bool esRaiz() const { return true; }
+    virtual int getNumProcesos() const { return 1; }
+    virtual int getNumThreads() const { return 1; }
+
+    // true si `ok` es true en todos los procesos
+    virtual bool consenso(bool ok) { return ok; }
+
+    // Junta en el raiz las estadisticas recolectadas en cada proceso
+    virtual void reducirEstadisticas(EstadisticasImagen& estadisticas) { (void)estadisticas; }
+
+    virtual bool aplicar(Imagen& imagen, const Filtro& filtro) = 0;
+
+    // Aplica los pasos en orden (p. ej. una cadena repetida --iterations
+    // veces). Por defecto los agrupa con agruparPasos y cada grupo se filtra
+    // en una sola pasada por la imagen con aplicarGrupo. Con estadisticas,
+    // el ultimo grupo acumula en ellas las de este proceso; despues se
+    // juntan con reducirEstadisticas.
+    virtual bool aplicarPasos(Imagen& imagen, const std::vector<Filtro>& pasos,
+                              EstadisticasImagen* estadisticas = nullptr);
+
+protected:
+    // Un grupo de pasos en una pasada. Con estadisticas (no nulas solo en el
+    // grupo final) cada hilo acumula en las suyas y al final se suman ahi.
+    virtual bool aplicarGrupo(Imagen& imagen, const Filtro* pasos, int num_pasos,
+                              EstadisticasImagen* estadisticas) = 0;
+};
+
+// nombre: serial, pthreads, openmp o mpi. Devuelve nullptr si el backend no
+// existe o no se compilo en este binario. Con num_threads < 1 el backend mpi
+// reparte los nucleos del nodo entre los ranks que lo comparten (se sabe al
+// inicializar); los demas usan 1.
+Backend* crearBackend(const char* nombre, int num_threads);
+
+// Backends compilados en este binario, separados por coma
+const char* backendsDisponibles();
+
+Backend* crearBackendSerial();
+Backend* crearBackendPthreads(int num_threads);
+#ifdef _OPENMP
+Backend* crearBackendOpenMP(int num_threads);
+#endif
+#ifdef FILTRO_CON_MPI
+Backend* crearBackendMPI(int num_threads);
+#endif
+
+#endif
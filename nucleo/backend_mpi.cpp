@@ -0,0 +1,250 @@
+#ifdef FILTRO_CON_MPI
+
+#include "backend.h"
+#include "reparto_mpi.h"
+#include "instrumentacion.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include <mpi.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Un rank por proceso; dentro de cada rank la franja se filtra con OpenMP si
+// hay mas de un hilo (modo hibrido). Solo el hilo principal llama a MPI.
+class BackendMPI : public Backend {
+private:
+    int num_threads;
+    int rank;
+    int size;
+    bool inicializado_aqui;
+
+public:
+    explicit BackendMPI(int n) : num_threads(n), rank(0), size(1), inicializado_aqui(false) {}
+
+    const char* nombre() const { return "mpi"; }
+    bool esRaiz() const { return rank == 0; }
+    int getNumProcesos() const { return size; }
+    int getNumThreads() const { return num_threads; }
+
+    bool inicializar(int* argc, char*** argv) {
+        int ya_inicializado;
+        MPI_Initialized(&ya_inicializado);
+        int provided = MPI_THREAD_FUNNELED;
+        if (!ya_inicializado) {
+            MPI_Init_thread(argc, argv, MPI_THREAD_FUNNELED, &provided);
+            inicializado_aqui = true;
+        }
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+        // Por defecto, los nucleos del nodo repartidos entre sus ranks: con
+        // mpirun -np N en un solo host, N veces todos los nucleos satura el nodo
+        if (num_threads < 1) {
+            MPI_Comm nodo;
+            int locales = 1;
+            if (MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodo) == MPI_SUCCESS) {
+                MPI_Comm_size(nodo, &locales);
+                MPI_Comm_free(&nodo);
+            }
+            long en_linea = sysconf(_SC_NPROCESSORS_ONLN);
+            num_threads = en_linea > locales ? (int)(en_linea / locales) : 1;
+        }
+
+        if (provided < MPI_THREAD_FUNNELED && num_threads > 1) {
+            if (rank == 0) {
+                std::cout << "MPI no soporta MPI_THREAD_FUNNELED, usando 1 hilo por proceso" << std::endl;
+            }
+            num_threads = 1;
+        }
+        return true;
+    }
+
+    bool consenso(bool ok) {
+        int local = ok ? 1 : 0;
+        int global;
+        MPI_Allreduce(&local, &global, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        return global != 0;
+    }
+
+    // Histograma y recortes en un solo MPI_Reduce. Un rank sin filas llega
+    // sin estadisticas: toma la forma de los demas.
+    void reducirEstadisticas(EstadisticasImagen& estadisticas) {
+        int forma[2] = {estadisticas.channels, estadisticas.max_color};
+        MPI_Allreduce(MPI_IN_PLACE, forma, 2, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+        if (forma[0] == 0) return;
+        if (estadisticas.vacia()) estadisticas.iniciar(forma[0], forma[1]);
+
+        std::vector<uint64_t> local(estadisticas.histograma);
+        local.insert(local.end(), estadisticas.recortadas_cero, estadisticas.recortadas_cero + MAX_CANALES_ESTADISTICAS);
+        local.insert(local.end(), estadisticas.recortadas_max, estadisticas.recortadas_max + MAX_CANALES_ESTADISTICAS);
+        std::vector<uint64_t> total(rank == 0 ? local.size() : 0);
+        MPI_Reduce(local.data(), total.data(), (int)local.size(), MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+        if (rank == 0) {
+            size_t bins = estadisticas.histograma.size();
+            std::copy(total.begin(), total.begin() + bins, estadisticas.histograma.begin());
+            std::copy(total.begin() + bins, total.begin() + bins + MAX_CANALES_ESTADISTICAS, estadisticas.recortadas_cero);
+            std::copy(total.begin() + bins + MAX_CANALES_ESTADISTICAS, total.end(), estadisticas.recortadas_max);
+        }
+    }
+
+    void finalizar() {
+        if (inicializado_aqui) {
+            // El reporte junta los contadores de todos los ranks
+            REPORTAR_INSTRUMENTACION();
+            MPI_Finalize();
+            inicializado_aqui = false;
+        }
+    }
+
+    bool aplicar(Imagen& imagen, const Filtro& filtro) {
+        return aplicarPaso(imagen, filtro, nullptr);
+    }
+
+protected:
+    // Cuando el borde del grupo no entra en la franja mas chica: un paso por
+    // pasada, repartiendo desde el raiz, y solo el ultimo acumula estadisticas
+    bool aplicarGrupo(Imagen& imagen, const Filtro* pasos, int num_pasos, EstadisticasImagen* estadisticas) {
+        bool ok = true;
+        for (int i = 0; ok && i < num_pasos; i++) {
+            ok = aplicarPaso(imagen, pasos[i], i == num_pasos - 1 ? estadisticas : nullptr);
+        }
+        return ok;
+    }
+
+private:
+    bool aplicarPaso(Imagen& imagen, const Filtro& filtro, EstadisticasImagen* estadisticas) {
+        difundirMetadata(imagen);
+        int height = imagen.getHeight();
+        int row_size = imagen.getWidth() * imagen.getChannels();
+
+        int start_row, end_row, border_start, border_end;
+        calcularFranja(height, rank, size, start_row, end_row);
+        calcularFranjaConBorde(height, rank, size, filtro.radio, border_start, border_end);
+
+        Imagen parte;
+        distribuirFranjas(imagen, filtro.radio, parte);
+
+        // Filtrar solo las filas interiores de la franja
+        int filas = end_row - start_row;
+        BufferPixeles salida((size_t)filas * row_size);
+        int* destino = salida.escritura();
+        Plano plano = parte.getPlano();
+        int offset = start_row - border_start;
+
+#ifdef _OPENMP
+        EstadisticasHilos por_hilo(estadisticas, num_threads);
+        #pragma omp parallel num_threads(num_threads)
+        {
+            int hilo = omp_get_thread_num();
+            int total = omp_get_num_threads();
+            int desde = (int)((long)filas * hilo / total);
+            int hasta = (int)((long)filas * (hilo + 1) / total);
+            filtrarFilas(filtro, plano, destino + (long)desde * row_size, offset + desde, offset + hasta,
+                         por_hilo.hilo(hilo));
+        }
+        por_hilo.sumar();
+#else
+        filtrarFilas(filtro, plano, destino, offset, offset + filas, estadisticas);
+#endif
+        parte.liberarMemoria();
+
+        BufferPixeles resultado = recolectarFranjas(salida.lectura(), height, row_size);
+        if (rank == 0) {
+            imagen.reemplazarPixeles(std::move(resultado));
+        }
+        return true;
+    }
+
+public:
+    // Varios pasos: las franjas se reparten una vez y quedan en cada rank.
+    // Cada grupo de pasos intercambia con los vecinos un borde tan profundo
+    // como la suma de sus radios y despues filtra sin comunicarse, asi que
+    // hay un intercambio cada BLOQUE_TEMPORAL_PASOS pasos y no uno por paso.
+    bool aplicarPasos(Imagen& imagen, const std::vector<Filtro>& pasos, EstadisticasImagen* estadisticas = nullptr) {
+        difundirMetadata(imagen);
+        int height = imagen.getHeight();
+        int row_size = imagen.getWidth() * imagen.getChannels();
+        // El borde no puede pasar de la franja mas chica: cada rank solo
+        // recibe filas de sus vecinos inmediatos. Si algun paso ya lo pasa,
+        // se reparte desde el raiz en cada paso.
+        int max_halo = height / size;
+        bool cabe = true;
+        for (size_t i = 0; i < pasos.size(); i++) cabe = cabe && pasos[i].radio <= max_halo;
+        if (pasos.size() <= 1 || !cabe) {
+            return Backend::aplicarPasos(imagen, pasos, estadisticas);
+        }
+
+        int start_row, end_row;
+        calcularFranja(height, rank, size, start_row, end_row);
+        int filas = end_row - start_row;
+        int arriba = start_row < max_halo ? start_row : max_halo;
+        int abajo = height - end_row < max_halo ? height - end_row : max_halo;
+        size_t total_filas = (size_t)arriba + filas + abajo;
+
+        // Dos buffers del pool con lugar para el borde maximo, alternados por
+        // grupo. Solo se leen el interior y el borde recien intercambiado.
+        BufferPixeles buffer_actual(total_filas * row_size), buffer_siguiente(total_filas * row_size);
+        int* actual = buffer_actual.escritura();
+        int* siguiente = buffer_siguiente.escritura();
+        {
+            Imagen parte;
+            distribuirFranjas(imagen, 0, parte);
+            std::copy(parte.getPixels(), parte.getPixels() + (size_t)filas * row_size,
+                      actual + (size_t)arriba * row_size);
+        }
+
+        int total = (int)pasos.size();
+        for (int i = 0; i < total;) {
+            int num_pasos = agruparPasos(&pasos[i], total - i, max_halo);
+            EstadisticasImagen* final = i + num_pasos == total ? estadisticas : nullptr;
+            int halo = 0;
+            for (int p = 0; p < num_pasos; p++) halo += pasos[i + p].radio;
+            int* interior = actual + (size_t)arriba * row_size;
+            intercambiarBordes(interior, filas, row_size, halo);
+
+            // Plano sobre la franja con el borde de este grupo
+            int borde_arriba = arriba < halo ? arriba : halo;
+            int borde_abajo = abajo < halo ? abajo : halo;
+            Plano plano = imagen.getPlano();
+            plano.datos = interior - (long)borde_arriba * row_size;
+            plano.height = borde_arriba + filas + borde_abajo;
+            int* destino = siguiente + (size_t)arriba * row_size;
+            const Filtro* grupo = &pasos[i];
+
+#ifdef _OPENMP
+            EstadisticasHilos por_hilo(final, num_threads);
+            #pragma omp parallel num_threads(num_threads)
+            {
+                int hilo = omp_get_thread_num();
+                int hilos = omp_get_num_threads();
+                int desde = (int)((long)filas * hilo / hilos);
+                int hasta = (int)((long)filas * (hilo + 1) / hilos);
+                filtrarPasos(grupo, num_pasos, plano, destino + (long)desde * row_size,
+                             borde_arriba + desde, borde_arriba + hasta, por_hilo.hilo(hilo));
+            }
+            por_hilo.sumar();
+#else
+            filtrarPasos(grupo, num_pasos, plano, destino, borde_arriba, borde_arriba + filas, final);
+#endif
+            std::swap(actual, siguiente);
+            i += num_pasos;
+        }
+
+        BufferPixeles resultado = recolectarFranjas(actual + (size_t)arriba * row_size, height, row_size);
+        if (rank == 0) {
+            imagen.reemplazarPixeles(std::move(resultado));
+        }
+        return true;
+    }
+};
+
+Backend* crearBackendMPI(int num_threads) {
+    return new BackendMPI(num_threads);
+}
+
+#endif
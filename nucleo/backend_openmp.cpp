@@ -0,0 +1,55 @@
+#ifdef _OPENMP
+
+#include "backend.h"
+#include "afinidad.h"
+
+#include <utility>
+#include <omp.h>
+
+class BackendOpenMP : public Backend {
+private:
+    int num_threads;
+
+public:
+    explicit BackendOpenMP(int n) : num_threads(n) {}
+
+    const char* nombre() const { return "openmp"; }
+    int getNumThreads() const { return num_threads; }
+
+    bool aplicar(Imagen& imagen, const Filtro& filtro) {
+        return aplicarGrupo(imagen, &filtro, 1, nullptr);
+    }
+
+protected:
+    bool aplicarGrupo(Imagen& imagen, const Filtro* pasos, int num_pasos, EstadisticasImagen* estadisticas) {
+        Plano plano = imagen.getPlano();
+        BufferPixeles destino(imagen.getPixelCount());
+        int* salida = destino.escritura();
+        int height = plano.height;
+        long row_count = plano.rowCount();
+        colocarBuffer(salida, height, row_count);
+        EstadisticasHilos por_hilo(estadisticas, num_threads);
+
+        // Una franja de filas contiguas por hilo, como schedule(static)
+        #pragma omp parallel num_threads(num_threads)
+        {
+            int hilo = omp_get_thread_num();
+            int total = omp_get_num_threads();
+            FijacionHilo fijacion(hilo, total);
+            int start_y = (int)((long)height * hilo / total);
+            int end_y = (int)((long)height * (hilo + 1) / total);
+            filtrarPasos(pasos, num_pasos, plano, salida + start_y * row_count, start_y, end_y,
+                         por_hilo.hilo(hilo));
+        }
+        por_hilo.sumar();
+
+        imagen.reemplazarPixeles(std::move(destino));
+        return true;
+    }
+};
+
+Backend* crearBackendOpenMP(int num_threads) {
+    return new BackendOpenMP(num_threads);
+}
+
+#endif
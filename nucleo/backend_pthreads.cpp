@@ -0,0 +1,90 @@
+#include "backend.h"
+#include "afinidad.h"
+
+#include <iostream>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+
+struct ArgFranja {
+    const Filtro* pasos;
+    int num_pasos;
+    Plano plano;
+    int* destino;
+    int start_y;
+    int end_y;
+    int hilo;
+    int total;
+    EstadisticasImagen* estadisticas;
+};
+
+static void* filtrarFranjaThread(void* arg) {
+    ArgFranja* a = (ArgFranja*)arg;
+    FijacionHilo fijacion(a->hilo, a->total);
+    int* destino = a->destino + (long)a->start_y * a->plano.rowCount();
+    filtrarPasos(a->pasos, a->num_pasos, a->plano, destino, a->start_y, a->end_y, a->estadisticas);
+    return NULL;
+}
+
+// Cada hilo filtra una franja de filas contiguas. Todos leen de la misma
+// entrada y escriben en un unico buffer de salida.
+class BackendPthreads : public Backend {
+private:
+    int num_threads;
+
+public:
+    explicit BackendPthreads(int n) : num_threads(n) {}
+
+    const char* nombre() const { return "pthreads"; }
+    int getNumThreads() const { return num_threads; }
+
+    bool aplicar(Imagen& imagen, const Filtro& filtro) {
+        return aplicarGrupo(imagen, &filtro, 1, nullptr);
+    }
+
+protected:
+    // Con varios pasos cada hilo aplica el bloqueo temporal sobre su franja
+    bool aplicarGrupo(Imagen& imagen, const Filtro* pasos, int num_pasos, EstadisticasImagen* estadisticas) {
+        int height = imagen.getHeight();
+        BufferPixeles destino(imagen.getPixelCount());
+        colocarBuffer(destino.escritura(), height, imagen.getPlano().rowCount());
+
+        std::vector<pthread_t> threads(num_threads);
+        std::vector<ArgFranja> args(num_threads);
+        std::vector<bool> creado(num_threads, false);
+        EstadisticasHilos por_hilo(estadisticas, num_threads);
+
+        for (int i = 0; i < num_threads; i++) {
+            args[i].pasos = pasos;
+            args[i].num_pasos = num_pasos;
+            args[i].plano = imagen.getPlano();
+            args[i].destino = destino.escritura();
+            args[i].start_y = (int)((long)height * i / num_threads);
+            args[i].end_y = (int)((long)height * (i + 1) / num_threads);
+            args[i].hilo = i;
+            args[i].total = num_threads;
+            args[i].estadisticas = por_hilo.hilo(i);
+
+            int rc = pthread_create(&threads[i], NULL, filtrarFranjaThread, &args[i]);
+            if (rc) {
+                std::cout << "Error creating thread " << i << std::endl;
+                // La franja la filtra el hilo actual
+                filtrarFranjaThread(&args[i]);
+            } else {
+                creado[i] = true;
+            }
+        }
+
+        for (int i = 0; i < num_threads; i++) {
+            if (creado[i]) pthread_join(threads[i], NULL);
+        }
+        por_hilo.sumar();
+
+        imagen.reemplazarPixeles(std::move(destino));
+        return true;
+    }
+};
+
+Backend* crearBackendPthreads(int num_threads) {
+    return new BackendPthreads(num_threads);
+}
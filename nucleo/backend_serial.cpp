@@ -0,0 +1,25 @@
+#include "backend.h"
+
+#include <utility>
+
+class BackendSerial : public Backend {
+public:
+    const char* nombre() const { return "serial"; }
+
+    bool aplicar(Imagen& imagen, const Filtro& filtro) {
+        imagen.aplicar(filtro);
+        return true;
+    }
+
+protected:
+    bool aplicarGrupo(Imagen& imagen, const Filtro* pasos, int num_pasos, EstadisticasImagen* estadisticas) {
+        BufferPixeles destino(imagen.getPixelCount());
+        filtrarPasos(pasos, num_pasos, imagen.getPlano(), destino.escritura(), 0, imagen.getHeight(), estadisticas);
+        imagen.reemplazarPixeles(std::move(destino));
+        return true;
+    }
+};
+
+Backend* crearBackendSerial() {
+    return new BackendSerial();
+}
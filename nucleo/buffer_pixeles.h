@@ -0,0 +1,125 @@
+#ifndef BUFFER_PIXELES_H
+#define BUFFER_PIXELES_H
+
+// Buffer de pixeles con dueño, movible y con copia diferida (copy-on-write).
+//
+// - Mover un BufferPixeles transfiere el bloque sin copiar nada.
+// - compartir() devuelve otro BufferPixeles sobre el mismo bloque; la copia
+//   real solo ocurre si alguno de los dos pide escritura() mientras el bloque
+//   sigue compartido.
+// - rebanada() es una vista de un rango contiguo (p. ej. un grupo de filas)
+//   que tambien comparte el bloque.
+//
+// Los bloques se piden y devuelven al pool de pool_buffers.h.
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+
+#include "pool_buffers.h"
+
+class BufferPixeles {
+private:
+    struct Bloque {
+        std::atomic<int> referencias;
+        int* datos;
+    };
+
+    Bloque* bloque;
+    size_t inicio;
+    size_t count;
+
+    void soltar() {
+        if (bloque != nullptr && bloque->referencias.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            devolverPixeles(bloque->datos);
+            delete bloque;
+        }
+        bloque = nullptr;
+        inicio = 0;
+        count = 0;
+    }
+
+    BufferPixeles(Bloque* b, size_t ini, size_t n) : bloque(b), inicio(ini), count(n) {
+        if (bloque != nullptr) bloque->referencias.fetch_add(1, std::memory_order_relaxed);
+    }
+
+public:
+    BufferPixeles() : bloque(nullptr), inicio(0), count(0) {}
+
+    explicit BufferPixeles(size_t n) : bloque(nullptr), inicio(0), count(n) {
+        if (n > 0) {
+            bloque = new Bloque;
+            bloque->referencias.store(1, std::memory_order_relaxed);
+            bloque->datos = pedirPixeles(n);
+        }
+    }
+
+    // Las copias tienen que ser explicitas: compartir() o clonar()
+    BufferPixeles(const BufferPixeles&) = delete;
+    BufferPixeles& operator=(const BufferPixeles&) = delete;
+
+    BufferPixeles(BufferPixeles&& otro) noexcept : bloque(otro.bloque), inicio(otro.inicio), count(otro.count) {
+        otro.bloque = nullptr;
+        otro.inicio = 0;
+        otro.count = 0;
+    }
+
+    BufferPixeles& operator=(BufferPixeles&& otro) noexcept {
+        if (this != &otro) {
+            soltar();
+            bloque = otro.bloque;
+            inicio = otro.inicio;
+            count = otro.count;
+            otro.bloque = nullptr;
+            otro.inicio = 0;
+            otro.count = 0;
+        }
+        return *this;
+    }
+
+    ~BufferPixeles() {
+        soltar();
+    }
+
+    // Clon copy-on-write: O(1), comparte el bloque hasta la primera escritura
+    BufferPixeles compartir() const {
+        return BufferPixeles(bloque, inicio, count);
+    }
+
+    // Vista de [desde, desde + n) que comparte el bloque
+    BufferPixeles rebanada(size_t desde, size_t n) const {
+        return BufferPixeles(bloque, inicio + desde, n);
+    }
+
+    // Copia profunda inmediata
+    BufferPixeles clonar() const {
+        BufferPixeles copia(count);
+        if (count > 0) memcpy(copia.bloque->datos, lectura(), sizeof(int) * count);
+        return copia;
+    }
+
+    const int* lectura() const {
+        return bloque == nullptr ? nullptr : bloque->datos + inicio;
+    }
+
+    // Garantiza que el bloque no esta compartido antes de devolverlo
+    int* escritura() {
+        if (bloque == nullptr) return nullptr;
+        if (bloque->referencias.load(std::memory_order_acquire) > 1) {
+            *this = clonar();
+        }
+        return bloque->datos + inicio;
+    }
+
+    size_t size() const { return count; }
+    bool vacio() const { return count == 0; }
+    bool compartido() const {
+        return bloque != nullptr && bloque->referencias.load(std::memory_order_acquire) > 1;
+    }
+
+    void reset() {
+        soltar();
+    }
+};
+
+#endif
@@ -0,0 +1,349 @@
+#include "cache_resultados.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PRIMO_1 0x9E3779B185EBCA87ULL
+#define PRIMO_2 0xC2B2AE3D27D4EB4FULL
+#define PRIMO_32 0x9E3779B1ULL
+
+static const uint64_t CLAVE_HASH[8] = {
+    0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+    0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL, 0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL,
+};
+
+enum CampoEstadistica { ACIERTOS, FALLOS, EXPULSIONES, NUM_CAMPOS };
+
+// Un bloque de 64 bytes: cada palabra suma su producto 32x32->64 a su
+// acumulador y la palabra misma al vecino, para no perder la parte que el
+// producto anula
+static inline void acumular(uint64_t* __restrict__ acc, const unsigned char* bloque) {
+    uint64_t palabras[8];
+    memcpy(palabras, bloque, sizeof(palabras));
+    for (int i = 0; i < 8; i++) {
+        uint64_t mezcla = palabras[i] ^ CLAVE_HASH[i];
+        acc[i ^ 1] += palabras[i];
+        acc[i] += (mezcla & 0xFFFFFFFFULL) * (mezcla >> 32);
+    }
+}
+
+// Cada 1 KB los bits altos vuelven a los bajos, que son los que multiplican
+static inline void revolver(uint64_t* acc) {
+    for (int i = 0; i < 8; i++) {
+        acc[i] ^= acc[i] >> 47;
+        acc[i] ^= CLAVE_HASH[i];
+        acc[i] *= PRIMO_32;
+    }
+}
+
+static inline uint64_t avalancha(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t hashRapido(const void* datos, size_t bytes, uint64_t semilla) {
+    const unsigned char* p = (const unsigned char*)datos;
+    uint64_t acc[8];
+    for (int i = 0; i < 8; i++) acc[i] = (PRIMO_1 * (i + 1)) ^ semilla;
+
+    size_t bloques = bytes / 64;
+    for (size_t b = 0; b < bloques; b++) {
+        acumular(acc, p + b * 64);
+        if ((b & 15) == 15) revolver(acc);
+    }
+    // El ultimo bloque incompleto, con ceros; el largo entra al final
+    if (bytes % 64 != 0) {
+        unsigned char resto[64] = {0};
+        memcpy(resto, p + bloques * 64, bytes % 64);
+        acumular(acc, resto);
+    }
+
+    uint64_t h = (uint64_t)bytes * PRIMO_1 ^ semilla;
+    for (int i = 0; i < 8; i++) {
+        h ^= avalancha(acc[i] ^ CLAVE_HASH[i]);
+        h = ((h << 27) | (h >> 37)) * PRIMO_2;
+    }
+    return avalancha(h);
+}
+
+bool hashArchivo(const char* ruta, uint64_t semilla, uint64_t& hash, uint64_t* bytes) {
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return false;
+    }
+    size_t tamano = (size_t)info.st_size;
+    if (bytes != nullptr) *bytes = tamano;
+    if (tamano == 0) {
+        close(fd);
+        hash = hashRapido(nullptr, 0, semilla);
+        return true;
+    }
+    void* mapa = mmap(NULL, tamano, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED) return false;
+#ifdef MADV_SEQUENTIAL
+    madvise(mapa, tamano, MADV_SEQUENTIAL);
+#endif
+    hash = hashRapido(mapa, tamano, semilla);
+    munmap(mapa, tamano);
+    return true;
+}
+
+std::string especificacionFiltros(const std::vector<Filtro>& pasos) {
+    std::string especificacion;
+    for (size_t i = 0; i < pasos.size(); i++) {
+        if (i > 0) especificacion += ",";
+        especificacion += std::string(pasos[i].nombre) + ":" + std::to_string(pasos[i].radio);
+    }
+    return especificacion;
+}
+
+// link() necesita que la salida no exista
+static void desenlazarSalida(const char* ruta) {
+    struct stat info;
+    if (lstat(ruta, &info) == 0 && S_ISREG(info.st_mode)) unlink(ruta);
+}
+
+// Copia dentro del kernel (reflink en los sistemas que lo soportan), con
+// read/write si copy_file_range no esta disponible
+static bool copiarArchivo(const char* origen, const char* destino) {
+    int entrada = open(origen, O_RDONLY);
+    if (entrada < 0) return false;
+    int salida = open(destino, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (salida < 0) {
+        close(entrada);
+        return false;
+    }
+    bool ok = true;
+    bool en_kernel = true;
+    char buffer[1 << 16];
+    for (;;) {
+        ssize_t n = -1;
+        if (en_kernel) {
+            n = copy_file_range(entrada, NULL, salida, NULL, 1 << 30, 0);
+            if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                en_kernel = false;
+                continue;
+            }
+        } else {
+            n = read(entrada, buffer, sizeof(buffer));
+            if (n > 0 && write(salida, buffer, (size_t)n) != n) n = -1;
+        }
+        if (n <= 0) {
+            ok = n == 0;
+            break;
+        }
+    }
+    close(entrada);
+    ok = close(salida) == 0 && ok;
+    if (!ok) unlink(destino);
+    return ok;
+}
+
+// Bloqueo exclusivo del directorio entre procesos; se suelta al cerrar
+class BloqueoCache {
+private:
+    int fd;
+
+public:
+    explicit BloqueoCache(const std::string& directorio) {
+        fd = open((directorio + "/.bloqueo").c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd >= 0) flock(fd, LOCK_EX);
+    }
+    ~BloqueoCache() {
+        if (fd >= 0) close(fd);
+    }
+};
+
+// Con el bloqueo tomado
+static void leerContadores(const std::string& directorio, uint64_t* contadores) {
+    for (int i = 0; i < NUM_CAMPOS; i++) contadores[i] = 0;
+    FILE* file = fopen((directorio + "/estadisticas").c_str(), "r");
+    if (file == NULL) return;
+    unsigned long long a, f, e;
+    if (fscanf(file, "aciertos %llu fallos %llu expulsiones %llu", &a, &f, &e) == 3) {
+        contadores[ACIERTOS] = a;
+        contadores[FALLOS] = f;
+        contadores[EXPULSIONES] = e;
+    }
+    fclose(file);
+}
+
+static void escribirContadores(const std::string& directorio, const uint64_t* contadores) {
+    FILE* file = fopen((directorio + "/estadisticas").c_str(), "w");
+    if (file == NULL) return;
+    fprintf(file, "aciertos %llu\nfallos %llu\nexpulsiones %llu\n", (unsigned long long)contadores[ACIERTOS],
+            (unsigned long long)contadores[FALLOS], (unsigned long long)contadores[EXPULSIONES]);
+    fclose(file);
+}
+
+struct EntradaCache {
+    std::string nombre;  // sin extension
+    struct timespec ultimo_uso;
+    uint64_t bytes;
+};
+
+// Entradas <16 hex>.pnm del directorio
+static std::vector<EntradaCache> listarEntradas(const std::string& directorio) {
+    std::vector<EntradaCache> entradas;
+    DIR* dir = opendir(directorio.c_str());
+    if (dir == NULL) return entradas;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        const char* nombre = ent->d_name;
+        if (strlen(nombre) != 20 || strcmp(nombre + 16, ".pnm") != 0) continue;
+        struct stat info;
+        if (stat((directorio + "/" + nombre).c_str(), &info) != 0) continue;
+        EntradaCache entrada;
+        entrada.nombre = std::string(nombre, 16);
+        entrada.ultimo_uso = info.st_mtim;
+        entrada.bytes = (uint64_t)info.st_size;
+        entradas.push_back(entrada);
+    }
+    closedir(dir);
+    return entradas;
+}
+
+CacheResultados::CacheResultados(const char* dir, uint64_t max) : directorio(dir), max_bytes(max) {
+    mkdir(dir, 0755);
+}
+
+std::string CacheResultados::rutaEntrada(uint64_t clave) const {
+    char nombre[32];
+    snprintf(nombre, sizeof(nombre), "/%016llx.pnm", (unsigned long long)clave);
+    return directorio + nombre;
+}
+
+std::string CacheResultados::rutaMeta(uint64_t clave) const {
+    char nombre[32];
+    snprintf(nombre, sizeof(nombre), "/%016llx.meta", (unsigned long long)clave);
+    return directorio + nombre;
+}
+
+void CacheResultados::sumarEstadistica(int campo) {
+    BloqueoCache bloqueo(directorio);
+    uint64_t contadores[NUM_CAMPOS];
+    leerContadores(directorio, contadores);
+    contadores[campo]++;
+    escribirContadores(directorio, contadores);
+}
+
+bool CacheResultados::calcularClave(const char* entrada, const std::string& especificacion, uint64_t& clave) {
+    std::string texto = especificacion + "|v" + std::to_string(VERSION_CACHE_RESULTADOS);
+    return hashArchivo(entrada, hashRapido(texto.data(), texto.size()), clave);
+}
+
+bool CacheResultados::servir(uint64_t clave, const char* salida) {
+    std::string ruta = rutaEntrada(clave);
+    std::string meta = rutaMeta(clave);
+    unsigned long long bytes_meta = 0, hash_meta = 0;
+    FILE* file = fopen(meta.c_str(), "r");
+    bool valida = file != NULL && fscanf(file, "%llu %llx", &bytes_meta, &hash_meta) == 2;
+    if (file != NULL) fclose(file);
+
+    // El contenido tiene que seguir siendo el que se guardo
+    uint64_t hash, bytes;
+    if (valida) {
+        valida = hashArchivo(ruta.c_str(), 0, hash, &bytes) && bytes == bytes_meta && hash == hash_meta;
+        if (!valida) {
+            unlink(ruta.c_str());
+            unlink(meta.c_str());
+        }
+    }
+    if (valida) {
+        desenlazarSalida(salida);
+        valida = link(ruta.c_str(), salida) == 0 || copiarArchivo(ruta.c_str(), salida);
+    }
+    if (valida) {
+        // La fecha de modificacion es la de ultimo uso para la expulsion
+        utimensat(AT_FDCWD, ruta.c_str(), NULL, 0);
+    }
+    sumarEstadistica(valida ? ACIERTOS : FALLOS);
+    return valida;
+}
+
+bool CacheResultados::guardar(uint64_t clave, const char* salida) {
+    uint64_t hash, bytes;
+    if (!hashArchivo(salida, 0, hash, &bytes) || bytes > max_bytes) return false;
+
+    std::string ruta = rutaEntrada(clave);
+    std::string meta = rutaMeta(clave);
+    std::string sufijo = ".tmp" + std::to_string(getpid());
+    std::string temporal = ruta + sufijo;
+    std::string meta_temporal = meta + sufijo;
+    unlink(temporal.c_str());
+    bool ok = link(salida, temporal.c_str()) == 0 || copiarArchivo(salida, temporal.c_str());
+    FILE* file = ok ? fopen(meta_temporal.c_str(), "w") : NULL;
+    if (file != NULL) {
+        ok = fprintf(file, "%llu %016llx\n", (unsigned long long)bytes, (unsigned long long)hash) > 0;
+        ok = fclose(file) == 0 && ok;
+    } else {
+        ok = false;
+    }
+    // Primero el contenido: servir() verifica el hash contra la meta
+    ok = ok && rename(temporal.c_str(), ruta.c_str()) == 0 && rename(meta_temporal.c_str(), meta.c_str()) == 0;
+    if (!ok) {
+        unlink(temporal.c_str());
+        unlink(meta_temporal.c_str());
+        return false;
+    }
+    expulsar();
+    return true;
+}
+
+// Borra las entradas de uso mas viejo hasta quedar dentro del limite
+void CacheResultados::expulsar() {
+    BloqueoCache bloqueo(directorio);
+    std::vector<EntradaCache> entradas = listarEntradas(directorio);
+    uint64_t total = 0;
+    for (size_t i = 0; i < entradas.size(); i++) total += entradas[i].bytes;
+    if (total <= max_bytes) return;
+
+    std::sort(entradas.begin(), entradas.end(),
+              [](const EntradaCache& a, const EntradaCache& b) {
+                  if (a.ultimo_uso.tv_sec != b.ultimo_uso.tv_sec) return a.ultimo_uso.tv_sec < b.ultimo_uso.tv_sec;
+                  return a.ultimo_uso.tv_nsec < b.ultimo_uso.tv_nsec;
+              });
+    uint64_t expulsadas = 0;
+    for (size_t i = 0; i < entradas.size() && total > max_bytes; i++) {
+        unlink((directorio + "/" + entradas[i].nombre + ".pnm").c_str());
+        unlink((directorio + "/" + entradas[i].nombre + ".meta").c_str());
+        total -= entradas[i].bytes;
+        expulsadas++;
+    }
+    uint64_t contadores[NUM_CAMPOS];
+    leerContadores(directorio, contadores);
+    contadores[EXPULSIONES] += expulsadas;
+    escribirContadores(directorio, contadores);
+}
+
+EstadisticasCache CacheResultados::leerEstadisticas() {
+    BloqueoCache bloqueo(directorio);
+    uint64_t contadores[NUM_CAMPOS];
+    leerContadores(directorio, contadores);
+    std::vector<EntradaCache> entradas = listarEntradas(directorio);
+    EstadisticasCache estadisticas;
+    estadisticas.aciertos = contadores[ACIERTOS];
+    estadisticas.fallos = contadores[FALLOS];
+    estadisticas.expulsiones = contadores[EXPULSIONES];
+    estadisticas.entradas = entradas.size();
+    estadisticas.bytes = 0;
+    for (size_t i = 0; i < entradas.size(); i++) estadisticas.bytes += entradas[i].bytes;
+    return estadisticas;
+}
@@ -0,0 +1,77 @@
+#ifndef CACHE_RESULTADOS_H
+#define CACHE_RESULTADOS_H
+
+// Cache en disco de resultados, direccionada por contenido.
+//
+// La clave es el hash de los bytes del archivo de entrada (encabezado y
+// muestras) combinado con la especificacion de la cadena de filtros y las
+// opciones que cambian el resultado; el backend y los hilos no entran. Un
+// acierto no parsea, no filtra ni escribe: la salida se enlaza (hardlink) a
+// la entrada de la cache, o se copia dentro del kernel si el enlace no se
+// puede hacer (otro sistema de archivos).
+//
+// Los escritores de PNM reemplazan los archivos con mas de un enlace en lugar
+// de escribir a traves del enlace (romperEnlaceDuro). Ademas cada entrada
+// guarda el hash de su contenido y se verifica al servirla, asi que si otro
+// programa reescribio en el lugar una salida enlazada, cuenta como fallo y se
+// descarta. Las entradas mas viejas (por fecha de
+// ultimo uso) se expulsan cuando el directorio pasa del limite de bytes. Las
+// estadisticas y la expulsion se serializan con flock() entre procesos.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "filtros.h"
+
+// Aumentar cuando cambie el resultado de algun filtro
+#define VERSION_CACHE_RESULTADOS 1
+#define CACHE_MAX_BYTES_POR_DEFECTO (1024ULL * 1024 * 1024)
+
+// Hash no criptografico de 64 bits. Procesa 64 bytes por vuelta en 8
+// acumuladores independientes con productos 32x32->64, que el compilador
+// vectoriza (pmuludq con SSE2, vpmuludq con AVX2).
+uint64_t hashRapido(const void* datos, size_t bytes, uint64_t semilla = 0);
+
+// Hash de un archivo regular completo (mapeado); falso si no se puede leer
+bool hashArchivo(const char* ruta, uint64_t semilla, uint64_t& hash, uint64_t* bytes = nullptr);
+
+// "blur:1,median:2,..." para la clave
+std::string especificacionFiltros(const std::vector<Filtro>& pasos);
+
+struct EstadisticasCache {
+    uint64_t aciertos;
+    uint64_t fallos;
+    uint64_t expulsiones;
+    uint64_t entradas;
+    uint64_t bytes;
+};
+
+class CacheResultados {
+private:
+    std::string directorio;
+    uint64_t max_bytes;
+
+    std::string rutaEntrada(uint64_t clave) const;
+    std::string rutaMeta(uint64_t clave) const;
+    void sumarEstadistica(int campo);
+    void expulsar();
+
+public:
+    CacheResultados(const char* dir, uint64_t max_bytes = CACHE_MAX_BYTES_POR_DEFECTO);
+
+    // Falso si la entrada no es un archivo regular: ese caso no se cachea
+    bool calcularClave(const char* entrada, const std::string& especificacion, uint64_t& clave);
+
+    // Si hay una entrada valida para la clave, deja la salida en `salida`
+    // y cuenta un acierto; si no, cuenta un fallo
+    bool servir(uint64_t clave, const char* salida);
+
+    // Guarda `salida` (recien escrita) como resultado de la clave
+    bool guardar(uint64_t clave, const char* salida);
+
+    EstadisticasCache leerEstadisticas();
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "contadores_hw.h"
+
+#include <cstring>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+static const char* nombresEventosHW[NUM_EVENTOS_HW] = {
+    "ciclos", "instrucciones", "fallos_llc", "fallos_dtlb", "fallos_pagina"
+};
+
+const char* nombreEventoHW(int evento) {
+    return nombresEventosHW[evento];
+}
+
+GrupoContadoresHW::GrupoContadoresHW() : fd_lider(-1), num_miembros(0) {
+    for (int e = 0; e < NUM_EVENTOS_HW; e++) {
+        fds[e] = -1;
+        orden[e] = -1;
+    }
+}
+
+GrupoContadoresHW::~GrupoContadoresHW() {
+    cerrar();
+}
+
+void GrupoContadoresHW::cerrar() {
+    for (int e = 0; e < NUM_EVENTOS_HW; e++) {
+        if (fds[e] >= 0) close(fds[e]);
+        fds[e] = -1;
+    }
+    fd_lider = -1;
+    num_miembros = 0;
+}
+
+#ifdef __linux__
+
+static void configurarEvento(int evento, struct perf_event_attr& attr) {
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    switch (evento) {
+        case HW_CICLOS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case HW_INSTRUCCIONES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case HW_FALLOS_LLC:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case HW_FALLOS_DTLB:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case HW_FALLOS_PAGINA:
+            attr.type = PERF_TYPE_SOFTWARE;
+            attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+            break;
+    }
+}
+
+bool GrupoContadoresHW::abrir() {
+    cerrar();
+    // El primer evento que abra es el lider; los demas se unen a su grupo
+    // para que se lean todos juntos con un solo read()
+    for (int e = 0; e < NUM_EVENTOS_HW; e++) {
+        struct perf_event_attr attr;
+        configurarEvento(e, attr);
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = (fd_lider < 0) ? 1 : 0;
+
+        int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, fd_lider, 0);
+        if (fd < 0) continue;
+        if (fd_lider < 0) fd_lider = fd;
+        fds[e] = fd;
+        orden[num_miembros++] = e;
+    }
+    if (fd_lider < 0) return false;
+
+    ioctl(fd_lider, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fd_lider, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+bool GrupoContadoresHW::leer(uint64_t valores[NUM_EVENTOS_HW]) const {
+    for (int e = 0; e < NUM_EVENTOS_HW; e++) valores[e] = 0;
+    if (fd_lider < 0) return false;
+
+    // nr, time_enabled, time_running, valor[nr]
+    uint64_t datos[3 + NUM_EVENTOS_HW];
+    ssize_t n = read(fd_lider, datos, sizeof(datos));
+    if (n < (ssize_t)(3 * sizeof(uint64_t))) return false;
+
+    uint64_t nr = datos[0];
+    double escala = (datos[2] > 0 && datos[2] < datos[1]) ? (double)datos[1] / (double)datos[2] : 1.0;
+    for (uint64_t i = 0; i < nr && i < (uint64_t)num_miembros; i++) {
+        valores[orden[i]] = (uint64_t)((double)datos[3 + i] * escala);
+    }
+    return true;
+}
+
+#else
+
+bool GrupoContadoresHW::abrir() {
+    return false;
+}
+
+bool GrupoContadoresHW::leer(uint64_t valores[NUM_EVENTOS_HW]) const {
+    for (int e = 0; e < NUM_EVENTOS_HW; e++) valores[e] = 0;
+    return false;
+}
+
+#endif
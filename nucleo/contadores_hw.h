@@ -0,0 +1,43 @@
+#ifndef CONTADORES_HW_H
+#define CONTADORES_HW_H
+
+#include <cstdint>
+
+// Contadores de hardware del hilo actual con perf_event_open (solo Linux).
+// Los eventos que el kernel o el contenedor no permiten se marcan como no
+// disponibles y el resto sigue funcionando.
+enum EventoHW {
+    HW_CICLOS,
+    HW_INSTRUCCIONES,
+    HW_FALLOS_LLC,
+    HW_FALLOS_DTLB,
+    HW_FALLOS_PAGINA,  // evento de software, suele estar aun sin acceso al PMU
+    NUM_EVENTOS_HW
+};
+
+const char* nombreEventoHW(int evento);
+
+class GrupoContadoresHW {
+private:
+    int fd_lider;
+    int fds[NUM_EVENTOS_HW];
+    int orden[NUM_EVENTOS_HW];  // evento de cada valor leido del grupo
+    int num_miembros;
+
+public:
+    GrupoContadoresHW();
+    ~GrupoContadoresHW();
+
+    // Abre y arranca los eventos en el hilo que llama. false si no se pudo
+    // abrir ninguno.
+    bool abrir();
+    void cerrar();
+
+    bool disponible(int evento) const { return fds[evento] >= 0; }
+
+    // Valores acumulados desde abrir(), escalados si hubo multiplexado.
+    // Los eventos no disponibles quedan en 0.
+    bool leer(uint64_t valores[NUM_EVENTOS_HW]) const;
+};
+
+#endif
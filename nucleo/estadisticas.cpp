@@ -0,0 +1,112 @@
+#include "estadisticas.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+void EstadisticasImagen::iniciar(int c, int m) {
+    channels = c;
+    max_color = m;
+    histograma.assign((size_t)c * (m + 1), 0);
+    memset(recortadas_cero, 0, sizeof(recortadas_cero));
+    memset(recortadas_max, 0, sizeof(recortadas_max));
+}
+
+void EstadisticasImagen::sumar(const EstadisticasImagen& otra) {
+    if (otra.vacia()) return;
+    if (vacia()) iniciar(otra.channels, otra.max_color);
+    if (otra.histograma.size() != histograma.size()) return;
+    for (size_t i = 0; i < histograma.size(); i++) histograma[i] += otra.histograma[i];
+    for (int c = 0; c < MAX_CANALES_ESTADISTICAS; c++) {
+        recortadas_cero[c] += otra.recortadas_cero[c];
+        recortadas_max[c] += otra.recortadas_max[c];
+    }
+}
+
+void EstadisticasImagen::acumular(const int* muestras, long count) {
+    unsigned limite = (unsigned)max_color;
+    long bins = (long)max_color + 1;
+    uint64_t* h = histograma.data();
+    if (channels == 1) {
+        for (long i = 0; i < count; i++) {
+            unsigned v = (unsigned)muestras[i];
+            if (v <= limite) h[v]++;
+        }
+        return;
+    }
+    for (long i = 0; i < count; i += channels) {
+        for (int c = 0; c < channels; c++) {
+            unsigned v = (unsigned)muestras[i + c];
+            if (v <= limite) h[c * bins + v]++;
+        }
+    }
+}
+
+uint64_t EstadisticasImagen::muestras(int canal) const {
+    uint64_t total = 0;
+    const uint64_t* h = histograma.data() + (size_t)canal * (max_color + 1);
+    for (int v = 0; v <= max_color; v++) total += h[v];
+    return total;
+}
+
+int EstadisticasImagen::minimo(int canal) const {
+    const uint64_t* h = histograma.data() + (size_t)canal * (max_color + 1);
+    for (int v = 0; v <= max_color; v++) {
+        if (h[v] != 0) return v;
+    }
+    return -1;
+}
+
+int EstadisticasImagen::maximo(int canal) const {
+    const uint64_t* h = histograma.data() + (size_t)canal * (max_color + 1);
+    for (int v = max_color; v >= 0; v--) {
+        if (h[v] != 0) return v;
+    }
+    return -1;
+}
+
+double EstadisticasImagen::media(int canal) const {
+    const uint64_t* h = histograma.data() + (size_t)canal * (max_color + 1);
+    double suma = 0;
+    uint64_t total = 0;
+    for (int v = 0; v <= max_color; v++) {
+        suma += (double)v * h[v];
+        total += h[v];
+    }
+    return total > 0 ? suma / total : 0;
+}
+
+bool EstadisticasImagen::escribirJSON(const char* ruta, int width, int height) const {
+    FILE* out = fopen(ruta, "w");
+    if (out == NULL) {
+        std::cout << "Error opening statistics file: " << ruta << std::endl;
+        return false;
+    }
+    fprintf(out, "{\n  \"ancho\": %d, \"alto\": %d, \"canales\": %d, \"max_color\": %d,\n  \"por_canal\": [",
+            width, height, channels, max_color);
+    for (int c = 0; c < channels; c++) {
+        fprintf(out, "%s\n    {\"canal\": %d, \"muestras\": %llu, \"minimo\": %d, \"maximo\": %d, \"media\": %.6f,"
+                     " \"recortadas_cero\": %llu, \"recortadas_max\": %llu,\n     \"histograma\": [",
+                c ? "," : "", c, (unsigned long long)muestras(c), minimo(c), maximo(c), media(c),
+                (unsigned long long)recortadas_cero[c], (unsigned long long)recortadas_max[c]);
+        const uint64_t* h = histograma.data() + (size_t)c * (max_color + 1);
+        for (int v = 0; v <= max_color; v++) {
+            fprintf(out, "%s%llu", v ? ", " : "", (unsigned long long)h[v]);
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (fclose(out) != 0) {
+        std::cout << "Error writing statistics file: " << ruta << std::endl;
+        return false;
+    }
+    return true;
+}
+
+EstadisticasHilos::EstadisticasHilos(EstadisticasImagen* t, int hilos)
+    : total(t), parciales(t != nullptr && hilos > 0 ? hilos : 0) {}
+
+void EstadisticasHilos::sumar() {
+    if (total == nullptr) return;
+    for (size_t i = 0; i < parciales.size(); i++) total->sumar(parciales[i]);
+}
@@ -0,0 +1,63 @@
+#ifndef ESTADISTICAS_H
+#define ESTADISTICAS_H
+
+// Estadisticas por canal de la salida de una cadena de filtros: histograma
+// (del que salen minimo, maximo y media) y cuantas muestras recorto a 0 o a
+// max_color el paso de recorte de la convolucion.
+//
+// Se calculan en la misma pasada que el ultimo paso, no releyendo la salida:
+// filtrarFilas y filtrarPasos acumulan cada grupo de filas apenas lo
+// escriben, mientras esta en cache. No hay estado global: quien filtra pasa
+// las estadisticas de la llamada a Backend::aplicarPasos, que las baja solo
+// al grupo de pasos que produce la salida, una por hilo (EstadisticasHilos).
+// Con MPI, Backend::reducirEstadisticas junta lo de todos los ranks en el
+// raiz.
+
+#include <cstdint>
+#include <vector>
+
+#define MAX_CANALES_ESTADISTICAS 3
+
+struct EstadisticasImagen {
+    int channels;
+    int max_color;
+    std::vector<uint64_t> histograma;  // un bloque de max_color + 1 por canal
+    uint64_t recortadas_cero[MAX_CANALES_ESTADISTICAS];
+    uint64_t recortadas_max[MAX_CANALES_ESTADISTICAS];
+
+    EstadisticasImagen() : channels(0), max_color(0), recortadas_cero(), recortadas_max() {}
+
+    void iniciar(int channels, int max_color);
+    bool vacia() const { return histograma.empty(); }
+    void sumar(const EstadisticasImagen& otra);
+
+    // Muestras con los canales intercalados; count es multiplo de channels
+    void acumular(const int* muestras, long count);
+
+    uint64_t muestras(int canal) const;
+    int minimo(int canal) const;  // -1 sin muestras
+    int maximo(int canal) const;
+    double media(int canal) const;
+
+    bool escribirJSON(const char* ruta, int width, int height) const;
+};
+
+// Las de cada hilo de una pasada. Cada hilo acumula en la suya sin
+// sincronizarse; el histograma se arma la primera vez que el hilo filtra,
+// una sola vez por pasada. Sin total (estadisticas apagadas) hilo()
+// devuelve nullptr y sumar() no hace nada.
+class EstadisticasHilos {
+private:
+    EstadisticasImagen* total;
+    std::vector<EstadisticasImagen> parciales;
+
+public:
+    EstadisticasHilos(EstadisticasImagen* total, int hilos);
+
+    EstadisticasImagen* hilo(int i) { return total != nullptr ? &parciales[i] : nullptr; }
+
+    // Despues de que terminaron todos los hilos
+    void sumar();
+};
+
+#endif
@@ -0,0 +1,357 @@
+#include "filtros.h"
+
+#include <iostream>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "buffer_pixeles.h"
+#include "estadisticas.h"
+#include "filtros_rango.h"
+#include "instrumentacion.h"
+
+int blurKernel[3][3] = {
+    {1, 1, 1},
+    {1, 1, 1},
+    {1, 1, 1}
+};
+int blurDiv = 9;
+
+int laplaceKernel[3][3] = {
+    { 0, -1,  0},
+    {-1,  4, -1},
+    { 0, -1,  0}
+};
+int laplaceDiv = 1;
+
+int sharpenKernel[3][3] = {
+    { 0, -1,  0},
+    {-1,  5, -1},
+    { 0, -1,  0}
+};
+int sharpenDiv = 1;
+
+// "median", "min7", "dilate5"...
+static bool buscarFiltroRango(const char* nombre, Filtro& filtro) {
+    static const struct {
+        const char* prefijo;
+        const char* nombre;
+        TipoFiltro tipo;
+    } rangos[] = {
+        {"median", "median", FILTRO_MEDIANA},
+        {"min", "min", FILTRO_MINIMO},
+        {"erode", "min", FILTRO_MINIMO},
+        {"max", "max", FILTRO_MAXIMO},
+        {"dilate", "max", FILTRO_MAXIMO},
+    };
+    for (size_t i = 0; i < sizeof(rangos) / sizeof(rangos[0]); i++) {
+        size_t largo = strlen(rangos[i].prefijo);
+        if (strncmp(nombre, rangos[i].prefijo, largo) != 0) continue;
+
+        const char* lado = nombre + largo;
+        int ventana = 3;
+        if (*lado != '\0') {
+            ventana = 0;
+            for (const char* p = lado; *p != '\0'; p++) {
+                if (*p < '0' || *p > '9' || ventana > MAX_VENTANA_RANGO) return false;
+                ventana = ventana * 10 + (*p - '0');
+            }
+        }
+        if (ventana < 3 || ventana % 2 == 0 || ventana > MAX_VENTANA_RANGO) return false;
+
+        filtro.nombre = rangos[i].nombre;
+        filtro.tipo = rangos[i].tipo;
+        filtro.kernel = nullptr;
+        filtro.divisor = 1;
+        filtro.radio = ventana / 2;
+        return true;
+    }
+    return false;
+}
+
+bool buscarFiltro(const char* nombre, Filtro& filtro) {
+    filtro.nombre = nombre;
+    filtro.tipo = FILTRO_CONVOLUCION;
+    filtro.radio = 1;
+    if (strcmp(nombre, "blur") == 0) {
+        filtro.nombre = "blur";
+        filtro.kernel = blurKernel;
+        filtro.divisor = blurDiv;
+    } else if (strcmp(nombre, "laplace") == 0) {
+        filtro.nombre = "laplace";
+        filtro.kernel = laplaceKernel;
+        filtro.divisor = laplaceDiv;
+    } else if (strcmp(nombre, "sharpen") == 0) {
+        filtro.nombre = "sharpen";
+        filtro.kernel = sharpenKernel;
+        filtro.divisor = sharpenDiv;
+    } else {
+        return buscarFiltroRango(nombre, filtro);
+    }
+    return true;
+}
+
+bool parsearCadenaFiltros(const char* cadena, std::vector<Filtro>& filtros) {
+    char nombres[256];
+    strncpy(nombres, cadena, sizeof(nombres) - 1);
+    nombres[sizeof(nombres) - 1] = '\0';
+
+    for (char* nombre = strtok(nombres, ","); nombre != NULL; nombre = strtok(NULL, ",")) {
+        Filtro filtro;
+        if (!buscarFiltro(nombre, filtro)) {
+            std::cout << "Unknown filter: " << nombre << std::endl;
+            return false;
+        }
+        filtros.push_back(filtro);
+    }
+    if (filtros.empty()) {
+        std::cout << "No filter given." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const char* listaFiltros() {
+    return "blur, laplace, sharpen, median, min, max";
+}
+
+static inline int recortar(int sum, int divisor, int max_color) {
+    sum /= divisor;
+    if (sum < 0) sum = 0;
+    if (sum > max_color) sum = max_color;
+    return sum;
+}
+
+// Cuentas del paso de recorte por canal, solo de las columnas [x0, x1): en
+// las teselas con borde las demas columnas las cuenta la tesela vecina
+struct Recortes {
+    uint64_t* ceros;
+    uint64_t* maximos;
+    int x0;
+    int x1;
+};
+
+// Kernel 3x3 con los vecinos fuera del plano ignorados. Las columnas
+// interiores no comprueban limites en x. CONTAR solo lo usa la pasada
+// final con estadisticas; el camino normal queda igual.
+template <bool CONTAR>
+static void convolucionarFilas(const Filtro& filtro, const Plano& plano, int* destino, int start_y, int end_y,
+                               const Recortes* recortes) {
+    int width = plano.width;
+    int channels = plano.channels;
+    int row_count = plano.rowCount();
+    int (*kernel)[3] = filtro.kernel;
+
+    for (int y = start_y; y < end_y; y++) {
+        const int* filas[3];
+        for (int ky = -1; ky <= 1; ky++) {
+            int ny = y + ky;
+            filas[ky + 1] = (ny >= 0 && ny < plano.height) ? plano.fila(ny) : nullptr;
+        }
+        int* salida = destino + (long)(y - start_y) * row_count;
+
+        for (int x = 0; x < width; x++) {
+            bool borde = (x == 0 || x == width - 1);
+            for (int c = 0; c < channels; c++) {
+                int sum = 0;
+                for (int ky = 0; ky < 3; ky++) {
+                    const int* fila = filas[ky];
+                    if (fila == nullptr) continue;
+                    if (borde) {
+                        for (int kx = -1; kx <= 1; kx++) {
+                            int nx = x + kx;
+                            if (nx >= 0 && nx < width) {
+                                sum += fila[nx * channels + c] * kernel[ky][kx + 1];
+                            }
+                        }
+                    } else {
+                        const int* p = fila + x * channels + c;
+                        sum += p[-channels] * kernel[ky][0] + p[0] * kernel[ky][1] + p[channels] * kernel[ky][2];
+                    }
+                }
+                if (CONTAR && x >= recortes->x0 && x < recortes->x1) {
+                    int valor = sum / filtro.divisor;
+                    recortes->ceros[c] += valor < 0;
+                    recortes->maximos[c] += valor > plano.max_color;
+                }
+                salida[x * channels + c] = recortar(sum, filtro.divisor, plano.max_color);
+            }
+        }
+    }
+}
+
+// Los filtros de rango devuelven una muestra de la ventana: nunca recortan
+static void aplicarFiltro(const Filtro& filtro, const Plano& plano, int* destino, int start_y, int end_y,
+                          const Recortes* recortes = nullptr) {
+    switch (filtro.tipo) {
+        case FILTRO_CONVOLUCION:
+            if (recortes != nullptr) {
+                convolucionarFilas<true>(filtro, plano, destino, start_y, end_y, recortes);
+            } else {
+                convolucionarFilas<false>(filtro, plano, destino, start_y, end_y, nullptr);
+            }
+            break;
+        case FILTRO_MEDIANA:
+            medianaFilas(plano, filtro.radio, destino, start_y, end_y);
+            break;
+        case FILTRO_MINIMO:
+            minimoFilas(plano, filtro.radio, destino, start_y, end_y);
+            break;
+        case FILTRO_MAXIMO:
+            maximoFilas(plano, filtro.radio, destino, start_y, end_y);
+            break;
+    }
+}
+
+// El histograma se arma una vez por objeto, la primera vez que se filtra
+static void prepararEstadisticas(EstadisticasImagen& estadisticas, const Plano& plano) {
+    if (estadisticas.vacia()) estadisticas.iniciar(plano.channels, plano.max_color);
+}
+
+// Los recortes se cuentan en la pila y se suman al final, asi los contadores
+// de hilos vecinos no comparten linea de cache mientras filtran
+static void sumarRecortes(EstadisticasImagen& estadisticas, const uint64_t* ceros, const uint64_t* maximos) {
+    for (int c = 0; c < MAX_CANALES_ESTADISTICAS; c++) {
+        estadisticas.recortadas_cero[c] += ceros[c];
+        estadisticas.recortadas_max[c] += maximos[c];
+    }
+}
+
+// Ultimo paso con estadisticas: por tramos de filas, y cada tramo se acumula
+// apenas se escribe. Los tramos tienen al menos 8 radios de alto para que
+// los filtros de rango no rearmen sus histogramas demasiado seguido.
+static void filtrarConEstadisticas(const Filtro& filtro, const Plano& plano, int* destino, int start_y, int end_y,
+                                   EstadisticasImagen& estadisticas) {
+    prepararEstadisticas(estadisticas, plano);
+    uint64_t ceros[MAX_CANALES_ESTADISTICAS] = {};
+    uint64_t maximos[MAX_CANALES_ESTADISTICAS] = {};
+    Recortes recortes = {ceros, maximos, 0, plano.width};
+    long row_count = plano.rowCount();
+    long tramo = row_count > 0 ? BYTES_TRAMO_ESTADISTICAS / (row_count * (long)sizeof(int)) : 1;
+    if (tramo < 8L * filtro.radio) tramo = 8L * filtro.radio;
+    if (tramo < 1) tramo = 1;
+
+    for (int y = start_y; y < end_y; y += (int)tramo) {
+        int hasta = end_y - y > tramo ? y + (int)tramo : end_y;
+        int* salida = destino + (long)(y - start_y) * row_count;
+        aplicarFiltro(filtro, plano, salida, y, hasta, &recortes);
+        estadisticas.acumular(salida, (hasta - y) * row_count);
+    }
+    sumarRecortes(estadisticas, ceros, maximos);
+}
+
+void filtrarFilas(const Filtro& filtro, const Plano& plano, int* destino, int start_y, int end_y,
+                  EstadisticasImagen* estadisticas) {
+    MEDIR_FASE_N(FASE_CONVOLUCION, (long)(end_y - start_y) * plano.rowCount());
+    if (estadisticas != nullptr) {
+        filtrarConEstadisticas(filtro, plano, destino, start_y, end_y, *estadisticas);
+        return;
+    }
+    aplicarFiltro(filtro, plano, destino, start_y, end_y);
+}
+
+static AjusteFiltros ajuste_filtros = {BLOQUE_TEMPORAL_PASOS, TESELA_TEMPORAL_ALTO, TESELA_TEMPORAL_ANCHO};
+
+void configurarAjusteFiltros(const AjusteFiltros& ajuste) {
+    ajuste_filtros = ajuste;
+    if (ajuste_filtros.pasos_por_bloque < 1) ajuste_filtros.pasos_por_bloque = 1;
+    if (ajuste_filtros.tesela_alto < 1) ajuste_filtros.tesela_alto = TESELA_TEMPORAL_ALTO;
+    if (ajuste_filtros.tesela_ancho < 1) ajuste_filtros.tesela_ancho = TESELA_TEMPORAL_ANCHO;
+}
+
+const AjusteFiltros& getAjusteFiltros() {
+    return ajuste_filtros;
+}
+
+int agruparPasos(const Filtro* pasos, int restantes, int max_halo) {
+    int num_pasos = 1;
+    int halo = pasos[0].radio;
+    while (num_pasos < restantes && num_pasos < ajuste_filtros.pasos_por_bloque &&
+           halo + pasos[num_pasos].radio <= max_halo) {
+        halo += pasos[num_pasos].radio;
+        num_pasos++;
+    }
+    return num_pasos;
+}
+
+void filtrarPasos(const Filtro* pasos, int num_pasos, const Plano& plano, int* destino, int start_y, int end_y,
+                  EstadisticasImagen* estadisticas) {
+    MEDIR_FASE_N(FASE_CONVOLUCION, (long)(end_y - start_y) * plano.rowCount() * num_pasos);
+    bool con_estadisticas = estadisticas != nullptr;
+    if (num_pasos == 1) {
+        if (con_estadisticas) {
+            filtrarConEstadisticas(pasos[0], plano, destino, start_y, end_y, *estadisticas);
+        } else {
+            aplicarFiltro(pasos[0], plano, destino, start_y, end_y);
+        }
+        return;
+    }
+
+    int halo = 0;
+    for (int i = 0; i < num_pasos; i++) halo += pasos[i].radio;
+    int width = plano.width;
+    int channels = plano.channels;
+    int row_count = plano.rowCount();
+
+    // Dos buffers del tamano de una tesela con borde, alternados entre pasos.
+    // Salen del pool: en una cadena se piden en cada llamada, y cada paso
+    // solo lee filas que el anterior ya escribio, asi que no hace falta
+    // ponerlos en cero.
+    int tesela_alto = ajuste_filtros.tesela_alto < end_y - start_y ? ajuste_filtros.tesela_alto : end_y - start_y;
+    int tesela_ancho = ajuste_filtros.tesela_ancho < width ? ajuste_filtros.tesela_ancho : width;
+    size_t maximo = (size_t)(tesela_alto + 2 * halo) * (tesela_ancho + 2 * halo) * channels;
+    BufferPixeles buffer_actual(maximo), buffer_siguiente(maximo);
+    int* actual = buffer_actual.escritura();
+    int* siguiente = buffer_siguiente.escritura();
+    uint64_t ceros[MAX_CANALES_ESTADISTICAS] = {};
+    uint64_t maximos[MAX_CANALES_ESTADISTICAS] = {};
+    if (con_estadisticas) prepararEstadisticas(*estadisticas, plano);
+
+    for (int ty0 = start_y; ty0 < end_y; ty0 += tesela_alto) {
+        int ty1 = ty0 + tesela_alto < end_y ? ty0 + tesela_alto : end_y;
+        for (int tx0 = 0; tx0 < width; tx0 += tesela_ancho) {
+            int tx1 = tx0 + tesela_ancho < width ? tx0 + tesela_ancho : width;
+
+            // Tesela con borde, recortada a la imagen: en los bordes reales
+            // el filtro ignora los vecinos igual que sobre la imagen entera
+            int sy0 = ty0 - halo > 0 ? ty0 - halo : 0;
+            int sy1 = ty1 + halo < plano.height ? ty1 + halo : plano.height;
+            int sx0 = tx0 - halo > 0 ? tx0 - halo : 0;
+            int sx1 = tx1 + halo < width ? tx1 + halo : width;
+            int sub_fila = (sx1 - sx0) * channels;
+            for (int y = sy0; y < sy1; y++) {
+                memcpy(actual + (size_t)(y - sy0) * sub_fila, plano.fila(y) + sx0 * channels,
+                       sub_fila * sizeof(int));
+            }
+
+            Plano sub;
+            sub.width = sx1 - sx0;
+            sub.height = sy1 - sy0;
+            sub.channels = channels;
+            sub.max_color = plano.max_color;
+
+            // Despues de cada paso solo hacen falta las filas a distancia
+            // `resto` de la tesela; las demas ya no se leen
+            int resto = halo;
+            for (int i = 0; i < num_pasos; i++) {
+                resto -= pasos[i].radio;
+                int r0 = (ty0 - resto > sy0 ? ty0 - resto : sy0) - sy0;
+                int r1 = (ty1 + resto < sy1 ? ty1 + resto : sy1) - sy0;
+                sub.datos = actual;
+                bool ultimo = con_estadisticas && i == num_pasos - 1;
+                Recortes recortes = {ceros, maximos, tx0 - sx0, tx1 - sx0};
+                aplicarFiltro(pasos[i], sub, siguiente + (size_t)r0 * sub_fila, r0, r1,
+                              ultimo ? &recortes : nullptr);
+                std::swap(actual, siguiente);
+            }
+
+            for (int y = ty0; y < ty1; y++) {
+                int* salida = destino + (long)(y - start_y) * row_count + tx0 * channels;
+                memcpy(salida, actual + (size_t)(y - sy0) * sub_fila + (tx0 - sx0) * channels,
+                       (size_t)(tx1 - tx0) * channels * sizeof(int));
+                if (con_estadisticas) estadisticas->acumular(salida, (long)(tx1 - tx0) * channels);
+            }
+        }
+    }
+    if (con_estadisticas) sumarRecortes(*estadisticas, ceros, maximos);
+}
@@ -0,0 +1,105 @@
+#ifndef FILTROS_H
+#define FILTROS_H
+
+#include <vector>
+
+struct EstadisticasImagen;
+
+// Vista de solo lectura de un grupo de filas contiguas. Para los filtros las
+// filas fuera del plano no existen, igual que fuera de la imagen.
+struct Plano {
+    const int* datos;
+    int width;
+    int height;
+    int channels;
+    int max_color;
+
+    int rowCount() const { return width * channels; }
+    const int* fila(int y) const { return datos + (long)y * rowCount(); }
+};
+
+enum TipoFiltro {
+    FILTRO_CONVOLUCION,
+    FILTRO_MEDIANA,
+    FILTRO_MINIMO,  // erosion
+    FILTRO_MAXIMO   // dilatacion
+};
+
+// Ventana mas grande para los filtros de rango
+#define MAX_VENTANA_RANGO 255
+
+struct Filtro {
+    const char* nombre;
+    TipoFiltro tipo;
+    int (*kernel)[3];  // solo convoluciones
+    int divisor;
+    int radio;  // filas de borde que necesita a cada lado
+};
+
+extern int blurKernel[3][3];
+extern int blurDiv;
+extern int laplaceKernel[3][3];
+extern int laplaceDiv;
+extern int sharpenKernel[3][3];
+extern int sharpenDiv;
+
+// Busca un filtro por nombre: "blur", "laplace", "sharpen" o un filtro de
+// rango "median", "min" (o "erode"), "max" (o "dilate"), con el lado impar de
+// la ventana opcional al final: "median5", "min7". Sin lado la ventana es 3x3.
+bool buscarFiltro(const char* nombre, Filtro& filtro);
+
+// Cadena de filtros separada por comas, p. ej. "blur,sharpen"
+bool parsearCadenaFiltros(const char* cadena, std::vector<Filtro>& filtros);
+
+const char* listaFiltros();
+
+// Filtra las filas [start_y, end_y) del plano. La fila y se escribe en
+// destino + (y - start_y) * plano.rowCount(). Con estadisticas
+// (estadisticas.h; solo en la pasada final) acumula en ellas las filas que
+// escribe. Son las del hilo que llama: no se sincronizan.
+void filtrarFilas(const Filtro& filtro, const Plano& plano, int* destino, int start_y, int end_y,
+                  EstadisticasImagen* estadisticas = nullptr);
+
+// Bloqueo temporal: pasos que se aplican por pasada y tamano de las teselas.
+// Con 8 pasos una tesela RGB con borde y sus dos buffers ocupan ~1.8 MB.
+// Son los valores por defecto; configurarAjusteFiltros los cambia en
+// tiempo de ejecucion (p. ej. con el perfil de --autotune).
+#ifndef BLOQUE_TEMPORAL_PASOS
+#define BLOQUE_TEMPORAL_PASOS 8
+#endif
+#ifndef TESELA_TEMPORAL_ALTO
+#define TESELA_TEMPORAL_ALTO 128
+#endif
+#ifndef TESELA_TEMPORAL_ANCHO
+#define TESELA_TEMPORAL_ANCHO 512
+#endif
+
+struct AjusteFiltros {
+    int pasos_por_bloque;  // 1: sin bloqueo temporal, un paso por pasada
+    int tesela_alto;
+    int tesela_ancho;
+};
+
+// Global; se cambia antes de filtrar, no mientras hay hilos filtrando
+void configurarAjusteFiltros(const AjusteFiltros& ajuste);
+const AjusteFiltros& getAjusteFiltros();
+
+// Bytes de salida por tramo cuando el ultimo paso acumula estadisticas
+#ifndef BYTES_TRAMO_ESTADISTICAS
+#define BYTES_TRAMO_ESTADISTICAS (256 * 1024)
+#endif
+
+// Cuantos de los `restantes` pasos siguientes se aplican juntos: hasta
+// pasos_por_bloque y con la suma de radios hasta max_halo (al menos 1)
+int agruparPasos(const Filtro* pasos, int restantes, int max_halo);
+
+// Como filtrarFilas, pero con los num_pasos filtros aplicados uno tras otro.
+// Trabaja por teselas con un borde igual a la suma de los radios: cada tesela
+// se copia a un buffer chico y todos los pasos se aplican mientras esta en
+// cache, achicando el borde en cada paso (trapecio). El borde se recalcula en
+// las teselas vecinas, asi que cada tesela es independiente. Las
+// estadisticas, si se pasan, son las del ultimo paso.
+void filtrarPasos(const Filtro* pasos, int num_pasos, const Plano& plano, int* destino, int start_y, int end_y,
+                  EstadisticasImagen* estadisticas = nullptr);
+
+#endif
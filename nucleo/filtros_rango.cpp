@@ -0,0 +1,440 @@
+#include "filtros_rango.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Mediana de la ventana recortada, juntando las muestras. Se usa en los
+// bordes, donde la ventana no esta completa.
+static int medianaDirecta(const Plano& plano, int radio, int x, int y, int c, std::vector<int>& ventana) {
+    int y0 = y - radio > 0 ? y - radio : 0;
+    int y1 = y + radio < plano.height - 1 ? y + radio : plano.height - 1;
+    int x0 = x - radio > 0 ? x - radio : 0;
+    int x1 = x + radio < plano.width - 1 ? x + radio : plano.width - 1;
+    ventana.clear();
+    for (int ny = y0; ny <= y1; ny++) {
+        const int* fila = plano.fila(ny);
+        for (int nx = x0; nx <= x1; nx++) ventana.push_back(fila[nx * plano.channels + c]);
+    }
+    std::vector<int>::iterator medio = ventana.begin() + (ventana.size() - 1) / 2;
+    std::nth_element(ventana.begin(), medio, ventana.end());
+    return *medio;
+}
+
+static inline void ordenar2(int& a, int& b) {
+    int menor = a < b ? a : b;
+    b = a < b ? b : a;
+    a = menor;
+}
+
+static inline int mediana3(int a, int b, int c) {
+    ordenar2(a, b);
+    ordenar2(b, c);
+    ordenar2(a, b);
+    return b;
+}
+
+// 3x3: cada columna de 3 se ordena una vez y sirve para las 3 ventanas que
+// la usan; la mediana de 9 es la mediana del mayor de los minimos, la
+// mediana de las medianas y el menor de los maximos.
+static void mediana3x3(const Plano& plano, int* destino, int start_y, int end_y) {
+    int width = plano.width;
+    int channels = plano.channels;
+    int row_count = plano.rowCount();
+    std::vector<int> bajos(row_count), medios(row_count), altos(row_count), ventana;
+
+    for (int y = start_y; y < end_y; y++) {
+        int* salida = destino + (long)(y - start_y) * row_count;
+        if (y == 0 || y == plano.height - 1 || width < 3) {
+            for (int i = 0; i < row_count; i++) {
+                salida[i] = medianaDirecta(plano, 1, i / channels, y, i % channels, ventana);
+            }
+            continue;
+        }
+
+        const int* arriba = plano.fila(y - 1);
+        const int* centro = plano.fila(y);
+        const int* abajo = plano.fila(y + 1);
+        for (int i = 0; i < row_count; i++) {
+            int a = arriba[i], b = centro[i], c = abajo[i];
+            ordenar2(a, b);
+            ordenar2(b, c);
+            ordenar2(a, b);
+            bajos[i] = a;
+            medios[i] = b;
+            altos[i] = c;
+        }
+        for (int c = 0; c < channels; c++) {
+            salida[c] = medianaDirecta(plano, 1, 0, y, c, ventana);
+            int ultimo = (width - 1) * channels + c;
+            salida[ultimo] = medianaDirecta(plano, 1, width - 1, y, c, ventana);
+        }
+        for (int i = channels; i < row_count - channels; i++) {
+            int izq = i - channels, der = i + channels;
+            int max_bajos = std::max(std::max(bajos[izq], bajos[i]), bajos[der]);
+            int med_medios = mediana3(medios[izq], medios[i], medios[der]);
+            int min_altos = std::min(std::min(altos[izq], altos[i]), altos[der]);
+            salida[i] = mediana3(max_bajos, med_medios, min_altos);
+        }
+    }
+}
+
+// Comparador de la red: deja el menor en `a` y el mayor en `b`. Si despues
+// solo se usa una de las dos salidas, se calcula solo esa.
+struct Comparador {
+    int a;
+    int b;
+    bool menor;
+    bool mayor;
+};
+
+// Red de Batcher (odd-even merge sort) de 32 entradas con las entradas
+// 25..31 en INT_MAX, simplificada para obtener solo la salida 12 (la mediana
+// de 25): los comparadores contra un cable que sigue en INT_MAX no hacen nada
+// o son un cambio de nombre, y de atras hacia adelante se descartan los que
+// no influyen en la salida
+struct RedMediana25 {
+    std::vector<Comparador> comparadores;
+    int salida;
+
+    RedMediana25() {
+        const int n = 32;
+        int cable[n];
+        bool infinito[n];
+        for (int i = 0; i < n; i++) {
+            cable[i] = i;
+            infinito[i] = (i >= 25);
+        }
+
+        std::vector<Comparador> red;
+        for (int p = 1; p < n; p += p) {
+            for (int k = p; k > 0; k /= 2) {
+                for (int j = k % p; j + k < n; j += k + k) {
+                    for (int i = 0; i < k && i + j + k < n; i++) {
+                        if ((i + j) / (p + p) != (i + j + k) / (p + p)) continue;
+                        int a = i + j, b = i + j + k;
+                        if (infinito[b]) continue;
+                        if (infinito[a]) {
+                            std::swap(cable[a], cable[b]);
+                            std::swap(infinito[a], infinito[b]);
+                            continue;
+                        }
+                        Comparador comparador = {cable[a], cable[b], true, true};
+                        red.push_back(comparador);
+                    }
+                }
+            }
+        }
+        salida = cable[12];
+
+        bool necesario[n] = {false};
+        necesario[salida] = true;
+        for (int i = (int)red.size() - 1; i >= 0; i--) {
+            Comparador comparador = red[i];
+            comparador.menor = necesario[comparador.a];
+            comparador.mayor = necesario[comparador.b];
+            if (!comparador.menor && !comparador.mayor) continue;
+            necesario[comparador.a] = necesario[comparador.b] = true;
+            comparadores.push_back(comparador);
+        }
+        std::reverse(comparadores.begin(), comparadores.end());
+    }
+};
+
+// 5x5: la red se aplica a vectores de muestras consecutivas de la fila en
+// lugar de a una ventana por vez, asi cada comparador es un min/max sobre
+// TRAMO_RED muestras y el compilador lo vectoriza
+#define TRAMO_RED 256
+
+static void mediana5x5(const Plano& plano, int* destino, int start_y, int end_y) {
+    static const RedMediana25 red;
+    int width = plano.width;
+    int channels = plano.channels;
+    int row_count = plano.rowCount();
+    const Comparador* comparadores = red.comparadores.data();
+    int num_comparadores = (int)red.comparadores.size();
+    std::vector<int> ventana;
+    std::vector<int> cables((size_t)32 * TRAMO_RED);
+
+    for (int y = start_y; y < end_y; y++) {
+        int* salida = destino + (long)(y - start_y) * row_count;
+        if (y < 2 || y > plano.height - 3 || width < 5) {
+            for (int i = 0; i < row_count; i++) {
+                salida[i] = medianaDirecta(plano, 2, i / channels, y, i % channels, ventana);
+            }
+            continue;
+        }
+        for (int i = 0; i < 2 * channels; i++) {
+            salida[i] = medianaDirecta(plano, 2, i / channels, y, i % channels, ventana);
+            int j = row_count - 1 - i;
+            salida[j] = medianaDirecta(plano, 2, j / channels, y, j % channels, ventana);
+        }
+
+        // Muestras interiores [2 * channels, row_count - 2 * channels)
+        for (int desde = 2 * channels; desde < row_count - 2 * channels; desde += TRAMO_RED) {
+            int n = row_count - 2 * channels - desde < TRAMO_RED ? row_count - 2 * channels - desde : TRAMO_RED;
+            for (int k = 0; k < 5; k++) {
+                const int* fila = plano.fila(y - 2 + k) + desde;
+                for (int j = 0; j < 5; j++) {
+                    memcpy(&cables[(size_t)(k * 5 + j) * TRAMO_RED], fila + (j - 2) * channels, n * sizeof(int));
+                }
+            }
+
+            for (int k = 0; k < num_comparadores; k++) {
+                // Cables distintos: sin alias, para que se vectorice
+                int* __restrict__ a = &cables[(size_t)comparadores[k].a * TRAMO_RED];
+                int* __restrict__ b = &cables[(size_t)comparadores[k].b * TRAMO_RED];
+                if (comparadores[k].menor && comparadores[k].mayor) {
+                    for (int i = 0; i < n; i++) {
+                        int menor = a[i] < b[i] ? a[i] : b[i];
+                        b[i] = a[i] < b[i] ? b[i] : a[i];
+                        a[i] = menor;
+                    }
+                } else if (comparadores[k].menor) {
+                    for (int i = 0; i < n; i++) a[i] = a[i] < b[i] ? a[i] : b[i];
+                } else {
+                    for (int i = 0; i < n; i++) b[i] = a[i] < b[i] ? b[i] : a[i];
+                }
+            }
+            memcpy(salida + desde, &cables[(size_t)red.salida * TRAMO_RED], n * sizeof(int));
+        }
+    }
+}
+
+// Radio grande con max_color <= 255 (Perreault y Hebert): un histograma por
+// columna y canal con las filas [y - radio, y + radio], que baja una fila por
+// iteracion, y un histograma de la ventana que avanza sumando la columna que
+// entra y restando la que sale. Con dos niveles (16 grupos de 16 valores) al
+// avanzar solo se actualizan los 16 grupos; los 16 valores de un grupo se
+// ponen al dia recien cuando la mediana cae en el, con las columnas que
+// entraron y salieron desde la ultima vez.
+static void medianaHistogramaColumnas(const Plano& plano, int radio, int* destino, int start_y, int end_y) {
+    int width = plano.width;
+    int height = plano.height;
+    int channels = plano.channels;
+    int row_count = plano.rowCount();
+
+    std::vector<uint16_t> columnas((size_t)row_count * 256, 0);
+    std::vector<uint16_t> columnas_grueso((size_t)row_count * 16, 0);
+    uint32_t fino[256];
+    uint32_t grueso[16];
+    int al_dia[16];  // x de la ventana con la que se actualizo cada grupo fino
+
+    auto sumarFila = [&](int y, int signo) {
+        const int* fila = plano.fila(y);
+        for (int i = 0; i < row_count; i++) {
+            columnas[(size_t)i * 256 + fila[i]] += signo;
+            columnas_grueso[(size_t)i * 16 + (fila[i] >> 4)] += signo;
+        }
+    };
+    auto sumarGrueso = [&](int x, int c, int signo) {
+        const uint16_t* g = &columnas_grueso[(size_t)(x * channels + c) * 16];
+        for (int b = 0; b < 16; b++) grueso[b] += signo * g[b];
+    };
+    // Suma las columnas [x0, x1] recortadas a la imagen al grupo fino g
+    auto sumarFino = [&](int g, int x0, int x1, int c, int signo) {
+        if (x0 < 0) x0 = 0;
+        if (x1 > width - 1) x1 = width - 1;
+        for (int x = x0; x <= x1; x++) {
+            const uint16_t* f = &columnas[(size_t)(x * channels + c) * 256 + g * 16];
+            for (int b = 0; b < 16; b++) fino[g * 16 + b] += signo * f[b];
+        }
+    };
+
+    int primera = start_y - radio > 0 ? start_y - radio : 0;
+    int ultima = start_y + radio < height - 1 ? start_y + radio : height - 1;
+    for (int y = primera; y <= ultima; y++) sumarFila(y, 1);
+
+    for (int y = start_y; y < end_y; y++) {
+        if (y > start_y) {
+            if (y - radio - 1 >= 0) sumarFila(y - radio - 1, -1);
+            if (y + radio < height) sumarFila(y + radio, 1);
+        }
+        int filas = (y + radio < height - 1 ? y + radio : height - 1) - (y - radio > 0 ? y - radio : 0) + 1;
+        int* salida = destino + (long)(y - start_y) * row_count;
+
+        for (int c = 0; c < channels; c++) {
+            memset(grueso, 0, sizeof(grueso));
+            for (int g = 0; g < 16; g++) al_dia[g] = INT_MIN;
+            int cols = 0;
+            for (int x = 0; x <= radio && x < width; x++, cols++) sumarGrueso(x, c, 1);
+
+            for (int x = 0; x < width; x++) {
+                uint32_t objetivo = (uint32_t)(filas * cols - 1) / 2;
+                uint32_t acumulado = 0;
+                int g = 0;
+                while (acumulado + grueso[g] <= objetivo) acumulado += grueso[g++];
+
+                if (al_dia[g] == INT_MIN || x - al_dia[g] > 2 * radio) {
+                    memset(&fino[g * 16], 0, 16 * sizeof(uint32_t));
+                    sumarFino(g, x - radio, x + radio, c, 1);
+                } else {
+                    sumarFino(g, al_dia[g] - radio, x - radio - 1, c, -1);
+                    sumarFino(g, al_dia[g] + radio + 1, x + radio, c, 1);
+                }
+                al_dia[g] = x;
+
+                int b = g * 16;
+                while (acumulado + fino[b] <= objetivo) acumulado += fino[b++];
+                salida[x * channels + c] = b;
+
+                if (x - radio >= 0) {
+                    sumarGrueso(x - radio, c, -1);
+                    cols--;
+                }
+                if (x + radio + 1 < width) {
+                    sumarGrueso(x + radio + 1, c, 1);
+                    cols++;
+                }
+            }
+        }
+    }
+}
+
+// Radio grande con 16 bits (Huang): solo el histograma de la ventana, con
+// 256 grupos de 256 valores; al avanzar se sacan y se meten las muestras de
+// una columna, O(radio) por pixel.
+static void medianaHistogramaVentana(const Plano& plano, int radio, int* destino, int start_y, int end_y) {
+    int width = plano.width;
+    int height = plano.height;
+    int channels = plano.channels;
+    int row_count = plano.rowCount();
+    std::vector<uint32_t> fino((size_t)(plano.max_color + 256) & ~(size_t)255, 0);
+    uint32_t grueso[256];
+
+    for (int y = start_y; y < end_y; y++) {
+        int y0 = y - radio > 0 ? y - radio : 0;
+        int y1 = y + radio < height - 1 ? y + radio : height - 1;
+        int* salida = destino + (long)(y - start_y) * row_count;
+
+        auto sumarColumna = [&](int x, int c, int signo) {
+            for (int ny = y0; ny <= y1; ny++) {
+                int v = plano.fila(ny)[x * channels + c];
+                fino[v] += signo;
+                grueso[v >> 8] += signo;
+            }
+        };
+
+        for (int c = 0; c < channels; c++) {
+            memset(grueso, 0, sizeof(grueso));
+            int cols = 0;
+            for (int x = 0; x <= radio && x < width; x++, cols++) sumarColumna(x, c, 1);
+
+            for (int x = 0; x < width; x++) {
+                uint32_t objetivo = (uint32_t)((y1 - y0 + 1) * cols - 1) / 2;
+                uint32_t acumulado = 0;
+                int g = 0;
+                while (acumulado + grueso[g] <= objetivo) acumulado += grueso[g++];
+                int b = g * 256;
+                while (acumulado + fino[b] <= objetivo) acumulado += fino[b++];
+                salida[x * channels + c] = b;
+
+                if (x - radio >= 0) {
+                    sumarColumna(x - radio, c, -1);
+                    cols--;
+                }
+                if (x + radio + 1 < width) {
+                    sumarColumna(x + radio + 1, c, 1);
+                    cols++;
+                }
+            }
+            // Vaciar el histograma fino sacando lo que quedo en la ventana
+            for (int x = width - radio > 0 ? width - radio : 0; x < width; x++) sumarColumna(x, c, -1);
+        }
+    }
+}
+
+void medianaFilas(const Plano& plano, int radio, int* destino, int start_y, int end_y) {
+    if (radio == 1) {
+        mediana3x3(plano, destino, start_y, end_y);
+    } else if (radio == 2) {
+        mediana5x5(plano, destino, start_y, end_y);
+    } else if (plano.max_color <= 255) {
+        medianaHistogramaColumnas(plano, radio, destino, start_y, end_y);
+    } else {
+        medianaHistogramaVentana(plano, radio, destino, start_y, end_y);
+    }
+}
+
+template <bool MAXIMO>
+static inline int combinar(int a, int b) {
+    return MAXIMO ? (a > b ? a : b) : (a < b ? a : b);
+}
+
+// van Herk/Gil-Werman sobre `n` posiciones con relleno neutro: en bloques de
+// 2 * radio + 1, prefijos hacia adelante (g) y sufijos hacia atras (h); la
+// ventana [q, q + 2 * radio] es combinar(h[q], g[q + 2 * radio]). Cada
+// posicion es un grupo de `paso` enteros contiguos (canales o filas enteras).
+template <bool MAXIMO>
+static void vanHerk(const int* entrada, int n, int paso, int radio, int* g, int* h, int* salida, int salidas) {
+    int ventana = 2 * radio + 1;
+    for (int q = 0; q < n; q++) {
+        const int* e = entrada + (long)q * paso;
+        int* gq = g + (long)q * paso;
+        if (q % ventana == 0) {
+            memcpy(gq, e, paso * sizeof(int));
+        } else {
+            for (int i = 0; i < paso; i++) gq[i] = combinar<MAXIMO>(gq[i - paso], e[i]);
+        }
+    }
+    for (int q = n - 1; q >= 0; q--) {
+        const int* e = entrada + (long)q * paso;
+        int* hq = h + (long)q * paso;
+        if (q % ventana == ventana - 1 || q == n - 1) {
+            memcpy(hq, e, paso * sizeof(int));
+        } else {
+            for (int i = 0; i < paso; i++) hq[i] = combinar<MAXIMO>(hq[i + paso], e[i]);
+        }
+    }
+    for (int q = 0; q < salidas; q++) {
+        const int* hq = h + (long)q * paso;
+        const int* gq = g + (long)(q + 2 * radio) * paso;
+        int* s = salida + (long)q * paso;
+        for (int i = 0; i < paso; i++) s[i] = combinar<MAXIMO>(hq[i], gq[i]);
+    }
+}
+
+// Minimo o maximo separable: pasada horizontal por fila y pasada vertical
+// sobre filas enteras, por tramos de filas para acotar la memoria
+template <bool MAXIMO>
+static void rangoFilas(const Plano& plano, int radio, int* destino, int start_y, int end_y) {
+    const int neutro = MAXIMO ? INT_MIN : INT_MAX;
+    int width = plano.width;
+    int channels = plano.channels;
+    int row_count = plano.rowCount();
+    int tramo = 4 * radio > 64 ? 4 * radio : 64;
+
+    std::vector<int> relleno((size_t)(width + 2 * radio) * channels, neutro);
+    std::vector<int> g_fila(relleno.size()), h_fila(relleno.size());
+    std::vector<int> horizontal((size_t)(tramo + 2 * radio) * row_count);
+    std::vector<int> g(horizontal.size()), h(horizontal.size());
+
+    for (int ty = start_y; ty < end_y; ty += tramo) {
+        int filas = end_y - ty < tramo ? end_y - ty : tramo;
+        int lineas = filas + 2 * radio;
+        for (int q = 0; q < lineas; q++) {
+            int y = ty - radio + q;
+            int* linea = horizontal.data() + (size_t)q * row_count;
+            if (y < 0 || y >= plano.height) {
+                std::fill(linea, linea + row_count, neutro);
+                continue;
+            }
+            memcpy(relleno.data() + (size_t)radio * channels, plano.fila(y), row_count * sizeof(int));
+            vanHerk<MAXIMO>(relleno.data(), width + 2 * radio, channels, radio, g_fila.data(), h_fila.data(),
+                            linea, width);
+        }
+        vanHerk<MAXIMO>(horizontal.data(), lineas, row_count, radio, g.data(), h.data(),
+                        destino + (long)(ty - start_y) * row_count, filas);
+    }
+}
+
+void minimoFilas(const Plano& plano, int radio, int* destino, int start_y, int end_y) {
+    rangoFilas<false>(plano, radio, destino, start_y, end_y);
+}
+
+void maximoFilas(const Plano& plano, int radio, int* destino, int start_y, int end_y) {
+    rangoFilas<true>(plano, radio, destino, start_y, end_y);
+}
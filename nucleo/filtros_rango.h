@@ -0,0 +1,20 @@
+#ifndef FILTROS_RANGO_H
+#define FILTROS_RANGO_H
+
+#include "filtros.h"
+
+// Filtros de rango sobre una ventana de (2 * radio + 1)^2 recortada al plano:
+// los vecinos fuera del plano no cuentan, igual que en las convoluciones. La
+// mediana de una ventana con n muestras es la de posicion (n - 1) / 2.
+//
+// - Mediana 3x3 y 5x5: redes de ordenamiento en el interior.
+// - Mediana de radio >= 3: histogramas deslizantes. Con max_color <= 255,
+//   histogramas por columna de dos niveles (Perreault y Hebert), O(1) por
+//   pixel; con 16 bits, histograma de la ventana (Huang), O(radio).
+// - Minimo y maximo (erosion y dilatacion): separables con van Herk/Gil-Werman,
+//   3 comparaciones por muestra y pasada sin importar el radio.
+void medianaFilas(const Plano& plano, int radio, int* destino, int start_y, int end_y);
+void minimoFilas(const Plano& plano, int radio, int* destino, int start_y, int end_y);
+void maximoFilas(const Plano& plano, int radio, int* destino, int start_y, int end_y);
+
+#endif
@@ -0,0 +1,159 @@
+#include "imagen.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "afinidad.h"
+#include "instrumentacion.h"
+#include "teselado.h"
+
+Imagen::Imagen() : width(0), height(0), max_color(0), pixel_count(0), channels(1) {
+    magic[0] = '\0';
+}
+
+Imagen::~Imagen() {
+    liberarMemoria();
+}
+
+void Imagen::liberarMemoria() {
+    pixels.reset();
+    pixel_count = 0;
+}
+
+bool Imagen::cargarDesdeArchivo(const char* filename) {
+    liberarMemoria();
+
+    // Un archivo teselado se carga entero como P5/P6
+    if (esArchivoTeselado(filename)) {
+        ArchivoTeselado teselado;
+        if (!teselado.abrir(filename)) return false;
+        const EncabezadoPNM& enc = teselado.getEncabezado();
+        setMetadata(enc.magic, enc.width, enc.height, enc.max_color, enc.channels);
+        allocatePixels();
+        MEDIR_FASE_N(FASE_LECTURA, pixel_count);
+        if (!teselado.leerRegion(0, 0, width, height, pixels.escritura())) {
+            liberarMemoria();
+            return false;
+        }
+        return true;
+    }
+
+    LectorPNM lector;
+    if (!lector.abrir(filename)) {
+        return false;
+    }
+
+    const EncabezadoPNM& enc = lector.getEncabezado();
+    if (!validarTamanoImagen(enc.width, enc.height, enc.channels)) {
+        return false;
+    }
+    setMetadata(enc.magic, enc.width, enc.height, enc.max_color, enc.channels);
+    allocatePixels();
+
+    bool ok;
+    int* destino = pixels.escritura();
+    {
+        MEDIR_FASE_N(FASE_LECTURA, pixel_count);
+        ok = lector.leerFilas(destino, height);
+    }
+    if (!ok) {
+        liberarMemoria();
+        return false;
+    }
+    return true;
+}
+
+bool Imagen::guardarEnArchivo(const char* filename) const {
+    MEDIR_FASE_N(FASE_ESCRITURA, pixel_count);
+    EscritorPNM escritor;
+    if (!escritor.abrir(filename, getEncabezado())) {
+        return false;
+    }
+    bool ok = escritor.escribirFilas(pixels.lectura(), height);
+    if (!escritor.cerrar()) {
+        std::cout << "Error closing output file: " << filename << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+const char* Imagen::getTipo() const {
+    if (strcmp(magic, "P2") == 0 || strcmp(magic, "P5") == 0) return "PGM";
+    if (strcmp(magic, "P3") == 0 || strcmp(magic, "P6") == 0) return "PPM";
+    return "Unknown";
+}
+
+void Imagen::copiarDesde(const Imagen& otra) {
+    liberarMemoria();
+
+    // Los dos son de MAX_MAGIC y ya terminan en '\0'
+    memcpy(magic, otra.magic, MAX_MAGIC);
+    width = otra.width;
+    height = otra.height;
+    max_color = otra.max_color;
+    pixel_count = otra.pixel_count;
+    channels = otra.channels;
+
+    // Comparte el buffer; solo se copia si alguna de las dos se modifica
+    pixels = otra.pixels.compartir();
+}
+
+Imagen Imagen::copiar() const {
+    Imagen nueva;
+    nueva.copiarDesde(*this);
+    return nueva;
+}
+
+void Imagen::aplicar(const Filtro& filtro) {
+    BufferPixeles nuevos(pixel_count);
+    filtrarFilas(filtro, getPlano(), nuevos.escritura(), 0, height);
+    pixels = std::move(nuevos);
+}
+
+EncabezadoPNM Imagen::getEncabezado() const {
+    EncabezadoPNM enc;
+    memcpy(enc.magic, magic, MAX_MAGIC);
+    enc.width = width;
+    enc.height = height;
+    enc.max_color = max_color;
+    enc.channels = channels;
+    enc.binario = (magic[1] == '5' || magic[1] == '6');
+    return enc;
+}
+
+Plano Imagen::getPlano() const {
+    Plano plano;
+    plano.datos = pixels.lectura();
+    plano.width = width;
+    plano.height = height;
+    plano.channels = channels;
+    plano.max_color = max_color;
+    return plano;
+}
+
+void Imagen::setMetadata(const char* mgc, int w, int h, int mc, int ch) {
+    // snprintf recorta y siempre termina la cadena
+    snprintf(magic, sizeof(magic), "%s", mgc);
+    width = w;
+    height = h;
+    max_color = mc;
+    channels = ch;
+    pixel_count = w * h * ch;
+}
+
+void Imagen::allocatePixels() {
+    pixels = BufferPixeles(pixel_count);
+    if (pixel_count > 0) colocarBuffer(pixels.escritura(), height, (long)width * channels);
+}
+
+void Imagen::compartirFilas(const Imagen& otra, int start_row, int end_row) {
+    setMetadata(otra.magic, otra.width, end_row - start_row, otra.max_color, otra.channels);
+    int row_size = otra.width * otra.channels;
+    pixels = otra.pixels.rebanada((size_t)start_row * row_size, (size_t)pixel_count);
+}
+
+void Imagen::reemplazarPixeles(BufferPixeles&& nuevos) {
+    pixels = std::move(nuevos);
+}
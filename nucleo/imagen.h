@@ -0,0 +1,65 @@
+#ifndef IMAGEN_H
+#define IMAGEN_H
+
+#include "buffer_pixeles.h"
+#include "filtros.h"
+#include "pnm.h"
+
+class Imagen {
+private:
+    char magic[MAX_MAGIC];
+    int width;
+    int height;
+    int max_color;
+    BufferPixeles pixels;
+    int pixel_count;
+    int channels;
+
+public:
+    Imagen();
+
+    // Sin copias implicitas: mover es gratis y copiar() comparte el buffer
+    Imagen(Imagen&&) = default;
+    Imagen& operator=(Imagen&&) = default;
+    Imagen(const Imagen&) = delete;
+    Imagen& operator=(const Imagen&) = delete;
+
+    ~Imagen();
+
+    void liberarMemoria();
+
+    bool cargarDesdeArchivo(const char* filename);
+    bool guardarEnArchivo(const char* filename) const;
+
+    const char* getTipo() const;
+
+    void copiarDesde(const Imagen& otra);
+    Imagen copiar() const;
+
+    // Aplica el filtro en el hilo actual
+    void aplicar(const Filtro& filtro);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getMaxColor() const { return max_color; }
+    int getChannels() const { return channels; }
+    int getPixelCount() const { return pixel_count; }
+    const char* getMagic() const { return magic; }
+    const int* getPixels() const { return pixels.lectura(); }
+    int* getPixelsEscritura() { return pixels.escritura(); }
+
+    EncabezadoPNM getEncabezado() const;
+    Plano getPlano() const;
+
+    void setMetadata(const char* mgc, int w, int h, int mc, int ch);
+    void allocatePixels();
+
+    // La imagen pasa a ser una vista de las filas [start_row, end_row) de
+    // otra, sin copiar pixeles
+    void compartirFilas(const Imagen& otra, int start_row, int end_row);
+
+    BufferPixeles compartirPixeles() const { return pixels.compartir(); }
+    void reemplazarPixeles(BufferPixeles&& nuevos);
+};
+
+#endif
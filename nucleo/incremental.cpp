@@ -0,0 +1,278 @@
+#include "incremental.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+static int teselasEn(int lado, int tesela) {
+    return (int)(((long)lado + tesela - 1) / tesela);
+}
+
+// Tesela (tx, ty) recortada a la imagen
+static Region regionTesela(int tx, int ty, int tesela, int width, int height) {
+    Region region;
+    region.x = tx * tesela;
+    region.y = ty * tesela;
+    region.width = std::min(tesela, width - region.x);
+    region.height = std::min(tesela, height - region.y);
+    return region;
+}
+
+static bool mismoFormato(const Imagen& a, const Imagen& b) {
+    return a.getWidth() == b.getWidth() && a.getHeight() == b.getHeight() &&
+           a.getChannels() == b.getChannels() && a.getMaxColor() == b.getMaxColor();
+}
+
+// Suma de los radios: hasta donde llega un cambio en la salida
+static int bordeDe(const std::vector<Filtro>& pasos, int width, int height) {
+    long borde = 0;
+    for (size_t i = 0; i < pasos.size(); i++) borde += pasos[i].radio;
+    return (int)std::min(borde, (long)std::max(width, height));
+}
+
+// Achica la region al rectangulo que contiene todas las diferencias; falso
+// si no hay ninguna
+static bool recortarDiferencias(const Imagen& a, const Imagen& b, Region& region) {
+    int channels = a.getChannels();
+    size_t fila = (size_t)a.getWidth() * channels;
+    size_t bytes = (size_t)region.width * channels * sizeof(int);
+    int x0 = region.x + region.width, x1 = region.x - 1, y0 = -1, y1 = -1;
+    for (int y = region.y; y < region.y + region.height; y++) {
+        size_t offset = y * fila + (size_t)region.x * channels;
+        if (memcmp(a.getPixels() + offset, b.getPixels() + offset, bytes) == 0) continue;
+        if (y0 < 0) y0 = y;
+        y1 = y;
+        for (int i = 0; i < region.width * channels; i++) {
+            if (a.getPixels()[offset + i] != b.getPixels()[offset + i]) {
+                x0 = std::min(x0, region.x + i / channels);
+                x1 = std::max(x1, region.x + i / channels);
+            }
+        }
+    }
+    if (y0 < 0) return false;
+    region.x = x0;
+    region.y = y0;
+    region.width = x1 - x0 + 1;
+    region.height = y1 - y0 + 1;
+    return true;
+}
+
+std::vector<Region> regionesCambiadas(const Imagen& anterior, const Imagen& nueva, int tesela) {
+    std::vector<Region> cambios;
+    if (!mismoFormato(anterior, nueva)) {
+        Region todo = {0, 0, nueva.getWidth(), nueva.getHeight()};
+        cambios.push_back(todo);
+        return cambios;
+    }
+    int teselas_x = teselasEn(nueva.getWidth(), tesela);
+    int teselas_y = teselasEn(nueva.getHeight(), tesela);
+    for (int ty = 0; ty < teselas_y; ty++) {
+        for (int tx = 0; tx < teselas_x; tx++) {
+            Region region = regionTesela(tx, ty, tesela, nueva.getWidth(), nueva.getHeight());
+            if (recortarDiferencias(anterior, nueva, region)) cambios.push_back(region);
+        }
+    }
+    return cambios;
+}
+
+// Aplica la cadena a la ventana de la entrada alrededor del tramo y copia a
+// la salida solo el tramo. Con paralelo, cada paso reparte filas entre hilos.
+static void filtrarTramo(const std::vector<Filtro>& pasos, const Plano& entrada, int borde, const Region& tramo,
+                         int* salida, bool paralelo) {
+    Region ventana = expandirRegion(tramo, borde, entrada.width, entrada.height);
+    int channels = entrada.channels;
+    size_t fila_ventana = (size_t)ventana.width * channels;
+    size_t fila_imagen = (size_t)entrada.width * channels;
+    BufferPixeles buffer_actual(fila_ventana * ventana.height), buffer_siguiente(fila_ventana * ventana.height);
+    int* actual = buffer_actual.escritura();
+    int* siguiente = buffer_siguiente.escritura();
+    for (int y = 0; y < ventana.height; y++) {
+        memcpy(actual + y * fila_ventana,
+               entrada.datos + (size_t)(ventana.y + y) * fila_imagen + (size_t)ventana.x * channels,
+               fila_ventana * sizeof(int));
+    }
+
+    Plano plano = entrada;
+    plano.width = ventana.width;
+    plano.height = ventana.height;
+    for (size_t p = 0; p < pasos.size(); p++) {
+        plano.datos = actual;
+        int* destino = siguiente;
+        if (paralelo) {
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static)
+#endif
+            for (int y = 0; y < plano.height; y += 16) {
+                filtrarFilas(pasos[p], plano, destino + y * fila_ventana, y, std::min(y + 16, plano.height));
+            }
+        } else {
+            filtrarFilas(pasos[p], plano, destino, 0, plano.height);
+        }
+        std::swap(actual, siguiente);
+    }
+
+    size_t ancho = (size_t)tramo.width * channels;
+    for (int y = 0; y < tramo.height; y++) {
+        memcpy(salida + (size_t)(tramo.y + y) * fila_imagen + (size_t)tramo.x * channels,
+               actual + (size_t)(tramo.y - ventana.y + y) * fila_ventana + (size_t)(tramo.x - ventana.x) * channels,
+               ancho * sizeof(int));
+    }
+}
+
+int refiltrarRegiones(const std::vector<Filtro>& pasos, const Imagen& entrada, const std::vector<Region>& cambios,
+                      Imagen& salida, int tesela) {
+    int width = entrada.getWidth();
+    int height = entrada.getHeight();
+    if (!mismoFormato(entrada, salida)) {
+        // Sin salida anterior valida no hay nada que reusar
+        salida.setMetadata(entrada.getMagic(), width, height, entrada.getMaxColor(), entrada.getChannels());
+        salida.allocatePixels();
+        Region todo = {0, 0, width, height};
+        return refiltrarRegiones(pasos, entrada, std::vector<Region>(1, todo), salida, tesela);
+    }
+
+    // Teselas de la salida a las que llega algun cambio
+    int borde = bordeDe(pasos, width, height);
+    int teselas_x = teselasEn(width, tesela);
+    int teselas_y = teselasEn(height, tesela);
+    std::vector<char> sucia((size_t)teselas_x * teselas_y, 0);
+    for (size_t i = 0; i < cambios.size(); i++) {
+        Region cambio = cambios[i];
+        long x1 = std::min((long)width, (long)cambio.x + cambio.width);
+        long y1 = std::min((long)height, (long)cambio.y + cambio.height);
+        if (cambio.x < 0 || cambio.y < 0 || cambio.x >= x1 || cambio.y >= y1) continue;
+        cambio.width = (int)(x1 - cambio.x);
+        cambio.height = (int)(y1 - cambio.y);
+        Region alcance = expandirRegion(cambio, borde, width, height);
+        for (int ty = alcance.y / tesela; ty <= (alcance.y + alcance.height - 1) / tesela; ty++) {
+            for (int tx = alcance.x / tesela; tx <= (alcance.x + alcance.width - 1) / tesela; tx++) {
+                sucia[(size_t)ty * teselas_x + tx] = 1;
+            }
+        }
+    }
+
+    // Teselas sucias seguidas en una fila de teselas forman un tramo, asi el
+    // borde se filtra una vez por tramo y no una por tesela
+    std::vector<Region> tramos;
+    int num_sucias = 0;
+    for (int ty = 0; ty < teselas_y; ty++) {
+        for (int tx = 0; tx < teselas_x; tx++) {
+            if (!sucia[(size_t)ty * teselas_x + tx]) continue;
+            int fin = tx;
+            while (fin + 1 < teselas_x && sucia[(size_t)ty * teselas_x + fin + 1]) fin++;
+            Region tramo = regionTesela(tx, ty, tesela, width, height);
+            tramo.width = std::min(width, (fin + 1) * tesela) - tramo.x;
+            tramos.push_back(tramo);
+            num_sucias += fin - tx + 1;
+            tx = fin;
+        }
+    }
+    if (num_sucias == 0) return 0;
+
+    Plano plano = entrada.getPlano();
+    int* destino = salida.getPixelsEscritura();
+    if (num_sucias == teselas_x * teselas_y) {
+        // Todo sucio: una sola ventana, sin bordes repetidos
+        Region todo = {0, 0, width, height};
+        filtrarTramo(pasos, plano, 0, todo, destino, true);
+        return num_sucias;
+    }
+
+    int num_tramos = (int)tramos.size();
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < num_tramos; i++) {
+        filtrarTramo(pasos, plano, borde, tramos[i], destino, false);
+    }
+    return num_sucias;
+}
+
+// FNV-1a sobre palabras, como hashImagen, solo sobre la tesela
+static uint64_t hashRegion(const Imagen& imagen, const Region& region) {
+    uint64_t hash = 1469598103934665603ULL;
+    int channels = imagen.getChannels();
+    size_t fila = (size_t)imagen.getWidth() * channels;
+    for (int y = region.y; y < region.y + region.height; y++) {
+        const int* p = imagen.getPixels() + y * fila + (size_t)region.x * channels;
+        for (int i = 0; i < region.width * channels; i++) {
+            hash ^= (uint32_t)p[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+FiltroIncremental::FiltroIncremental(const std::vector<Filtro>& p, int t)
+    : pasos(p), tesela(t > 0 ? t : TESELA_INCREMENTAL), teselas_recalculadas(0) {}
+
+int FiltroIncremental::getNumTeselas() const {
+    return teselasEn(salida.getWidth(), tesela) * teselasEn(salida.getHeight(), tesela);
+}
+
+// Recalcula el hash de las teselas que tocan las regiones
+void FiltroIncremental::hashearTeselas(const Imagen& entrada, const std::vector<Region>& regiones) {
+    int width = entrada.getWidth();
+    int height = entrada.getHeight();
+    int teselas_x = teselasEn(width, tesela);
+    std::vector<int> indices;
+    std::vector<char> marcada(hashes.size(), 0);
+    for (size_t i = 0; i < regiones.size(); i++) {
+        Region r = expandirRegion(regiones[i], 0, width, height);
+        if (r.width <= 0 || r.height <= 0) continue;
+        for (int ty = r.y / tesela; ty <= (r.y + r.height - 1) / tesela; ty++) {
+            for (int tx = r.x / tesela; tx <= (r.x + r.width - 1) / tesela; tx++) {
+                int t = ty * teselas_x + tx;
+                if (!marcada[t]) indices.push_back(t);
+                marcada[t] = 1;
+            }
+        }
+    }
+    int num_indices = (int)indices.size();
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < num_indices; i++) {
+        int t = indices[i];
+        hashes[t] = hashRegion(entrada, regionTesela(t % teselas_x, t / teselas_x, tesela, width, height));
+    }
+}
+
+void FiltroIncremental::actualizar(const Imagen& entrada) {
+    int width = entrada.getWidth();
+    int height = entrada.getHeight();
+    int teselas_x = teselasEn(width, tesela);
+    int num_teselas = teselas_x * teselasEn(height, tesela);
+    Region todo = {0, 0, width, height};
+
+    if (!mismoFormato(entrada, salida) || (int)hashes.size() != num_teselas) {
+        hashes.assign(num_teselas, 0);
+        hashearTeselas(entrada, std::vector<Region>(1, todo));
+        teselas_recalculadas = refiltrarRegiones(pasos, entrada, std::vector<Region>(1, todo), salida, tesela);
+        return;
+    }
+
+    std::vector<uint64_t> nuevos(num_teselas);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int t = 0; t < num_teselas; t++) {
+        nuevos[t] = hashRegion(entrada, regionTesela(t % teselas_x, t / teselas_x, tesela, width, height));
+    }
+    std::vector<Region> cambios;
+    for (int t = 0; t < num_teselas; t++) {
+        if (nuevos[t] != hashes[t]) cambios.push_back(regionTesela(t % teselas_x, t / teselas_x, tesela, width, height));
+    }
+    hashes.swap(nuevos);
+    teselas_recalculadas = refiltrarRegiones(pasos, entrada, cambios, salida, tesela);
+}
+
+void FiltroIncremental::actualizar(const Imagen& entrada, const std::vector<Region>& cambios) {
+    int num_teselas = teselasEn(entrada.getWidth(), tesela) * teselasEn(entrada.getHeight(), tesela);
+    if (!mismoFormato(entrada, salida) || (int)hashes.size() != num_teselas) {
+        actualizar(entrada);
+        return;
+    }
+    hashearTeselas(entrada, cambios);
+    teselas_recalculadas = refiltrarRegiones(pasos, entrada, cambios, salida, tesela);
+}
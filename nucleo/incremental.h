@@ -0,0 +1,56 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+// Refiltrado incremental: cuando la entrada cambia en pocos lugares, solo se
+// recalculan las teselas de la salida a las que llega algun cambio.
+//
+// Un cambio en un pixel solo alcanza a la salida hasta la suma de los radios
+// de los pasos (el borde). Las teselas sucias se juntan en tramos por fila de
+// teselas y cada tramo se filtra sobre una ventana con ese borde alrededor:
+// dentro del tramo el resultado es identico al de filtrar la imagen entera.
+// Los tramos se reparten entre hilos con OpenMP.
+
+#include <cstdint>
+#include <vector>
+
+#include "imagen.h"
+#include "region.h"
+
+#define TESELA_INCREMENTAL 64
+
+// Por cada tesela en la que difieren dos imagenes del mismo tamano, el
+// rectangulo que contiene sus diferencias
+std::vector<Region> regionesCambiadas(const Imagen& anterior, const Imagen& nueva, int tesela = TESELA_INCREMENTAL);
+
+// `salida` es la salida de la cadena sobre la entrada anterior; se recalculan
+// a partir de `entrada` las teselas a las que llegan los cambios. Devuelve
+// cuantas teselas se recalcularon.
+int refiltrarRegiones(const std::vector<Filtro>& pasos, const Imagen& entrada, const std::vector<Region>& cambios,
+                      Imagen& salida, int tesela = TESELA_INCREMENTAL);
+
+// Sesion de refiltrado: guarda la ultima salida y un hash por tesela de la
+// ultima entrada, sin retener la entrada. Sin rectangulos, los cambios se
+// detectan comparando los hashes.
+class FiltroIncremental {
+private:
+    std::vector<Filtro> pasos;
+    int tesela;
+    Imagen salida;
+    std::vector<uint64_t> hashes;
+    int teselas_recalculadas;
+
+    void hashearTeselas(const Imagen& entrada, const std::vector<Region>& regiones);
+
+public:
+    explicit FiltroIncremental(const std::vector<Filtro>& pasos, int tesela = TESELA_INCREMENTAL);
+
+    // La primera vez, o si cambia el tamano o el formato, se filtra todo
+    void actualizar(const Imagen& entrada);
+    void actualizar(const Imagen& entrada, const std::vector<Region>& cambios);
+
+    const Imagen& getSalida() const { return salida; }
+    int getTeselasRecalculadas() const { return teselas_recalculadas; }
+    int getNumTeselas() const;
+};
+
+#endif
@@ -0,0 +1,459 @@
+#ifdef FILTRO_INSTRUMENTAR
+
+#include "instrumentacion.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <mutex>
+#include <vector>
+#ifdef FILTRO_CON_MPI
+#include <mpi.h>
+#endif
+
+static const char* nombresFases[NUM_FASES] = {
+    "lectura", "reserva", "distribucion", "convolucion", "recoleccion", "escritura"
+};
+
+static std::mutex mutex_registro;
+static std::vector<ContadoresHilo*> registro;
+static bool reportado = false;
+
+// Para convertir ticks a segundos: reloj de ticks y steady_clock al empezar
+static uint64_t ticks_inicio;
+static std::chrono::steady_clock::time_point tiempo_inicio;
+
+static thread_local ContadoresHilo* contadores_propios = nullptr;
+
+#define EVENTOS_POR_HILO (1 << 16)
+
+static const char* archivoTraza() {
+    const char* ruta = getenv("FILTRO_TRAZA");
+    return (ruta != nullptr && ruta[0] != '\0') ? ruta : nullptr;
+}
+
+bool traza_activa = archivoTraza() != nullptr;
+
+static bool activarContadoresHW() {
+    const char* valor = getenv("FILTRO_CONTADORES_HW");
+    return valor != nullptr && valor[0] != '\0' && strcmp(valor, "0") != 0;
+}
+
+bool contadores_hw_activos = activarContadoresHW();
+
+// Eventos que se pudieron abrir en algun hilo de este rank
+static bool hw_disponible[NUM_EVENTOS_HW];
+static bool hw_aviso_dado = false;
+
+void registrarEvento(ContadoresHilo& contadores, int fase, uint64_t inicio, uint64_t fin) {
+    if (contadores.eventos == nullptr) {
+        contadores.eventos = new EventoTraza[EVENTOS_POR_HILO];
+    }
+    if (contadores.num_eventos == EVENTOS_POR_HILO) {
+        contadores.descartados++;
+        return;
+    }
+    EventoTraza& e = contadores.eventos[contadores.num_eventos++];
+    e.inicio = inicio;
+    e.fin = fin;
+    e.fase = fase;
+}
+
+ContadoresHilo& contadoresHilo() {
+    if (contadores_propios == nullptr) {
+        ContadoresHilo* c = new ContadoresHilo;
+        memset(c, 0, sizeof(*c));
+
+        if (contadores_hw_activos) {
+            c->grupo_hw = new GrupoContadoresHW();
+            if (!c->grupo_hw->abrir()) {
+                int error = errno;
+                delete c->grupo_hw;
+                c->grupo_hw = nullptr;
+                std::lock_guard<std::mutex> lock(mutex_registro);
+                if (!hw_aviso_dado) {
+                    hw_aviso_dado = true;
+                    fprintf(stderr, "Contadores de hardware no disponibles (perf_event_open: %s); "
+                                    "solo se reportan tiempos\n", strerror(error));
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_registro);
+        if (c->grupo_hw != nullptr) {
+            for (int e = 0; e < NUM_EVENTOS_HW; e++) {
+                if (c->grupo_hw->disponible(e)) hw_disponible[e] = true;
+            }
+        }
+        if (registro.empty()) {
+            tiempo_inicio = std::chrono::steady_clock::now();
+            ticks_inicio = leerReloj();
+            atexit(reportarInstrumentacion);
+        }
+        registro.push_back(c);
+        contadores_propios = c;
+    }
+    return *contadores_propios;
+}
+
+// Segundos por tick, medidos entre el primer registro y ahora
+static double segundosPorTick() {
+    std::chrono::steady_clock::time_point ahora;
+    uint64_t ticks;
+    // Con menos de 10 ms la calibracion es poco precisa
+    do {
+        ahora = std::chrono::steady_clock::now();
+        ticks = leerReloj();
+    } while (ahora - tiempo_inicio < std::chrono::milliseconds(10));
+
+    double segundos = std::chrono::duration<double>(ahora - tiempo_inicio).count();
+    return ticks > ticks_inicio ? segundos / (double)(ticks - ticks_inicio) : 0.0;
+}
+
+// Totales de un rank: segundos, llamadas, elementos y contadores de
+// hardware por fase. Solo doubles, para mandarlo por MPI como un arreglo.
+struct TotalesFase {
+    double segundos[NUM_FASES];
+    double llamadas[NUM_FASES];
+    double elementos[NUM_FASES];
+    double hw[NUM_FASES][NUM_EVENTOS_HW];
+    double hw_disponible[NUM_EVENTOS_HW];
+};
+
+static void imprimirValorHW(double valor, bool disponible) {
+    if (disponible) {
+        fprintf(stderr, " %14.0f", valor);
+    } else {
+        fprintf(stderr, " %14s", "n/d");
+    }
+}
+
+static void imprimirEncabezadoHW(const char* primera) {
+    fprintf(stderr, "%-14s", primera);
+    for (int e = 0; e < NUM_EVENTOS_HW; e++) fprintf(stderr, " %14s", nombreEventoHW(e));
+    fprintf(stderr, " %6s", "IPC");
+}
+
+// Una fila de contadores con el IPC derivado
+static void imprimirFilaHW(const double* valores, const double* disponible) {
+    for (int e = 0; e < NUM_EVENTOS_HW; e++) imprimirValorHW(valores[e], disponible[e] != 0);
+    if (disponible[HW_CICLOS] != 0 && disponible[HW_INSTRUCCIONES] != 0 && valores[HW_CICLOS] > 0) {
+        fprintf(stderr, " %6.2f", valores[HW_INSTRUCCIONES] / valores[HW_CICLOS]);
+    } else {
+        fprintf(stderr, " %6s", "n/d");
+    }
+}
+
+// Por fase (con bytes/pixel = fallos de LLC * 64 / elementos), por hilo y
+// por rank
+static void imprimirTablaHW(const std::vector<ContadoresHilo*>& hilos, const TotalesFase& total,
+                            const std::vector<TotalesFase>& ranks) {
+    const double* disponible = total.hw_disponible;
+
+    fprintf(stderr, "\nContadores de hardware por fase:\n");
+    imprimirEncabezadoHW("fase");
+    fprintf(stderr, " %11s\n", "bytes/pixel");
+    for (int f = 0; f < NUM_FASES; f++) {
+        if (total.llamadas[f] == 0) continue;
+        fprintf(stderr, "%-14s", nombresFases[f]);
+        imprimirFilaHW(total.hw[f], disponible);
+        if (disponible[HW_FALLOS_LLC] != 0 && total.elementos[f] > 0) {
+            fprintf(stderr, " %11.3f\n", total.hw[f][HW_FALLOS_LLC] * 64.0 / total.elementos[f]);
+        } else {
+            fprintf(stderr, " %11s\n", "n/d");
+        }
+    }
+
+    if (hilos.size() > 1) {
+        fprintf(stderr, "\nContadores por hilo:\n");
+        imprimirEncabezadoHW("hilo");
+        fprintf(stderr, "\n");
+        for (size_t h = 0; h < hilos.size(); h++) {
+            double suma[NUM_EVENTOS_HW] = {0};
+            for (int f = 0; f < NUM_FASES; f++) {
+                for (int e = 0; e < NUM_EVENTOS_HW; e++) suma[e] += (double)hilos[h]->hw[f][e];
+            }
+            fprintf(stderr, "%-14zu", h);
+            imprimirFilaHW(suma, disponible);
+            fprintf(stderr, "\n");
+        }
+    }
+
+    if (ranks.size() > 1) {
+        fprintf(stderr, "\nContadores por rank:\n");
+        imprimirEncabezadoHW("rank");
+        fprintf(stderr, "\n");
+        for (size_t r = 0; r < ranks.size(); r++) {
+            double suma[NUM_EVENTOS_HW] = {0};
+            for (int f = 0; f < NUM_FASES; f++) {
+                for (int e = 0; e < NUM_EVENTOS_HW; e++) suma[e] += ranks[r].hw[f][e];
+            }
+            fprintf(stderr, "%-14zu", r);
+            imprimirFilaHW(suma, ranks[r].hw_disponible);
+            fprintf(stderr, "\n");
+        }
+    }
+}
+
+// ", "hw": {...}" con null para los eventos no disponibles
+static void escribirHW(FILE* out, const double* valores, const double* disponible) {
+    fprintf(out, ", \"hw\": {");
+    for (int e = 0; e < NUM_EVENTOS_HW; e++) {
+        if (disponible[e] != 0) {
+            fprintf(out, "%s\"%s\": %.0f", e ? ", " : "", nombreEventoHW(e), valores[e]);
+        } else {
+            fprintf(out, "%s\"%s\": null", e ? ", " : "", nombreEventoHW(e));
+        }
+    }
+    fprintf(out, "}");
+}
+
+static void imprimirTabla(const std::vector<ContadoresHilo*>& hilos, const TotalesFase& total, double seg_tick) {
+    double suma = 0;
+    for (int f = 0; f < NUM_FASES; f++) suma += total.segundos[f];
+
+    fprintf(stderr, "%-14s %10s %14s %12s %7s\n", "fase", "llamadas", "elementos", "total ms", "%");
+    for (int f = 0; f < NUM_FASES; f++) {
+        if (total.llamadas[f] == 0) continue;
+        fprintf(stderr, "%-14s %10.0f %14.0f %12.3f %6.1f%%\n", nombresFases[f], total.llamadas[f],
+                total.elementos[f], total.segundos[f] * 1e3, suma > 0 ? 100.0 * total.segundos[f] / suma : 0.0);
+    }
+
+    if (hilos.size() > 1) {
+        fprintf(stderr, "\nPor hilo (ms):\n%-6s", "hilo");
+        for (int f = 0; f < NUM_FASES; f++) fprintf(stderr, " %12s", nombresFases[f]);
+        fprintf(stderr, "\n");
+        for (size_t h = 0; h < hilos.size(); h++) {
+            fprintf(stderr, "%-6zu", h);
+            for (int f = 0; f < NUM_FASES; f++) fprintf(stderr, " %12.3f", hilos[h]->ticks[f] * seg_tick * 1e3);
+            fprintf(stderr, "\n");
+        }
+    }
+}
+
+static void escribirJSON(const std::vector<ContadoresHilo*>& hilos, const TotalesFase& total, double seg_tick,
+                         const std::vector<TotalesFase>& ranks) {
+    const char* ruta = getenv("FILTRO_INSTRUMENTACION");
+    if (ruta == nullptr || ruta[0] == '\0') ruta = "instrumentacion.json";
+    FILE* out = fopen(ruta, "w");
+    if (out == NULL) {
+        std::cerr << "Error creating instrumentation report: " << ruta << std::endl;
+        return;
+    }
+
+    fprintf(out, "{\n  \"fases\": {");
+    for (int f = 0; f < NUM_FASES; f++) {
+        fprintf(out, "%s\n    \"%s\": {\"llamadas\": %.0f, \"elementos\": %.0f, \"segundos\": %.9f",
+                f ? "," : "", nombresFases[f], total.llamadas[f], total.elementos[f], total.segundos[f]);
+        if (contadores_hw_activos) escribirHW(out, total.hw[f], total.hw_disponible);
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  },\n  \"hilos\": [");
+    for (size_t h = 0; h < hilos.size(); h++) {
+        fprintf(out, "%s\n    {\"hilo\": %zu", h ? "," : "", h);
+        for (int f = 0; f < NUM_FASES; f++) {
+            fprintf(out, ", \"%s\": %.9f", nombresFases[f], hilos[h]->ticks[f] * seg_tick);
+        }
+        if (contadores_hw_activos) {
+            double suma[NUM_EVENTOS_HW] = {0};
+            for (int f = 0; f < NUM_FASES; f++) {
+                for (int e = 0; e < NUM_EVENTOS_HW; e++) suma[e] += (double)hilos[h]->hw[f][e];
+            }
+            escribirHW(out, suma, total.hw_disponible);
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ],\n  \"ranks\": [");
+    for (size_t r = 0; r < ranks.size(); r++) {
+        fprintf(out, "%s\n    {\"rank\": %zu", r ? "," : "", r);
+        for (int f = 0; f < NUM_FASES; f++) {
+            fprintf(out, ", \"%s\": %.9f", nombresFases[f], ranks[r].segundos[f]);
+        }
+        if (contadores_hw_activos) {
+            double suma[NUM_EVENTOS_HW] = {0};
+            for (int f = 0; f < NUM_FASES; f++) {
+                for (int e = 0; e < NUM_EVENTOS_HW; e++) suma[e] += ranks[r].hw[f][e];
+            }
+            escribirHW(out, suma, ranks[r].hw_disponible);
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+}
+
+// Eventos de un rank aplanados para el Gatherv: hilo, fase, inicio y duracion
+// en microsegundos desde `referencia`
+static std::vector<double> aplanarEventos(const std::vector<ContadoresHilo*>& hilos, double seg_tick,
+                                          uint64_t referencia) {
+    std::vector<double> datos;
+    for (size_t h = 0; h < hilos.size(); h++) {
+        for (uint32_t i = 0; i < hilos[h]->num_eventos; i++) {
+            const EventoTraza& e = hilos[h]->eventos[i];
+            datos.push_back((double)h);
+            datos.push_back((double)e.fase);
+            datos.push_back(((double)e.inicio - (double)referencia) * seg_tick * 1e6);
+            datos.push_back((double)(e.fin - e.inicio) * seg_tick * 1e6);
+        }
+    }
+    return datos;
+}
+
+// `eventos[r]` tiene los eventos aplanados del rank r
+static void escribirTraza(const std::vector<std::vector<double> >& eventos) {
+    const char* ruta = archivoTraza();
+    FILE* out = fopen(ruta, "w");
+    if (out == NULL) {
+        std::cerr << "Error creating trace file: " << ruta << std::endl;
+        return;
+    }
+
+    // Los tiempos arrancan en 0 con el primer evento
+    double origen = 0;
+    bool hay = false;
+    for (size_t r = 0; r < eventos.size(); r++) {
+        for (size_t i = 0; i < eventos[r].size(); i += 4) {
+            if (!hay || eventos[r][i + 2] < origen) origen = eventos[r][i + 2];
+            hay = true;
+        }
+    }
+
+    fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    bool primero = true;
+    for (size_t r = 0; r < eventos.size(); r++) {
+        fprintf(out, "%s\n{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": %zu, \"args\": {\"name\": \"rank %zu\"}}",
+                primero ? "" : ",", r, r);
+        primero = false;
+        int max_hilo = -1;
+        for (size_t i = 0; i < eventos[r].size(); i += 4) {
+            int hilo = (int)eventos[r][i];
+            if (hilo > max_hilo) max_hilo = hilo;
+            fprintf(out, ",\n{\"ph\": \"X\", \"name\": \"%s\", \"pid\": %zu, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                    nombresFases[(int)eventos[r][i + 1]], r, hilo, eventos[r][i + 2] - origen, eventos[r][i + 3]);
+        }
+        for (int h = 0; h <= max_hilo; h++) {
+            fprintf(out, ",\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": %zu, \"tid\": %d, \"args\": {\"name\": \"hilo %d\"}}",
+                    r, h, h);
+        }
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+}
+
+void reportarInstrumentacion() {
+    std::vector<ContadoresHilo*> hilos;
+    {
+        std::lock_guard<std::mutex> lock(mutex_registro);
+        if (reportado) return;
+        reportado = true;
+        hilos = registro;
+    }
+    double seg_tick = hilos.empty() ? 0.0 : segundosPorTick();
+
+    TotalesFase total;
+    memset(&total, 0, sizeof(total));
+    for (size_t h = 0; h < hilos.size(); h++) {
+        for (int f = 0; f < NUM_FASES; f++) {
+            total.segundos[f] += hilos[h]->ticks[f] * seg_tick;
+            total.llamadas[f] += (double)hilos[h]->llamadas[f];
+            total.elementos[f] += (double)hilos[h]->elementos[f];
+            for (int e = 0; e < NUM_EVENTOS_HW; e++) total.hw[f][e] += (double)hilos[h]->hw[f][e];
+        }
+    }
+    for (int e = 0; e < NUM_EVENTOS_HW; e++) total.hw_disponible[e] = hw_disponible[e] ? 1.0 : 0.0;
+
+    int rank = 0, size = 1;
+    std::vector<TotalesFase> ranks(1, total);
+    uint32_t descartados = 0;
+    for (size_t h = 0; h < hilos.size(); h++) descartados += hilos[h]->descartados;
+    std::vector<std::vector<double> > eventos(1);
+    if (traza_activa) eventos[0] = aplanarEventos(hilos, seg_tick, ticks_inicio);
+#ifdef FILTRO_CON_MPI
+    int inicializado = 0, finalizado = 0;
+    MPI_Initialized(&inicializado);
+    MPI_Finalized(&finalizado);
+    if (inicializado && !finalizado) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+        ranks.resize(rank == 0 ? size : 1);
+        int n = sizeof(TotalesFase) / sizeof(double);
+        MPI_Gather(&total, n, MPI_DOUBLE, ranks.data(), n, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+        if (traza_activa) {
+            // Todos los ranks salen de la barrera casi a la vez: ese instante
+            // es el origen comun de tiempos
+            MPI_Barrier(MPI_COMM_WORLD);
+            std::vector<double> propios = aplanarEventos(hilos, seg_tick, leerReloj());
+            int cantidad = (int)propios.size();
+            std::vector<int> cantidades(size), desplazamientos(size);
+            MPI_Gather(&cantidad, 1, MPI_INT, cantidades.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+            std::vector<double> todos;
+            if (rank == 0) {
+                int suma = 0;
+                for (int r = 0; r < size; r++) {
+                    desplazamientos[r] = suma;
+                    suma += cantidades[r];
+                }
+                todos.resize(suma > 0 ? suma : 1);
+            }
+            MPI_Gatherv(propios.data(), cantidad, MPI_DOUBLE, todos.data(), cantidades.data(),
+                        desplazamientos.data(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+            if (rank == 0) {
+                eventos.assign(size, std::vector<double>());
+                for (int r = 0; r < size; r++) {
+                    eventos[r].assign(todos.begin() + desplazamientos[r],
+                                      todos.begin() + desplazamientos[r] + cantidades[r]);
+                }
+            }
+            uint32_t total_descartados = 0;
+            MPI_Reduce(&descartados, &total_descartados, 1, MPI_UINT32_T, MPI_SUM, 0, MPI_COMM_WORLD);
+            descartados = total_descartados;
+        }
+    }
+#endif
+    if (rank != 0) return;
+
+    fprintf(stderr, "\n== Instrumentacion: %d rank(s), %zu hilo(s) en el raiz ==\n", size, hilos.size());
+    imprimirTabla(hilos, total, seg_tick);
+
+    if (size > 1) {
+        // Desbalance = max / promedio: 1.0 es reparto perfecto
+        fprintf(stderr, "\nPor rank (ms):\n%-14s %10s %10s %10s %11s\n", "fase", "min", "prom", "max", "desbalance");
+        for (int f = 0; f < NUM_FASES; f++) {
+            double minimo = ranks[0].segundos[f], maximo = minimo, suma = 0;
+            for (int r = 0; r < size; r++) {
+                double s = ranks[r].segundos[f];
+                if (s < minimo) minimo = s;
+                if (s > maximo) maximo = s;
+                suma += s;
+            }
+            if (maximo == 0) continue;
+            double promedio = suma / size;
+            fprintf(stderr, "%-14s %10.3f %10.3f %10.3f %11.2f\n", nombresFases[f],
+                    minimo * 1e3, promedio * 1e3, maximo * 1e3, maximo / promedio);
+        }
+    }
+
+    if (contadores_hw_activos) {
+        // Un evento se muestra si algun rank lo pudo abrir
+        for (size_t r = 1; r < ranks.size(); r++) {
+            for (int e = 0; e < NUM_EVENTOS_HW; e++) {
+                if (ranks[r].hw_disponible[e] != 0) total.hw_disponible[e] = 1.0;
+            }
+        }
+        imprimirTablaHW(hilos, total, ranks);
+    }
+
+    escribirJSON(hilos, total, seg_tick, ranks);
+
+    if (traza_activa) {
+        escribirTraza(eventos);
+        if (descartados > 0) {
+            fprintf(stderr, "Traza: %u eventos descartados (buffer lleno)\n", descartados);
+        }
+    }
+}
+
+#endif
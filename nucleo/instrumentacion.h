@@ -0,0 +1,127 @@
+#ifndef INSTRUMENTACION_H
+#define INSTRUMENTACION_H
+
+// Instrumentacion de las fases del camino caliente. Solo existe si se compila
+// con FILTRO_INSTRUMENTAR; si no, las macros no generan codigo.
+//
+//   MEDIR_FASE(FASE_CONVOLUCION);            // mide hasta el fin del bloque
+//   MEDIR_FASE_N(FASE_LECTURA, muestras);    // ademas cuenta elementos
+//
+// Cada hilo acumula en sus propios contadores (sin locks). Al salir del
+// programa se imprime un reporte en stderr y se escribe en JSON en el archivo
+// de la variable FILTRO_INSTRUMENTACION (por defecto instrumentacion.json).
+// Con MPI el reporte lo arma el raiz con los contadores de todos los ranks.
+//
+// Si ademas se define la variable FILTRO_TRAZA=<archivo>, cada medicion se
+// guarda como evento en un buffer propio del hilo y al salir se escribe una
+// traza en formato Chrome (chrome://tracing, ui.perfetto.dev) con un proceso
+// por rank y una fila por hilo.
+//
+// Con FILTRO_CONTADORES_HW=1 cada hilo abre ademas un grupo de contadores
+// de hardware (contadores_hw.h) y cada fase acumula ciclos, instrucciones y
+// fallos de LLC, dTLB y pagina. Si perf_event_open no esta disponible (p. ej.
+// en un contenedor) se avisa una vez y se reportan solo los tiempos.
+
+enum FaseInstrumentada {
+    FASE_LECTURA,       // parseo del archivo de entrada
+    FASE_RESERVA,       // pedido de buffers de pixeles
+    FASE_DISTRIBUCION,  // envio de franjas a los ranks
+    FASE_CONVOLUCION,   // filtrarFilas
+    FASE_RECOLECCION,   // recoleccion de franjas en el raiz
+    FASE_ESCRITURA,     // formato y escritura del archivo de salida
+    NUM_FASES
+};
+
+#ifdef FILTRO_INSTRUMENTAR
+
+#include <cstdint>
+#include <chrono>
+#include "contadores_hw.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Ticks del reloj mas barato disponible (TSC en x86, steady_clock si no)
+inline uint64_t leerReloj() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct EventoTraza {
+    uint64_t inicio;
+    uint64_t fin;
+    int fase;
+};
+
+struct ContadoresHilo {
+    uint64_t ticks[NUM_FASES];
+    uint64_t llamadas[NUM_FASES];
+    uint64_t elementos[NUM_FASES];
+
+    // Solo con FILTRO_CONTADORES_HW y si se pudo abrir el grupo
+    GrupoContadoresHW* grupo_hw;
+    uint64_t hw[NUM_FASES][NUM_EVENTOS_HW];
+
+    // Solo con la traza activa; cuando se llena se descartan eventos
+    EventoTraza* eventos;
+    uint32_t num_eventos;
+    uint32_t descartados;
+};
+
+// Contadores del hilo actual (se registran la primera vez)
+ContadoresHilo& contadoresHilo();
+
+extern bool traza_activa;
+extern bool contadores_hw_activos;
+void registrarEvento(ContadoresHilo& contadores, int fase, uint64_t inicio, uint64_t fin);
+
+class MedicionFase {
+private:
+    ContadoresHilo& contadores;
+    FaseInstrumentada fase;
+    uint64_t inicio;
+    uint64_t hw_inicio[NUM_EVENTOS_HW];
+
+public:
+    MedicionFase(FaseInstrumentada f, uint64_t n = 0) : contadores(contadoresHilo()), fase(f), inicio(0) {
+        contadores.elementos[fase] += n;
+        if (contadores_hw_activos && contadores.grupo_hw != nullptr) contadores.grupo_hw->leer(hw_inicio);
+        inicio = leerReloj();
+    }
+
+    ~MedicionFase() {
+        uint64_t fin = leerReloj();
+        contadores.ticks[fase] += fin - inicio;
+        contadores.llamadas[fase]++;
+        if (traza_activa) registrarEvento(contadores, fase, inicio, fin);
+        if (contadores_hw_activos && contadores.grupo_hw != nullptr) {
+            uint64_t hw_fin[NUM_EVENTOS_HW];
+            contadores.grupo_hw->leer(hw_fin);
+            for (int e = 0; e < NUM_EVENTOS_HW; e++) contadores.hw[fase][e] += hw_fin[e] - hw_inicio[e];
+        }
+    }
+};
+
+// Imprime y guarda el reporte. Se llama sola al salir; con MPI hay que
+// llamarla antes de MPI_Finalize (lo hace el backend MPI). Solo la primera
+// llamada tiene efecto.
+void reportarInstrumentacion();
+
+#define FILTRO_CONCATENAR2(a, b) a##b
+#define FILTRO_CONCATENAR(a, b) FILTRO_CONCATENAR2(a, b)
+#define MEDIR_FASE(fase) MedicionFase FILTRO_CONCATENAR(medicion_, __LINE__)(fase)
+#define MEDIR_FASE_N(fase, n) MedicionFase FILTRO_CONCATENAR(medicion_, __LINE__)(fase, (uint64_t)(n))
+#define REPORTAR_INSTRUMENTACION() reportarInstrumentacion()
+
+#else
+
+#define MEDIR_FASE(fase) ((void)0)
+#define MEDIR_FASE_N(fase, n) ((void)0)
+#define REPORTAR_INSTRUMENTACION() ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,352 @@
+#include "piramide.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <sys/stat.h>
+
+#include "instrumentacion.h"
+
+// Binomial [1 4 6 4 1]/16: varianza 1 en unidades del nivel que filtra
+static const int binomial[5] = {1, 4, 6, 4, 1};
+
+static int contarNiveles(int width, int height) {
+    int niveles = 1;
+    while (width > 1 || height > 1) {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        niveles++;
+    }
+    return niveles;
+}
+
+// Suma de los pesos del binomial que caen dentro de [0, n) alrededor de i
+static int pesoDentro(int i, int n) {
+    int peso = 0;
+    for (int k = -2; k <= 2; k++) {
+        if (i + k >= 0 && i + k < n) peso += binomial[k + 2];
+    }
+    return peso;
+}
+
+// Filtra con el binomial y se queda con filas y columnas pares
+static void reducir(const Imagen& entrada, Imagen& salida) {
+    int width = entrada.getWidth();
+    int height = entrada.getHeight();
+    int channels = entrada.getChannels();
+    int w2 = (width + 1) / 2;
+    int h2 = (height + 1) / 2;
+    salida.setMetadata(channels == 3 ? "P6" : "P5", w2, h2, entrada.getMaxColor(), channels);
+    salida.allocatePixels();
+
+    const int* pixels = entrada.getPixels();
+    int* destino = salida.getPixelsEscritura();
+    long fila_entrada = (long)width * channels;
+    long fila_salida = (long)w2 * channels;
+
+    // Pasada horizontal sin normalizar (hasta 16 * max_color)
+    std::vector<int> medio((size_t)height * fila_salida);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int y = 0; y < height; y++) {
+        const int* fila = pixels + y * fila_entrada;
+        int* salida_fila = medio.data() + y * fila_salida;
+        for (int x2 = 0; x2 < w2; x2++) {
+            int x = 2 * x2;
+            for (int c = 0; c < channels; c++) {
+                int sum = 0;
+                for (int k = -2; k <= 2; k++) {
+                    if (x + k >= 0 && x + k < width) sum += binomial[k + 2] * fila[(x + k) * channels + c];
+                }
+                salida_fila[x2 * channels + c] = sum;
+            }
+        }
+    }
+
+    std::vector<int> peso_x(w2);
+    for (int x2 = 0; x2 < w2; x2++) peso_x[x2] = pesoDentro(2 * x2, width);
+
+    // Pasada vertical y normalizacion por los pesos que cayeron dentro
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int y2 = 0; y2 < h2; y2++) {
+        int y = 2 * y2;
+        int peso_y = pesoDentro(y, height);
+        int* salida_fila = destino + y2 * fila_salida;
+        for (int x2 = 0; x2 < w2; x2++) {
+            int peso = peso_x[x2] * peso_y;
+            for (int c = 0; c < channels; c++) {
+                int sum = 0;
+                for (int k = -2; k <= 2; k++) {
+                    if (y + k >= 0 && y + k < height) {
+                        sum += binomial[k + 2] * medio[(y + k) * fila_salida + x2 * channels + c];
+                    }
+                }
+                salida_fila[x2 * channels + c] = (sum + peso / 2) / peso;
+            }
+        }
+    }
+}
+
+void Piramide::construir(const Imagen& fuente) {
+    niveles.clear();
+    int total = contarNiveles(fuente.getWidth(), fuente.getHeight());
+    niveles.reserve(total);
+    niveles.push_back(fuente.copiar());
+    for (int k = 1; k < total; k++) {
+        Imagen siguiente;
+        reducir(niveles[k - 1], siguiente);
+        niveles.push_back(std::move(siguiente));
+    }
+}
+
+static std::string archivoNivel(const std::string& prefijo, int k, int channels) {
+    return prefijo + "_" + std::to_string(k) + (channels == 3 ? ".ppm" : ".pgm");
+}
+
+bool Piramide::cargar(const Imagen& fuente, const std::string& prefijo) {
+    niveles.clear();
+    int total = contarNiveles(fuente.getWidth(), fuente.getHeight());
+    niveles.reserve(total);
+    niveles.push_back(fuente.copiar());
+
+    int width = fuente.getWidth();
+    int height = fuente.getHeight();
+    for (int k = 1; k < total; k++) {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        std::string ruta = archivoNivel(prefijo, k, fuente.getChannels());
+        struct stat info;
+        Imagen nivel;
+        if (stat(ruta.c_str(), &info) != 0 || !nivel.cargarDesdeArchivo(ruta.c_str())) {
+            niveles.clear();
+            return false;
+        }
+        if (nivel.getWidth() != width || nivel.getHeight() != height ||
+            nivel.getChannels() != fuente.getChannels() || nivel.getMaxColor() != fuente.getMaxColor()) {
+            niveles.clear();
+            return false;
+        }
+        niveles.push_back(std::move(nivel));
+    }
+    return true;
+}
+
+bool Piramide::guardar(const std::string& prefijo) const {
+    for (int k = 1; k < getNumNiveles(); k++) {
+        // Primero a un temporal, para que otra ejecucion nunca lea un nivel
+        // a medio escribir
+        std::string ruta = archivoNivel(prefijo, k, niveles[k].getChannels());
+        std::string temporal = ruta + ".tmp";
+        if (!niveles[k].guardarEnArchivo(temporal.c_str())) return false;
+        if (rename(temporal.c_str(), ruta.c_str()) != 0) {
+            std::cout << "Error writing pyramid level: " << ruta << std::endl;
+            remove(temporal.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t hashImagen(const Imagen& imagen) {
+    // FNV-1a sobre palabras en lugar de bytes
+    uint64_t hash = 1469598103934665603ULL;
+    const uint64_t primo = 1099511628211ULL;
+    hash = (hash ^ (uint64_t)imagen.getWidth()) * primo;
+    hash = (hash ^ (uint64_t)imagen.getHeight()) * primo;
+    hash = (hash ^ (uint64_t)imagen.getChannels()) * primo;
+    hash = (hash ^ (uint64_t)imagen.getMaxColor()) * primo;
+    const int* pixels = imagen.getPixels();
+    for (int i = 0; i < imagen.getPixelCount(); i++) {
+        hash = (hash ^ (uint32_t)pixels[i]) * primo;
+    }
+    return hash;
+}
+
+CachePiramides::CachePiramides(const char* dir) {
+    if (dir != nullptr && dir[0] != '\0') {
+        directorio = dir;
+        mkdir(dir, 0755);
+    }
+}
+
+std::shared_ptr<const Piramide> CachePiramides::obtener(const Imagen& fuente) {
+    uint64_t hash = hashImagen(fuente);
+    std::map<uint64_t, std::shared_ptr<Piramide>>::iterator it = en_memoria.find(hash);
+    if (it != en_memoria.end()) return it->second;
+
+    std::shared_ptr<Piramide> piramide = std::make_shared<Piramide>();
+    if (!directorio.empty()) {
+        char nombre[32];
+        snprintf(nombre, sizeof(nombre), "%016llx", (unsigned long long)hash);
+        std::string prefijo = directorio + "/" + nombre;
+        if (!piramide->cargar(fuente, prefijo)) {
+            piramide->construir(fuente);
+            piramide->guardar(prefijo);
+        }
+    } else {
+        piramide->construir(fuente);
+    }
+    en_memoria[hash] = piramide;
+    return piramide;
+}
+
+// Gaussiana separable de desviacion sigma (en muestras del plano), con los
+// pesos renormalizados en los bordes. El resultado queda en punto flotante.
+static void gaussianaSeparable(const Imagen& entrada, double sigma, std::vector<float>& salida) {
+    int width = entrada.getWidth();
+    int height = entrada.getHeight();
+    int channels = entrada.getChannels();
+    long fila = (long)width * channels;
+    const int* pixels = entrada.getPixels();
+
+    int radio = (int)std::ceil(3.0 * sigma);
+    std::vector<float> pesos(2 * radio + 1);
+    for (int k = -radio; k <= radio; k++) {
+        pesos[k + radio] = (float)std::exp(-(double)k * k / (2.0 * sigma * sigma));
+    }
+
+    std::vector<float> medio((size_t)height * fila);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int y = 0; y < height; y++) {
+        const int* origen = pixels + y * fila;
+        float* destino = medio.data() + y * fila;
+        for (int x = 0; x < width; x++) {
+            int desde = x - radio < 0 ? -x : -radio;
+            int hasta = x + radio >= width ? width - 1 - x : radio;
+            float peso = 0;
+            for (int k = desde; k <= hasta; k++) peso += pesos[k + radio];
+            for (int c = 0; c < channels; c++) {
+                float sum = 0;
+                for (int k = desde; k <= hasta; k++) sum += pesos[k + radio] * origen[(x + k) * channels + c];
+                destino[x * channels + c] = sum / peso;
+            }
+        }
+    }
+
+    salida.assign((size_t)height * fila, 0.0f);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int y = 0; y < height; y++) {
+        int desde = y - radio < 0 ? -y : -radio;
+        int hasta = y + radio >= height ? height - 1 - y : radio;
+        float peso = 0;
+        for (int k = desde; k <= hasta; k++) peso += pesos[k + radio];
+        float* destino = salida.data() + y * fila;
+        // Fila por fila de la ventana, para recorrer la memoria en orden
+        for (int k = desde; k <= hasta; k++) {
+            const float* origen = medio.data() + (y + k) * fila;
+            float p = pesos[k + radio] / peso;
+            for (long i = 0; i < fila; i++) destino[i] += p * origen[i];
+        }
+    }
+}
+
+static inline int redondear(float valor, int max_color) {
+    int v = (int)(valor + 0.5f);
+    if (v < 0) v = 0;
+    if (v > max_color) v = max_color;
+    return v;
+}
+
+// Nivel mas grueso que deja un desenfoque residual de al menos 1 muestra.
+// Varianzas en pixeles de la fuente: la piramide hasta el nivel L aporta
+// (4^L - 1) / 3 y la interpolacion bilineal de vuelta 4^L / 6.
+static int elegirNivel(double sigma, int num_niveles, double& residual) {
+    double varianza = sigma * sigma;
+    int nivel = 0;
+    for (int k = 1; k < num_niveles; k++) {
+        double escala = std::ldexp(1.0, 2 * k);
+        if (varianza < (escala - 1) / 3 + escala * 7 / 6) break;
+        nivel = k;
+    }
+    if (nivel == 0) {
+        residual = sigma;
+    } else {
+        double escala = std::ldexp(1.0, 2 * nivel);
+        residual = std::sqrt((varianza - (escala - 1) / 3 - escala / 6) / escala);
+    }
+    return nivel;
+}
+
+bool desenfoqueGaussiano(const Imagen& fuente, double sigma, Imagen& destino, CachePiramides* cache) {
+    if (!(sigma >= 0)) {
+        std::cout << "Invalid sigma: " << sigma << std::endl;
+        return false;
+    }
+    if (sigma == 0 || fuente.getPixelCount() == 0) {
+        destino.copiarDesde(fuente);
+        return true;
+    }
+    MEDIR_FASE_N(FASE_CONVOLUCION, fuente.getPixelCount());
+
+    double residual;
+    int nivel = elegirNivel(sigma, contarNiveles(fuente.getWidth(), fuente.getHeight()), residual);
+
+    std::shared_ptr<const Piramide> piramide;
+    if (nivel > 0) {
+        if (cache != nullptr) {
+            piramide = cache->obtener(fuente);
+        } else {
+            std::shared_ptr<Piramide> propia = std::make_shared<Piramide>();
+            propia->construir(fuente);
+            piramide = propia;
+        }
+    }
+    const Imagen& base = nivel > 0 ? piramide->nivel(nivel) : fuente;
+
+    std::vector<float> suave;
+    gaussianaSeparable(base, residual, suave);
+
+    int width = fuente.getWidth();
+    int height = fuente.getHeight();
+    int channels = fuente.getChannels();
+    int max_color = fuente.getMaxColor();
+    destino.setMetadata(fuente.getMagic(), width, height, max_color, channels);
+    destino.allocatePixels();
+    int* salida = destino.getPixelsEscritura();
+
+    if (nivel == 0) {
+        for (int i = 0; i < fuente.getPixelCount(); i++) salida[i] = redondear(suave[i], max_color);
+        return true;
+    }
+
+    // Interpolacion bilineal: el pixel x cae en x / 2^nivel del nivel base
+    int base_w = base.getWidth();
+    int base_h = base.getHeight();
+    long base_fila = (long)base_w * channels;
+    float escala = 1.0f / (float)(1 << nivel);
+    std::vector<int> x0(width), x1(width);
+    std::vector<float> fx(width);
+    for (int x = 0; x < width; x++) {
+        float u = x * escala;
+        x0[x] = (int)u;
+        x1[x] = x0[x] + 1 < base_w ? x0[x] + 1 : base_w - 1;
+        fx[x] = u - x0[x];
+    }
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int y = 0; y < height; y++) {
+        float v = y * escala;
+        int y0 = (int)v;
+        int y1 = y0 + 1 < base_h ? y0 + 1 : base_h - 1;
+        float fy = v - y0;
+        const float* arriba = suave.data() + y0 * base_fila;
+        const float* abajo = suave.data() + y1 * base_fila;
+        int* fila = salida + (long)y * width * channels;
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < channels; c++) {
+                float a = arriba[x0[x] * channels + c] + fx[x] * (arriba[x1[x] * channels + c] - arriba[x0[x] * channels + c]);
+                float b = abajo[x0[x] * channels + c] + fx[x] * (abajo[x1[x] * channels + c] - abajo[x0[x] * channels + c]);
+                fila[x * channels + c] = redondear(a + fy * (b - a), max_color);
+            }
+        }
+    }
+    return true;
+}
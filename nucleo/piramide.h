@@ -0,0 +1,62 @@
+#ifndef PIRAMIDE_H
+#define PIRAMIDE_H
+
+// Piramide gaussiana y desenfoque gaussiano de sigma arbitrario.
+//
+// El nivel 0 es la imagen fuente; cada nivel siguiente se obtiene filtrando
+// el anterior con el binomial separable [1 4 6 4 1]/16 y quedandose con las
+// filas y columnas pares, asi que la muestra i del nivel k cae sobre el pixel
+// i * 2^k de la fuente. Todos los niveles cuestan 4/3 de la imagen.
+//
+// Un desenfoque de sigma grande se resuelve en el nivel mas grueso que
+// todavia deja un desenfoque residual de al menos 1 muestra, y se vuelve a la
+// resolucion original con interpolacion bilineal: el costo queda casi
+// constante por pixel, sin importar sigma.
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "imagen.h"
+
+class Piramide {
+private:
+    std::vector<Imagen> niveles;
+
+public:
+    // Construye todos los niveles hasta que un lado llega a 1
+    void construir(const Imagen& fuente);
+
+    // Niveles 1..n en archivos <prefijo>_<k>.pgm/ppm (binarios). cargar()
+    // falla si falta algun nivel o no coincide con el tamano esperado.
+    bool cargar(const Imagen& fuente, const std::string& prefijo);
+    bool guardar(const std::string& prefijo) const;
+
+    int getNumNiveles() const { return (int)niveles.size(); }
+    const Imagen& nivel(int k) const { return niveles[k]; }
+};
+
+// Hash de las dimensiones y los pixeles, para identificar la fuente
+uint64_t hashImagen(const Imagen& imagen);
+
+// Piramides ya construidas, por hash de la fuente. Con directorio, los
+// niveles tambien se guardan en disco y sirven para otras ejecuciones.
+class CachePiramides {
+private:
+    std::map<uint64_t, std::shared_ptr<Piramide>> en_memoria;
+    std::string directorio;
+
+public:
+    explicit CachePiramides(const char* dir = nullptr);
+
+    std::shared_ptr<const Piramide> obtener(const Imagen& fuente);
+};
+
+// Desenfoque gaussiano de desviacion sigma, en pixeles de la fuente. Los
+// pixeles fuera de la imagen no se usan y los pesos se renormalizan, como en
+// los filtros 3x3. Sin cache la piramide se construye y se descarta.
+bool desenfoqueGaussiano(const Imagen& fuente, double sigma, Imagen& destino, CachePiramides* cache);
+
+#endif
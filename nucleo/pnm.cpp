@@ -0,0 +1,578 @@
+#include "pnm.h"
+
+#include <iostream>
+#include <cstring>
+#include <climits>
+#include <vector>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Por hilo: en filtro_lote cada worker carga sus imagenes secuencialmente
+// mientras el principal usa todos los hilos en las grandes
+static thread_local int hilos_pnm = 0;
+
+void configurarHilosPNM(int num_threads) {
+    hilos_pnm = num_threads;
+}
+
+static int hilosPNM() {
+    if (hilos_pnm > 0) return hilos_pnm;
+    long en_linea = sysconf(_SC_NPROCESSORS_ONLN);
+    return en_linea > 0 ? (int)en_linea : 1;
+}
+
+template <typename Funcion>
+struct TareaPNM {
+    Funcion* funcion;
+    int indice;
+};
+
+template <typename Funcion>
+static void* ejecutarTareaPNM(void* arg) {
+    TareaPNM<Funcion>* tarea = (TareaPNM<Funcion>*)arg;
+    (*tarea->funcion)(tarea->indice);
+    return NULL;
+}
+
+// Llama funcion(i) para i en [0, n), cada una en su hilo; la 0 en el actual
+template <typename Funcion>
+static void enParalelo(int n, Funcion& funcion) {
+    std::vector<pthread_t> hilos(n);
+    std::vector<TareaPNM<Funcion>> tareas(n);
+    std::vector<bool> creado(n, false);
+    for (int i = 1; i < n; i++) {
+        tareas[i].funcion = &funcion;
+        tareas[i].indice = i;
+        creado[i] = pthread_create(&hilos[i], NULL, ejecutarTareaPNM<Funcion>, &tareas[i]) == 0;
+        // Sin recursos para otro hilo, el tramo se procesa aca
+        if (!creado[i]) funcion(i);
+    }
+    funcion(0);
+    for (int i = 1; i < n; i++) {
+        if (creado[i]) pthread_join(hilos[i], NULL);
+    }
+}
+
+void decodificarMuestras(const unsigned char* origen, int* destino, long count, int bytes) {
+    if (bytes == 2) {
+        for (long i = 0; i < count; i++) destino[i] = (origen[2 * i] << 8) | origen[2 * i + 1];
+    } else {
+        for (long i = 0; i < count; i++) destino[i] = origen[i];
+    }
+}
+
+void codificarMuestras(const int* origen, unsigned char* destino, long count, int bytes) {
+    if (bytes == 2) {
+        for (long i = 0; i < count; i++) {
+            destino[2 * i] = (unsigned char)(origen[i] >> 8);
+            destino[2 * i + 1] = (unsigned char)(origen[i] & 0xFF);
+        }
+    } else {
+        for (long i = 0; i < count; i++) destino[i] = (unsigned char)origen[i];
+    }
+}
+
+bool validarTamanoImagen(int width, int height, int channels) {
+    if ((long)width * height * channels > INT_MAX) {
+        std::cout << "Image too large." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void romperEnlaceDuro(const char* ruta) {
+    struct stat info;
+    if (lstat(ruta, &info) == 0 && S_ISREG(info.st_mode) && info.st_nlink > 1) unlink(ruta);
+}
+
+static inline bool esEspacio(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+LectorPNM::LectorPNM() : file(nullptr), buffer_binario(nullptr), inicio_datos(0), fila_actual(0) {
+    memset(&encabezado, 0, sizeof(encabezado));
+}
+
+LectorPNM::~LectorPNM() {
+    cerrar();
+}
+
+void LectorPNM::cerrar() {
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+    delete[] buffer_binario;
+    buffer_binario = nullptr;
+}
+
+// Salta espacios y comentarios del encabezado
+bool LectorPNM::leerEntero(int& value) {
+    int c = fgetc(file);
+    while (c != EOF) {
+        if (c == '#') {
+            while (c != EOF && c != '\n') c = fgetc(file);
+        } else if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        c = fgetc(file);
+    }
+    if (c == EOF) return false;
+    ungetc(c, file);
+    return fscanf(file, "%d", &value) == 1;
+}
+
+bool LectorPNM::abrir(const char* filename) {
+    cerrar();
+    file = fopen(filename, "rb");
+    if (file == NULL) {
+        std::cout << "Error, incorrect path or incorrect file." << std::endl;
+        return false;
+    }
+
+    if (fscanf(file, "%2s", encabezado.magic) != 1) {
+        std::cout << "Error reading magic number." << std::endl;
+        return false;
+    }
+
+    const char* magic = encabezado.magic;
+    if (strcmp(magic, "P2") == 0 || strcmp(magic, "P5") == 0) {
+        encabezado.channels = 1;
+    } else if (strcmp(magic, "P3") == 0 || strcmp(magic, "P6") == 0) {
+        encabezado.channels = 3;
+    } else {
+        std::cout << "Unsupported format: " << magic << std::endl;
+        return false;
+    }
+    encabezado.binario = (magic[1] == '5' || magic[1] == '6');
+
+    if (!leerEntero(encabezado.width) || !leerEntero(encabezado.height)) {
+        std::cout << "Error reading width and height." << std::endl;
+        return false;
+    }
+    if (!leerEntero(encabezado.max_color)) {
+        std::cout << "Error reading max color." << std::endl;
+        return false;
+    }
+    if (encabezado.width < 0 || encabezado.height < 0 || encabezado.max_color <= 0 || encabezado.max_color > 65535) {
+        std::cout << "Invalid image header." << std::endl;
+        return false;
+    }
+    // Las filas se indexan con int; el alto no tiene limite, asi que el
+    // streaming puede leer imagenes de mas de INT_MAX muestras
+    if ((long)encabezado.width * encabezado.channels > INT_MAX) {
+        std::cout << "Image too large." << std::endl;
+        return false;
+    }
+
+    if (encabezado.binario) {
+        // Un solo byte de espacio separa el encabezado de los datos
+        fgetc(file);
+        buffer_binario = new unsigned char[(size_t)encabezado.rowCount() * encabezado.bytesPorMuestra()];
+    }
+    inicio_datos = ftell(file);
+    fila_actual = 0;
+    return true;
+}
+
+bool LectorPNM::leerFila(int* fila) {
+    int count = encabezado.rowCount();
+    if (encabezado.binario) {
+        int bytes = encabezado.bytesPorMuestra();
+        if (fread(buffer_binario, bytes, count, file) != (size_t)count) {
+            std::cout << "Error reading pixels." << std::endl;
+            return false;
+        }
+        decodificarMuestras(buffer_binario, fila, count, bytes);
+        fila_actual++;
+        return true;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (fscanf(file, "%d", &fila[i]) != 1) {
+            std::cout << "Error reading pixels." << std::endl;
+            return false;
+        }
+        // Fuera de rango la convolucion podria desbordar
+        if (fila[i] < 0 || fila[i] > encabezado.max_color) {
+            std::cout << "Pixel value out of range." << std::endl;
+            return false;
+        }
+    }
+    fila_actual++;
+    return true;
+}
+
+// Tramo del archivo que parsea un hilo. Los cortes caen siempre sobre un
+// espacio, asi que ningun numero queda partido entre dos tramos.
+struct TramoLectura {
+    const char* inicio;
+    const char* fin;
+    long valores;       // numeros en el tramo (pasada 1)
+    long primero;       // indice global del primero (suma prefija)
+    bool error_formato;
+    bool fuera_rango;
+    const char* fin_ultimo;  // fin del numero count - 1, si cae en este tramo
+};
+
+// Todas las muestras restantes del archivo, parseadas en dos pasadas: cada
+// hilo cuenta los numeros de su tramo, una suma prefija da la posicion del
+// primero de cada tramo y cada hilo parsea el suyo directo al destino
+bool LectorPNM::leerASCIIParalelo(int* muestras, long count, int num_threads) {
+    long desde = ftell(file);
+    struct stat info;
+    if (desde < 0 || fstat(fileno(file), &info) != 0 || !S_ISREG(info.st_mode)) {
+        return leerFilasSecuencial(muestras, count);
+    }
+    size_t tamano = (size_t)info.st_size;
+    if ((size_t)desde >= tamano) {
+        std::cout << "Error reading pixels." << std::endl;
+        return false;
+    }
+    void* mapa = mmap(NULL, tamano, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (mapa == MAP_FAILED) {
+        return leerFilasSecuencial(muestras, count);
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(mapa, tamano, MADV_SEQUENTIAL);
+#endif
+    const char* base = (const char*)mapa;
+    const char* datos = base + desde;
+    const char* fin_datos = base + tamano;
+    long largo = fin_datos - datos;
+    if (largo / num_threads < 4096) num_threads = (int)(largo / 4096) + 1;
+
+    std::vector<TramoLectura> tramos(num_threads);
+    for (int t = 0; t < num_threads; t++) {
+        const char* corte = datos + largo * t / num_threads;
+        while (t > 0 && corte < fin_datos && !esEspacio(*corte)) corte++;
+        tramos[t].inicio = corte;
+        tramos[t].valores = 0;
+        tramos[t].primero = 0;
+        tramos[t].error_formato = false;
+        tramos[t].fuera_rango = false;
+        tramos[t].fin_ultimo = NULL;
+    }
+    for (int t = 0; t < num_threads; t++) {
+        tramos[t].fin = t + 1 < num_threads ? tramos[t + 1].inicio : fin_datos;
+    }
+
+    // Pasada 1: numeros por tramo
+    auto contar = [&](int t) {
+        long valores = 0;
+        bool en_numero = false;
+        for (const char* p = tramos[t].inicio; p < tramos[t].fin; p++) {
+            bool espacio = esEspacio(*p);
+            if (!espacio && !en_numero) valores++;
+            en_numero = !espacio;
+        }
+        tramos[t].valores = valores;
+    };
+    enParalelo(num_threads, contar);
+
+    long total = 0;
+    for (int t = 0; t < num_threads; t++) {
+        tramos[t].primero = total;
+        total += tramos[t].valores;
+    }
+
+    // Pasada 2: cada hilo parsea hasta la muestra count - 1
+    int max_color = encabezado.max_color;
+    auto parsear = [&](int t) {
+        TramoLectura& tramo = tramos[t];
+        long indice = tramo.primero;
+        const char* p = tramo.inicio;
+        while (indice < count) {
+            while (p < tramo.fin && esEspacio(*p)) p++;
+            if (p >= tramo.fin) break;
+            bool negativo = (*p == '-');
+            if (*p == '-' || *p == '+') p++;
+            const char* digitos = p;
+            int valor = 0;
+            while (p < tramo.fin && *p >= '0' && *p <= '9') {
+                // Satura para no desbordar con numeros enormes
+                if (valor <= max_color) valor = valor * 10 + (*p - '0');
+                p++;
+            }
+            if (p == digitos || (p < tramo.fin && !esEspacio(*p))) {
+                tramo.error_formato = true;
+                return;
+            }
+            if ((negativo && valor != 0) || valor > max_color) {
+                tramo.fuera_rango = true;
+                return;
+            }
+            muestras[indice] = valor;
+            if (indice == count - 1) tramo.fin_ultimo = p;
+            indice++;
+        }
+    };
+    enParalelo(num_threads, parsear);
+
+    // El primer tramo con error es el que veria la lectura secuencial
+    bool ok = total >= count;
+    const char* fin_ultimo = NULL;
+    for (int t = 0; t < num_threads && ok; t++) {
+        if (tramos[t].primero >= count) break;
+        if (tramos[t].error_formato) {
+            ok = false;
+        } else if (tramos[t].fuera_rango) {
+            std::cout << "Pixel value out of range." << std::endl;
+            munmap(mapa, tamano);
+            return false;
+        }
+        if (tramos[t].fin_ultimo != NULL) fin_ultimo = tramos[t].fin_ultimo;
+    }
+    if (ok && count > 0 && fin_ultimo == NULL) ok = false;
+    if (!ok) {
+        std::cout << "Error reading pixels." << std::endl;
+        munmap(mapa, tamano);
+        return false;
+    }
+
+    // El archivo queda posicionado despues de la ultima muestra leida
+    long posicion = count > 0 ? (long)(fin_ultimo - base) : desde;
+    munmap(mapa, tamano);
+    return fseek(file, posicion, SEEK_SET) == 0;
+}
+
+bool LectorPNM::leerFilasSecuencial(int* filas, long count) {
+    int fila = encabezado.rowCount();
+    long num_filas = fila > 0 ? count / fila : 0;
+    for (long y = 0; y < num_filas; y++) {
+        if (!leerFila(filas + (size_t)y * fila)) return false;
+    }
+    return true;
+}
+
+bool LectorPNM::leerFilas(int* filas, int num_filas) {
+    long count = (long)num_filas * encabezado.rowCount();
+    int num_threads = hilosPNM();
+    if (!encabezado.binario && num_threads > 1 && count >= UMBRAL_PNM_PARALELO) {
+        // Sin mmap cae en leerFila, que ya cuenta las filas
+        int primera = fila_actual;
+        if (!leerASCIIParalelo(filas, count, num_threads)) return false;
+        fila_actual = primera + num_filas;
+        return true;
+    }
+    return leerFilasSecuencial(filas, count);
+}
+
+bool LectorPNM::leerRegion(int x, int y, int ancho, int alto, int* destino) {
+    if (x < 0 || y < 0 || ancho < 0 || alto < 0 || x + ancho > encabezado.width ||
+        y + alto > encabezado.height) {
+        std::cout << "Region out of image bounds." << std::endl;
+        return false;
+    }
+    int channels = encabezado.channels;
+    int count = ancho * channels;
+
+    if (encabezado.binario) {
+        int bytes = encabezado.bytesPorMuestra();
+        long bytes_fila = (long)encabezado.rowCount() * bytes;
+        for (int r = 0; r < alto; r++) {
+            long offset = inicio_datos + (long)(y + r) * bytes_fila + (long)x * channels * bytes;
+            if (fseek(file, offset, SEEK_SET) != 0 ||
+                fread(buffer_binario, bytes, count, file) != (size_t)count) {
+                std::cout << "Error reading pixels." << std::endl;
+                return false;
+            }
+            decodificarMuestras(buffer_binario, destino + (size_t)r * count, count, bytes);
+        }
+        // leerFila sigue desde la fila siguiente a la region
+        fila_actual = y + alto;
+        return fseek(file, inicio_datos + (long)fila_actual * bytes_fila, SEEK_SET) == 0;
+    }
+
+    if (y < fila_actual) {
+        std::cout << "Region rows were already read." << std::endl;
+        return false;
+    }
+    std::vector<int> fila(encabezado.rowCount() > 0 ? encabezado.rowCount() : 1);
+    while (fila_actual < y) {
+        if (!leerFila(fila.data())) return false;
+    }
+    for (int r = 0; r < alto; r++) {
+        if (!leerFila(fila.data())) return false;
+        memcpy(destino + (size_t)r * count, fila.data() + (size_t)x * channels, (size_t)count * sizeof(int));
+    }
+    return true;
+}
+
+EscritorPNM::EscritorPNM() : output(nullptr), buffer_binario(nullptr) {
+    memset(&encabezado, 0, sizeof(encabezado));
+}
+
+EscritorPNM::~EscritorPNM() {
+    cerrar();
+}
+
+bool EscritorPNM::cerrar() {
+    bool ok = true;
+    if (output != nullptr) {
+        ok = fclose(output) == 0;
+        output = nullptr;
+    }
+    delete[] buffer_binario;
+    buffer_binario = nullptr;
+    return ok;
+}
+
+bool EscritorPNM::abrir(const char* filename, const EncabezadoPNM& enc) {
+    cerrar();
+    encabezado = enc;
+    romperEnlaceDuro(filename);
+    output = fopen(filename, "wb");
+    if (output == NULL) {
+        std::cout << "Error creating output file: " << filename << std::endl;
+        return false;
+    }
+
+    if (encabezado.binario) {
+        buffer_binario = new unsigned char[(size_t)encabezado.rowCount() * 2];
+    }
+
+    if (fprintf(output, "%s\n%d %d\n%d\n", encabezado.magic, encabezado.width,
+                encabezado.height, encabezado.max_color) < 0) {
+        std::cout << "Error writing header." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool EscritorPNM::escribirFila(const int* fila) {
+    int count = encabezado.rowCount();
+    if (encabezado.binario) {
+        int bytes = encabezado.bytesPorMuestra();
+        codificarMuestras(fila, buffer_binario, count, bytes);
+        if (fwrite(buffer_binario, bytes, count, output) != (size_t)count) {
+            std::cout << "Error writing pixels." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (fprintf(output, "%d\n", fila[i]) < 0) {
+            std::cout << "Error writing pixels." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline int largoDecimal(int valor) {
+    if (valor < 0) return 1 + largoDecimal(-valor);
+    int largo = 1;
+    while (valor >= 10) {
+        valor /= 10;
+        largo++;
+    }
+    return largo;
+}
+
+// Escribe "valor\n" al final de buffer y devuelve el nuevo final
+static inline char* formatearMuestra(char* buffer, int valor) {
+    if (valor < 0) {
+        *buffer++ = '-';
+        valor = -valor;
+    }
+    int largo = largoDecimal(valor);
+    for (int i = largo - 1; i >= 0; i--) {
+        buffer[i] = (char)('0' + valor % 10);
+        valor /= 10;
+    }
+    buffer[largo] = '\n';
+    return buffer + largo + 1;
+}
+
+// Igual que la escritura secuencial ("%d\n" por muestra), en dos pasadas:
+// cada hilo calcula el largo de su tramo, una suma prefija da su posicion en
+// el archivo y cada hilo formatea su tramo por bloques y lo escribe con
+// pwrite() en esa posicion. Si la salida no es un archivo regular (un pipe,
+// /dev/stdout) escribe de corrido.
+bool EscritorPNM::escribirASCIIParalelo(const int* muestras, long count, int num_threads) {
+    if (fflush(output) != 0) {
+        std::cout << "Error writing pixels." << std::endl;
+        return false;
+    }
+    int fd = fileno(output);
+    long inicio = ftell(output);
+    struct stat info;
+    if (inicio < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        return escribirFilasSecuencial(muestras, count);
+    }
+
+    std::vector<long> largos(num_threads);
+    auto medir = [&](int t) {
+        long desde = count * t / num_threads;
+        long hasta = count * (t + 1) / num_threads;
+        long largo = 0;
+        for (long i = desde; i < hasta; i++) largo += largoDecimal(muestras[i]) + 1;
+        largos[t] = largo;
+    };
+    enParalelo(num_threads, medir);
+
+    std::vector<long> posiciones(num_threads);
+    long total = inicio;
+    for (int t = 0; t < num_threads; t++) {
+        posiciones[t] = total;
+        total += largos[t];
+    }
+
+    std::vector<char> errores(num_threads, 0);
+    auto escribir = [&](int t) {
+        const long BLOQUE = 64 * 1024;
+        std::vector<char> buffer(BLOQUE + 16);
+        long desde = count * t / num_threads;
+        long hasta = count * (t + 1) / num_threads;
+        off_t posicion = posiciones[t];
+        char* p = buffer.data();
+        for (long i = desde; i < hasta; i++) {
+            p = formatearMuestra(p, muestras[i]);
+            if (p - buffer.data() < BLOQUE && i < hasta - 1) continue;
+            const char* q = buffer.data();
+            while (q < p) {
+                ssize_t escritos = pwrite(fd, q, p - q, posicion);
+                if (escritos <= 0) {
+                    errores[t] = 1;
+                    return;
+                }
+                q += escritos;
+                posicion += escritos;
+            }
+            p = buffer.data();
+        }
+    };
+    enParalelo(num_threads, escribir);
+
+    for (int t = 0; t < num_threads; t++) {
+        if (errores[t]) {
+            std::cout << "Error writing pixels." << std::endl;
+            return false;
+        }
+    }
+    // Lo que se escriba despues va a continuacion
+    return fseek(output, total, SEEK_SET) == 0;
+}
+
+bool EscritorPNM::escribirFilasSecuencial(const int* filas, long count) {
+    int fila = encabezado.rowCount();
+    long num_filas = fila > 0 ? count / fila : 0;
+    for (long y = 0; y < num_filas; y++) {
+        if (!escribirFila(filas + (size_t)y * fila)) return false;
+    }
+    return true;
+}
+
+bool EscritorPNM::escribirFilas(const int* filas, int num_filas) {
+    long count = (long)num_filas * encabezado.rowCount();
+    int num_threads = hilosPNM();
+    if (!encabezado.binario && num_threads > 1 && count >= UMBRAL_PNM_PARALELO) {
+        if (count / num_threads < 4096) num_threads = (int)(count / 4096) + 1;
+        return escribirASCIIParalelo(filas, count, num_threads);
+    }
+    return escribirFilasSecuencial(filas, count);
+}
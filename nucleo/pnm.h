@@ -0,0 +1,104 @@
+#ifndef PNM_H
+#define PNM_H
+
+#include <cstdio>
+
+#define MAX_MAGIC 3
+
+// Las lecturas y escrituras ASCII de al menos esta cantidad de muestras se
+// parsean y formatean en paralelo
+#ifndef UMBRAL_PNM_PARALELO
+#define UMBRAL_PNM_PARALELO (1L << 18)
+#endif
+
+// Hilos para el parseo y el formato ASCII en paralelo de las lecturas y
+// escrituras que haga el hilo que lo llama. 0 (por defecto) usa todos los
+// nucleos en linea; 1 deja todo secuencial.
+void configurarHilosPNM(int num_threads);
+
+// Si la ruta es un archivo regular con mas de un enlace duro (por ejemplo,
+// una salida servida por la cache de resultados), lo borra: la escritura
+// crea un archivo nuevo en lugar de cambiar tambien los otros enlaces
+void romperEnlaceDuro(const char* ruta);
+
+// Muestras en la forma binaria de P5/P6: 1 byte, o 2 en big endian si
+// max_color > 255
+void decodificarMuestras(const unsigned char* origen, int* destino, long count, int bytes);
+void codificarMuestras(const int* origen, unsigned char* destino, long count, int bytes);
+
+// Encabezado de un PNM: P2/P3 (ASCII) o P5/P6 (binario, 8 o 16 bits)
+struct EncabezadoPNM {
+    char magic[MAX_MAGIC];
+    int width;
+    int height;
+    int max_color;
+    int channels;
+    bool binario;
+
+    int rowCount() const { return width * channels; }
+    int bytesPorMuestra() const { return max_color > 255 ? 2 : 1; }
+};
+
+// Una imagen completa en memoria indexa sus muestras con int. Los lectores
+// fila por fila no necesitan este limite; lo piden los que cargan todo.
+bool validarTamanoImagen(int width, int height, int channels);
+
+// Lee un PNM fila por fila
+class LectorPNM {
+private:
+    FILE* file;
+    EncabezadoPNM encabezado;
+    unsigned char* buffer_binario;
+    long inicio_datos;  // offset de la primera muestra
+    int fila_actual;    // siguiente fila que entrega leerFila
+
+    bool leerEntero(int& value);
+    bool leerASCIIParalelo(int* muestras, long count, int num_threads);
+    bool leerFilasSecuencial(int* filas, long count);
+
+public:
+    LectorPNM();
+    ~LectorPNM();
+
+    bool abrir(const char* filename);
+    void cerrar();
+
+    bool leerFila(int* fila);
+    // En ASCII, con suficientes muestras, parsea el archivo en paralelo
+    bool leerFilas(int* filas, int num_filas);
+    // Columnas [x, x + ancho) de las filas [y, y + alto), en pixeles. En
+    // binario salta directo a cada fila; en ASCII lee de corrido desde la
+    // fila actual, asi que las regiones tienen que pedirse en orden de y.
+    bool leerRegion(int x, int y, int ancho, int alto, int* destino);
+
+    const EncabezadoPNM& getEncabezado() const { return encabezado; }
+    FILE* getFile() const { return file; }
+    long getInicioDatos() const { return inicio_datos; }
+};
+
+// Escribe un PNM fila por fila en el formato indicado por el encabezado
+class EscritorPNM {
+private:
+    FILE* output;
+    EncabezadoPNM encabezado;
+    unsigned char* buffer_binario;
+
+    bool escribirASCIIParalelo(const int* muestras, long count, int num_threads);
+    bool escribirFilasSecuencial(const int* filas, long count);
+
+public:
+    EscritorPNM();
+    ~EscritorPNM();
+
+    bool abrir(const char* filename, const EncabezadoPNM& enc);
+    bool cerrar();
+
+    bool escribirFila(const int* fila);
+    // En ASCII, con suficientes muestras y salida a un archivo regular,
+    // formatea en paralelo y escribe cada tramo en su posicion con pwrite()
+    bool escribirFilas(const int* filas, int num_filas);
+
+    FILE* getFile() const { return output; }
+};
+
+#endif
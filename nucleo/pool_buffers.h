@@ -0,0 +1,184 @@
+#ifndef POOL_BUFFERS_H
+#define POOL_BUFFERS_H
+
+// Pool de buffers de pixeles compartido por Imagen y los motores de filtro.
+//
+// Los buffers devueltos no se liberan: quedan en listas libres y se reusan
+// en la siguiente peticion, asi que en lotes y cadenas de filtros la memoria
+// ya esta mapeada y no vuelve a producir page faults.
+//
+// - Buffers pequenos (hasta 1 MB): clases de tamano potencia de 2, cortadas
+//   de arenas de 2 MB.
+// - Buffers grandes: mapeados aparte, alineados a 2 MB y con huge pages
+//   (MAP_HUGETLB si hay paginas reservadas, si no MADV_HUGEPAGE).
+//
+// Todos los punteros devueltos estan alineados a 64 bytes.
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <map>
+#include <vector>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "instrumentacion.h"
+
+#define POOL_ALINEACION 64
+#define POOL_TAM_ARENA (2UL * 1024 * 1024)
+#define POOL_TAM_MINIMO 1024UL
+#define POOL_CLASES_PEQUENAS 11  // 1 KB .. 1 MB
+
+class PoolBuffers {
+private:
+    // Ocupa POOL_ALINEACION bytes justo antes de cada buffer
+    struct Cabecera {
+        size_t bytes;  // tamano util del bloque, sin la cabecera
+        int clase;     // -1 para buffers grandes
+        char relleno[POOL_ALINEACION - sizeof(size_t) - sizeof(int)];
+    };
+
+    pthread_mutex_t mutex;
+    std::vector<Cabecera*> libres[POOL_CLASES_PEQUENAS];
+    std::multimap<size_t, Cabecera*> grandes_libres;
+    char* arena;
+    size_t arena_usado;
+    size_t bytes_mapeados;
+
+    static size_t redondear(size_t n, size_t multiplo) {
+        return (n + multiplo - 1) / multiplo * multiplo;
+    }
+
+    // Region alineada a POOL_TAM_ARENA, respaldada por huge pages si se puede
+    static void* mapearAlineado(size_t bytes) {
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) return p;
+
+        size_t total = bytes + POOL_TAM_ARENA;
+        char* base = (char*)mmap(nullptr, total, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == (char*)MAP_FAILED) return nullptr;
+
+        char* alineado = (char*)redondear((uintptr_t)base, POOL_TAM_ARENA);
+        if (alineado > base) munmap(base, alineado - base);
+        char* fin = alineado + bytes;
+        if (base + total > fin) munmap(fin, base + total - fin);
+#ifdef MADV_HUGEPAGE
+        madvise(alineado, bytes, MADV_HUGEPAGE);
+#endif
+        return alineado;
+    }
+
+    static int claseDe(size_t bytes) {
+        int clase = 0;
+        size_t tam = POOL_TAM_MINIMO;
+        while (tam < bytes) {
+            tam <<= 1;
+            clase++;
+        }
+        return clase;
+    }
+
+    Cabecera* cortarDeArena(int clase) {
+        size_t bloque = sizeof(Cabecera) + (POOL_TAM_MINIMO << clase);
+        if (arena == nullptr || arena_usado + bloque > POOL_TAM_ARENA) {
+            arena = (char*)mapearAlineado(POOL_TAM_ARENA);
+            if (arena == nullptr) return nullptr;
+            arena_usado = 0;
+            bytes_mapeados += POOL_TAM_ARENA;
+        }
+        Cabecera* cab = (Cabecera*)(arena + arena_usado);
+        arena_usado += bloque;
+        cab->bytes = POOL_TAM_MINIMO << clase;
+        cab->clase = clase;
+        return cab;
+    }
+
+    Cabecera* mapearGrande(size_t bytes) {
+        size_t total = redondear(sizeof(Cabecera) + bytes, POOL_TAM_ARENA);
+        Cabecera* cab = (Cabecera*)mapearAlineado(total);
+        if (cab == nullptr) return nullptr;
+        bytes_mapeados += total;
+        cab->bytes = total - sizeof(Cabecera);
+        cab->clase = -1;
+        return cab;
+    }
+
+public:
+    PoolBuffers() : arena(nullptr), arena_usado(0), bytes_mapeados(0) {
+        pthread_mutex_init(&mutex, NULL);
+    }
+
+    // El pool vive hasta el final del proceso; no se desmapea nada al salir
+    ~PoolBuffers() {
+        pthread_mutex_destroy(&mutex);
+    }
+
+    static PoolBuffers& global() {
+        static PoolBuffers pool;
+        return pool;
+    }
+
+    void* pedir(size_t bytes) {
+        if (bytes == 0) bytes = 1;
+        Cabecera* cab = nullptr;
+
+        pthread_mutex_lock(&mutex);
+        int clase = claseDe(bytes);
+        if (clase < POOL_CLASES_PEQUENAS) {
+            if (!libres[clase].empty()) {
+                cab = libres[clase].back();
+                libres[clase].pop_back();
+            } else {
+                cab = cortarDeArena(clase);
+            }
+        } else {
+            // El bloque libre mas chico que alcance
+            std::multimap<size_t, Cabecera*>::iterator it = grandes_libres.lower_bound(bytes);
+            if (it != grandes_libres.end()) {
+                cab = it->second;
+                grandes_libres.erase(it);
+            } else {
+                cab = mapearGrande(bytes);
+            }
+        }
+        pthread_mutex_unlock(&mutex);
+
+        return cab == nullptr ? nullptr : (void*)(cab + 1);
+    }
+
+    void devolver(void* buffer) {
+        if (buffer == nullptr) return;
+        Cabecera* cab = (Cabecera*)buffer - 1;
+
+        pthread_mutex_lock(&mutex);
+        if (cab->clase >= 0) {
+            libres[cab->clase].push_back(cab);
+        } else {
+            grandes_libres.insert(std::make_pair(cab->bytes, cab));
+        }
+        pthread_mutex_unlock(&mutex);
+    }
+
+    size_t getBytesMapeados() {
+        pthread_mutex_lock(&mutex);
+        size_t bytes = bytes_mapeados;
+        pthread_mutex_unlock(&mutex);
+        return bytes;
+    }
+};
+
+// Atajos para buffers de pixeles (int)
+inline int* pedirPixeles(size_t count) {
+    MEDIR_FASE_N(FASE_RESERVA, count);
+    int* buffer = (int*)PoolBuffers::global().pedir(count * sizeof(int));
+    if (buffer == nullptr) throw std::bad_alloc();
+    return buffer;
+}
+
+inline void devolverPixeles(int* buffer) {
+    PoolBuffers::global().devolver(buffer);
+}
+
+#endif
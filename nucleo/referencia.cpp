@@ -0,0 +1,107 @@
+#include "referencia.h"
+
+#include <algorithm>
+#include <vector>
+
+// Filtros de rango: ordena la ventana recortada de cada muestra completa
+static void rangoReferencia(const Filtro& filtro, const Plano& plano, int* destino) {
+    int radio = filtro.radio;
+    std::vector<int> ventana;
+    for (int y = 0; y < plano.height; y++) {
+        for (int x = 0; x < plano.width; x++) {
+            for (int c = 0; c < plano.channels; c++) {
+                ventana.clear();
+                for (int ny = y - radio; ny <= y + radio; ny++) {
+                    for (int nx = x - radio; nx <= x + radio; nx++) {
+                        if (nx >= 0 && nx < plano.width && ny >= 0 && ny < plano.height) {
+                            ventana.push_back(plano.datos[((long)ny * plano.width + nx) * plano.channels + c]);
+                        }
+                    }
+                }
+                std::sort(ventana.begin(), ventana.end());
+                int valor;
+                if (filtro.tipo == FILTRO_MINIMO) {
+                    valor = ventana.front();
+                } else if (filtro.tipo == FILTRO_MAXIMO) {
+                    valor = ventana.back();
+                } else {
+                    valor = ventana[(ventana.size() - 1) / 2];
+                }
+                destino[((long)y * plano.width + x) * plano.channels + c] = valor;
+            }
+        }
+    }
+}
+
+// Histograma de la salida, muestra por muestra
+static void histogramaReferencia(const Plano& plano, const int* destino, EstadisticasImagen& estadisticas) {
+    long muestras = (long)plano.width * plano.height * plano.channels;
+    for (long i = 0; i < muestras; i++) {
+        int c = (int)(i % plano.channels);
+        estadisticas.histograma[(size_t)c * (plano.max_color + 1) + destino[i]]++;
+    }
+}
+
+void filtrarReferencia(const Filtro& filtro, const Plano& plano, int* destino, EstadisticasImagen* estadisticas) {
+    if (estadisticas != nullptr) estadisticas->iniciar(plano.channels, plano.max_color);
+    if (filtro.tipo != FILTRO_CONVOLUCION) {
+        rangoReferencia(filtro, plano, destino);
+        if (estadisticas != nullptr) histogramaReferencia(plano, destino, *estadisticas);
+        return;
+    }
+    int width = plano.width;
+    int height = plano.height;
+    int channels = plano.channels;
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < channels; c++) {
+                int sum = 0;
+                for (int ky = -1; ky <= 1; ky++) {
+                    for (int kx = -1; kx <= 1; kx++) {
+                        int nx = x + kx;
+                        int ny = y + ky;
+                        if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
+                            sum += plano.datos[((long)ny * width + nx) * channels + c] * filtro.kernel[ky + 1][kx + 1];
+                        }
+                    }
+                }
+                sum /= filtro.divisor;
+                if (estadisticas != nullptr) {
+                    if (sum < 0) estadisticas->recortadas_cero[c]++;
+                    if (sum > plano.max_color) estadisticas->recortadas_max[c]++;
+                }
+                if (sum < 0) sum = 0;
+                if (sum > plano.max_color) sum = plano.max_color;
+                destino[((long)y * width + x) * channels + c] = sum;
+            }
+        }
+    }
+    if (estadisticas != nullptr) histogramaReferencia(plano, destino, *estadisticas);
+}
+
+void reducirReferencia(const Plano& plano, int* destino) {
+    static const int binomial[5] = {1, 4, 6, 4, 1};
+    int w2 = (plano.width + 1) / 2;
+    int h2 = (plano.height + 1) / 2;
+    for (int y2 = 0; y2 < h2; y2++) {
+        for (int x2 = 0; x2 < w2; x2++) {
+            for (int c = 0; c < plano.channels; c++) {
+                int sum = 0;
+                int peso = 0;
+                for (int ky = -2; ky <= 2; ky++) {
+                    for (int kx = -2; kx <= 2; kx++) {
+                        int nx = 2 * x2 + kx;
+                        int ny = 2 * y2 + ky;
+                        if (nx >= 0 && nx < plano.width && ny >= 0 && ny < plano.height) {
+                            int w = binomial[ky + 2] * binomial[kx + 2];
+                            sum += plano.datos[((long)ny * plano.width + nx) * plano.channels + c] * w;
+                            peso += w;
+                        }
+                    }
+                }
+                destino[((long)y2 * w2 + x2) * plano.channels + c] = (sum + peso / 2) / peso;
+            }
+        }
+    }
+}
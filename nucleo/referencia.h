@@ -0,0 +1,20 @@
+#ifndef REFERENCIA_H
+#define REFERENCIA_H
+
+#include "estadisticas.h"
+#include "filtros.h"
+
+// Implementacion de referencia de cada filtro: un solo lazo escalar, sin
+// caminos rapidos, tal como el filtro.cpp original. Es el oraculo contra el
+// que se comparan filtrarFilas y todos los backends; no se usa para procesar.
+// Con `estadisticas`, ademas cuenta los recortes y arma el histograma de la
+// salida, como la pasada final con estadisticas.
+void filtrarReferencia(const Filtro& filtro, const Plano& plano, int* destino,
+                       EstadisticasImagen* estadisticas = nullptr);
+
+// Siguiente nivel de la piramide (piramide.h): binomial 5x5 en una sola
+// pasada 2D, solo en las filas y columnas pares, con los pesos de los
+// vecinos dentro del plano. destino tiene ((w + 1) / 2) x ((h + 1) / 2).
+void reducirReferencia(const Plano& plano, int* destino);
+
+#endif
@@ -0,0 +1,123 @@
+#include "region.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "instrumentacion.h"
+
+// Filas por franja al componer; coincide con el alto de tesela por defecto
+// para que cada tesela se lea una sola vez
+#define FILAS_POR_FRANJA TESELA_POR_DEFECTO
+
+bool parsearRegion(const char* texto, Region& region) {
+    int valores[4];
+    const char* p = texto;
+    for (int i = 0; i < 4; i++) {
+        char* fin;
+        errno = 0;
+        long valor = strtol(p, &fin, 10);
+        if (fin == p || errno != 0 || valor < 0 || valor > 0x7FFFFFFF) return false;
+        if (*fin != (i < 3 ? ',' : '\0')) return false;
+        valores[i] = (int)valor;
+        p = fin + 1;
+    }
+    region.x = valores[0];
+    region.y = valores[1];
+    region.width = valores[2];
+    region.height = valores[3];
+    return region.width > 0 && region.height > 0;
+}
+
+Region expandirRegion(const Region& region, int borde, int width, int height) {
+    Region expandida;
+    expandida.x = std::max(0L, (long)region.x - borde);
+    expandida.y = std::max(0L, (long)region.y - borde);
+    expandida.width = (int)(std::min((long)width, (long)region.x + region.width + borde) - expandida.x);
+    expandida.height = (int)(std::min((long)height, (long)region.y + region.height + borde) - expandida.y);
+    return expandida;
+}
+
+bool LectorRegiones::abrir(const char* ruta) {
+    es_teselado = esArchivoTeselado(ruta);
+    return es_teselado ? teselado.abrir(ruta) : pnm.abrir(ruta);
+}
+
+const EncabezadoPNM& LectorRegiones::getEncabezado() const {
+    return es_teselado ? teselado.getEncabezado() : pnm.getEncabezado();
+}
+
+bool LectorRegiones::leer(const Region& region, int* destino) {
+    MEDIR_FASE_N(FASE_LECTURA, (long)region.width * region.height * getEncabezado().channels);
+    if (es_teselado) {
+        return teselado.leerRegion(region.x, region.y, region.width, region.height, destino);
+    }
+    return pnm.leerRegion(region.x, region.y, region.width, region.height, destino);
+}
+
+bool LectorRegiones::leer(const Region& region, Imagen& destino) {
+    const EncabezadoPNM& enc = getEncabezado();
+    if (!validarTamanoImagen(region.width, region.height, enc.channels)) return false;
+    destino.setMetadata(enc.magic, region.width, region.height, enc.max_color, enc.channels);
+    destino.allocatePixels();
+    if (!leer(region, destino.getPixelsEscritura())) {
+        destino.liberarMemoria();
+        return false;
+    }
+    return true;
+}
+
+void recortarRegion(const Imagen& fuente, const Region& region, Imagen& destino) {
+    int channels = fuente.getChannels();
+    destino.setMetadata(fuente.getMagic(), region.width, region.height, fuente.getMaxColor(), channels);
+    destino.allocatePixels();
+    const int* origen = fuente.getPixels() + ((size_t)region.y * fuente.getWidth() + region.x) * channels;
+    int* salida = destino.getPixelsEscritura();
+    size_t fila = (size_t)region.width * channels;
+    for (int y = 0; y < region.height; y++) {
+        memcpy(salida + y * fila, origen + (size_t)y * fuente.getWidth() * channels, fila * sizeof(int));
+    }
+}
+
+bool componerRegion(const char* entrada, const char* salida, const Region& region, const Imagen& parche) {
+    LectorRegiones lector;
+    if (!lector.abrir(entrada)) return false;
+    EncabezadoPNM enc = lector.getEncabezado();
+    if (region.x + region.width > enc.width || region.y + region.height > enc.height ||
+        parche.getWidth() != region.width || parche.getHeight() != region.height ||
+        parche.getChannels() != enc.channels) {
+        std::cout << "Region does not fit the image." << std::endl;
+        return false;
+    }
+
+    EscritorPNM escritor;
+    if (!escritor.abrir(salida, enc)) return false;
+    int row_size = enc.rowCount();
+    std::vector<int> franja((size_t)FILAS_POR_FRANJA * row_size);
+    bool ok = true;
+    for (int y = 0; ok && y < enc.height; y += FILAS_POR_FRANJA) {
+        int filas = std::min(FILAS_POR_FRANJA, enc.height - y);
+        Region completa = {0, y, enc.width, filas};
+        ok = lector.leer(completa, franja.data());
+
+        // Filas de la franja que caen en la region
+        int desde = std::max(y, region.y), hasta = std::min(y + filas, region.y + region.height);
+        size_t ancho = (size_t)region.width * enc.channels;
+        for (int fila = desde; ok && fila < hasta; fila++) {
+            memcpy(franja.data() + (size_t)(fila - y) * row_size + (size_t)region.x * enc.channels,
+                   parche.getPixels() + (size_t)(fila - region.y) * ancho, ancho * sizeof(int));
+        }
+        if (ok) {
+            MEDIR_FASE_N(FASE_ESCRITURA, (long)filas * row_size);
+            ok = escritor.escribirFilas(franja.data(), filas);
+        }
+    }
+    if (!escritor.cerrar()) {
+        std::cout << "Error closing output file: " << salida << std::endl;
+        ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,55 @@
+#ifndef REGION_H
+#define REGION_H
+
+// Procesamiento de una region de interes: leer solo las filas y columnas
+// que hacen falta (mas el borde de los filtros) de un PNM o de un archivo
+// teselado, y escribir el resultado recortado o compuesto sobre la imagen
+// original.
+
+#include "imagen.h"
+#include "teselado.h"
+
+// Rectangulo en pixeles
+struct Region {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// "x,y,w,h"
+bool parsearRegion(const char* texto, Region& region);
+
+// La region agrandada `borde` pixeles por lado, recortada a la imagen
+Region expandirRegion(const Region& region, int borde, int width, int height);
+
+// Lee regiones de un PNM o de un archivo teselado. En PNM binario y en
+// teselado las regiones se piden en cualquier orden; en PNM ASCII el archivo
+// se lee de corrido, asi que tienen que pedirse en orden de y.
+class LectorRegiones {
+private:
+    LectorPNM pnm;
+    ArchivoTeselado teselado;
+    bool es_teselado;
+
+public:
+    LectorRegiones() : es_teselado(false) {}
+
+    bool abrir(const char* ruta);
+
+    // El de la imagen completa; P5/P6 si el archivo es teselado
+    const EncabezadoPNM& getEncabezado() const;
+
+    bool leer(const Region& region, int* destino);
+    // La imagen queda del tamano de la region, con el formato del archivo
+    bool leer(const Region& region, Imagen& destino);
+};
+
+// Copia la region (relativa a fuente) a destino
+void recortarRegion(const Imagen& fuente, const Region& region, Imagen& destino);
+
+// Escribe en `salida` la imagen de `entrada` con la region reemplazada por
+// `parche`, de a franjas: la imagen completa nunca esta en memoria
+bool componerRegion(const char* entrada, const char* salida, const Region& region, const Imagen& parche);
+
+#endif
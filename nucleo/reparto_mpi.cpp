@@ -0,0 +1,131 @@
+#ifdef FILTRO_CON_MPI
+
+#include "reparto_mpi.h"
+
+#include <cstring>
+#include <vector>
+#include <mpi.h>
+
+#include "instrumentacion.h"
+
+void calcularFranja(int height, int rank, int size, int& start_row, int& end_row) {
+    int rows_per_process = height / size;
+    int extra_rows = height % size;
+
+    start_row = rank * rows_per_process + (rank < extra_rows ? rank : extra_rows);
+    end_row = start_row + rows_per_process + (rank < extra_rows ? 1 : 0);
+}
+
+void calcularFranjaConBorde(int height, int rank, int size, int radio, int& start_row, int& end_row) {
+    calcularFranja(height, rank, size, start_row, end_row);
+    start_row = (start_row > radio) ? start_row - radio : 0;
+    end_row = (end_row + radio < height) ? end_row + radio : height;
+}
+
+void difundirMetadata(Imagen& imagen) {
+    MEDIR_FASE(FASE_DISTRIBUCION);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    char magic[MAX_MAGIC];
+    int metadata[4];
+    if (rank == 0) {
+        strncpy(magic, imagen.getMagic(), MAX_MAGIC);
+        metadata[0] = imagen.getWidth();
+        metadata[1] = imagen.getHeight();
+        metadata[2] = imagen.getMaxColor();
+        metadata[3] = imagen.getChannels();
+    }
+    MPI_Bcast(magic, MAX_MAGIC, MPI_CHAR, 0, MPI_COMM_WORLD);
+    MPI_Bcast(metadata, 4, MPI_INT, 0, MPI_COMM_WORLD);
+
+    if (rank != 0) {
+        imagen.setMetadata(magic, metadata[0], metadata[1], metadata[2], metadata[3]);
+    }
+}
+
+void distribuirFranjas(const Imagen& imagen, int radio, Imagen& parte) {
+    MEDIR_FASE(FASE_DISTRIBUCION);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int height = imagen.getHeight();
+    int row_size = imagen.getWidth() * imagen.getChannels();
+    int border_start, border_end;
+    calcularFranjaConBorde(height, rank, size, radio, border_start, border_end);
+
+    if (rank == 0) {
+        // El root envia cada franja directo desde la imagen completa
+        std::vector<MPI_Request> requests(size > 1 ? size - 1 : 1);
+        for (int dest = 1; dest < size; dest++) {
+            int dest_start, dest_end;
+            calcularFranjaConBorde(height, dest, size, radio, dest_start, dest_end);
+            MPI_Isend(imagen.getPixels() + (long)dest_start * row_size,
+                      (dest_end - dest_start) * row_size, MPI_INT,
+                      dest, 1, MPI_COMM_WORLD, &requests[dest - 1]);
+        }
+        parte.compartirFilas(imagen, border_start, border_end);
+        MPI_Waitall(size - 1, requests.data(), MPI_STATUSES_IGNORE);
+    } else {
+        parte.setMetadata(imagen.getMagic(), imagen.getWidth(), border_end - border_start,
+                          imagen.getMaxColor(), imagen.getChannels());
+        parte.allocatePixels();
+        MPI_Recv(parte.getPixelsEscritura(), parte.getPixelCount(), MPI_INT,
+                 0, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+}
+
+void intercambiarBordes(int* interior, int filas, int row_size, int halo) {
+    MEDIR_FASE_N(FASE_DISTRIBUCION, (long)2 * halo * row_size);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    if (halo == 0 || size == 1) return;
+
+    int count = halo * row_size;
+    MPI_Request requests[4];
+    int num_requests = 0;
+    if (rank > 0) {
+        MPI_Irecv(interior - (long)count, count, MPI_INT, rank - 1, 2, MPI_COMM_WORLD, &requests[num_requests++]);
+        MPI_Isend(interior, count, MPI_INT, rank - 1, 3, MPI_COMM_WORLD, &requests[num_requests++]);
+    }
+    if (rank < size - 1) {
+        int* abajo = interior + (long)filas * row_size;
+        MPI_Irecv(abajo, count, MPI_INT, rank + 1, 3, MPI_COMM_WORLD, &requests[num_requests++]);
+        MPI_Isend(abajo - (long)count, count, MPI_INT, rank + 1, 2, MPI_COMM_WORLD, &requests[num_requests++]);
+    }
+    MPI_Waitall(num_requests, requests, MPI_STATUSES_IGNORE);
+}
+
+BufferPixeles recolectarFranjas(const int* filas, int height, int row_size) {
+    MEDIR_FASE(FASE_RECOLECCION);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int start_row, end_row;
+    calcularFranja(height, rank, size, start_row, end_row);
+
+    // Las filas interiores de cada rank van directo a su lugar
+    std::vector<int> counts, displs;
+    BufferPixeles resultado;
+    if (rank == 0) {
+        counts.resize(size);
+        displs.resize(size);
+        for (int src = 0; src < size; src++) {
+            int src_start, src_end;
+            calcularFranja(height, src, size, src_start, src_end);
+            counts[src] = (src_end - src_start) * row_size;
+            displs[src] = src_start * row_size;
+        }
+        resultado = BufferPixeles((size_t)height * row_size);
+    }
+
+    MPI_Gatherv(filas, (end_row - start_row) * row_size, MPI_INT,
+                resultado.escritura(), counts.data(), displs.data(), MPI_INT,
+                0, MPI_COMM_WORLD);
+    return resultado;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef REPARTO_MPI_H
+#define REPARTO_MPI_H
+
+#ifdef FILTRO_CON_MPI
+
+#include "imagen.h"
+
+// Reparto de una imagen en franjas de filas entre los ranks de
+// MPI_COMM_WORLD. Todas las funciones salvo calcularFranja* son colectivas.
+
+// Filas [start_row, end_row) que le corresponden a un rank
+void calcularFranja(int height, int rank, int size, int& start_row, int& end_row);
+
+// Igual que calcularFranja pero con `radio` filas de borde de cada lado
+void calcularFranjaConBorde(int height, int rank, int size, int radio, int& start_row, int& end_row);
+
+// El raiz manda el encabezado; en los demas ranks la imagen queda con la
+// metadata pero sin pixeles
+void difundirMetadata(Imagen& imagen);
+
+// Cada rank recibe su franja con borde en `parte`. En el raiz es una vista
+// de la imagen completa, sin copias.
+void distribuirFranjas(const Imagen& imagen, int radio, Imagen& parte);
+
+// Intercambio de bordes entre ranks vecinos con las franjas ya repartidas:
+// `interior` apunta a la primera de las `filas` propias y el buffer tiene
+// lugar para `halo` filas antes y despues. Se mandan las primeras y ultimas
+// `halo` filas propias y se reciben las de los vecinos (el rank 0 no tiene
+// vecino arriba ni el ultimo abajo). Requiere filas >= halo en todos los ranks.
+void intercambiarBordes(int* interior, int filas, int row_size, int halo);
+
+// Junta las filas interiores de cada rank (`filas`, en orden) en un buffer
+// nuevo del raiz. En los demas ranks devuelve un buffer vacio.
+BufferPixeles recolectarFranjas(const int* filas, int height, int row_size);
+
+#endif
+
+#endif
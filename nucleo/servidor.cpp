@@ -0,0 +1,169 @@
+#include "servidor.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+PeticionServidor nuevaPeticion(OperacionServidor operacion) {
+    PeticionServidor peticion;
+    memset(&peticion, 0, sizeof(peticion));
+    peticion.magia = MAGIA_SERVIDOR;
+    peticion.version = VERSION_SERVIDOR;
+    peticion.operacion = operacion;
+    peticion.iteraciones = 1;
+    return peticion;
+}
+
+bool enviarMensaje(int sock, const void* datos, size_t bytes, const int* fds, int num_fds) {
+    struct iovec iov;
+    iov.iov_base = const_cast<void*>(datos);
+    iov.iov_len = bytes;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    char control[CMSG_SPACE(2 * sizeof(int))];
+    if (num_fds > 0) {
+        memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(num_fds * sizeof(int));
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(num_fds * sizeof(int));
+        memcpy(CMSG_DATA(cmsg), fds, num_fds * sizeof(int));
+    }
+    ssize_t n;
+    do {
+        n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    return n == (ssize_t)bytes;
+}
+
+bool recibirMensaje(int sock, void* datos, size_t bytes, int* fds, int& num_fds) {
+    num_fds = 0;
+    struct iovec iov;
+    iov.iov_base = datos;
+    iov.iov_len = bytes;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    char control[CMSG_SPACE(2 * sizeof(int))];
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+
+    // Los descriptores se toman siempre, para cerrarlos si el mensaje no sirve
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int cuantos = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            for (int i = 0; i < cuantos; i++) {
+                int fd;
+                memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                if (num_fds < 2) {
+                    fds[num_fds++] = fd;
+                } else {
+                    close(fd);
+                }
+            }
+        }
+    }
+    bool ok = n == (ssize_t)bytes && (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) == 0;
+    if (!ok) {
+        for (int i = 0; i < num_fds; i++) close(fds[i]);
+        num_fds = 0;
+    }
+    return ok;
+}
+
+void* crearBufferCompartido(size_t bytes, int& fd) {
+    fd = memfd_create("filtro_pixeles", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        std::cout << "Error creating shared buffer: " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    if (ftruncate(fd, (off_t)bytes) != 0) {
+        std::cout << "Error sizing shared buffer: " << strerror(errno) << std::endl;
+        close(fd);
+        fd = -1;
+        return nullptr;
+    }
+    // El servidor exige el tamano sellado: un buffer que se achica mientras
+    // esta mapeado produce SIGBUS en el otro proceso
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) != 0) {
+        std::cout << "Error sealing shared buffer: " << strerror(errno) << std::endl;
+        close(fd);
+        fd = -1;
+        return nullptr;
+    }
+    void* datos = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (datos == MAP_FAILED) {
+        std::cout << "Error mapping shared buffer: " << strerror(errno) << std::endl;
+        close(fd);
+        fd = -1;
+        return nullptr;
+    }
+    return datos;
+}
+
+const void* sellarEntrada(int fd, void* datos, size_t bytes) {
+    munmap(datos, bytes);
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE) != 0) {
+        std::cout << "Error sealing shared buffer: " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    void* lectura = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (lectura == MAP_FAILED) {
+        std::cout << "Error mapping shared buffer: " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    return lectura;
+}
+
+size_t bytesBufferCompartido(int width, int height, int channels) {
+    return (size_t)width * height * channels * sizeof(int);
+}
+
+double percentil(double* valores, size_t n, double p) {
+    if (n == 0) return 0;
+    std::sort(valores, valores + n);
+    size_t rango = (size_t)std::ceil(p / 100.0 * n);
+    if (rango < 1) rango = 1;
+    if (rango > n) rango = n;
+    return valores[rango - 1];
+}
+
+int conectarServidor(const char* ruta) {
+    struct sockaddr_un dir;
+    if (strlen(ruta) >= sizeof(dir.sun_path)) {
+        std::cout << "Socket path too long: " << ruta << std::endl;
+        return -1;
+    }
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        std::cout << "Error creating socket: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    memset(&dir, 0, sizeof(dir));
+    dir.sun_family = AF_UNIX;
+    strcpy(dir.sun_path, ruta);
+    if (connect(sock, (struct sockaddr*)&dir, sizeof(dir)) != 0) {
+        std::cout << "Error connecting to " << ruta << ": " << strerror(errno) << std::endl;
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
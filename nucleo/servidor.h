@@ -0,0 +1,86 @@
+#ifndef SERVIDOR_H
+#define SERVIDOR_H
+
+// Protocolo entre filtro_servidor y sus clientes.
+//
+// Los mensajes van por un socket Unix SOCK_SEQPACKET (cada mensaje llega
+// entero). Los pixeles no viajan por el socket: el cliente crea dos buffers
+// compartidos con memfd_create, escribe la entrada en el primero y pasa los
+// dos descriptores con SCM_RIGHTS junto con la peticion. La entrada va sellada
+// contra escrituras (sellarEntrada). El servidor los mapea,
+// filtra directo de uno al otro y responde; el cliente lee la salida del
+// segundo buffer. En los dos buffers las muestras son int en el orden de
+// Imagen (fila por fila, canales intercalados).
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#define MAGIA_SERVIDOR 0x53544c46u  // "FLTS"
+#define VERSION_SERVIDOR 2
+#define SOCKET_SERVIDOR_POR_DEFECTO "/tmp/filtro_servidor.sock"
+#define MAX_CADENA_SERVIDOR 256
+
+enum OperacionServidor {
+    OP_FILTRAR = 1,      // con dos descriptores: entrada y salida
+    OP_ESTADISTICAS = 2,
+    OP_TERMINAR = 3
+};
+
+struct PeticionServidor {
+    uint32_t magia;
+    uint32_t version;
+    uint32_t operacion;
+    int32_t width;
+    int32_t height;
+    int32_t channels;
+    int32_t max_color;
+    int32_t iteraciones;
+    char filtros[MAX_CADENA_SERVIDOR];
+};
+
+// Latencias en microsegundos, medidas en el servidor desde que llega la
+// peticion hasta que sale la respuesta
+struct RespuestaServidor {
+    uint32_t magia;
+    int32_t ok;
+    double latencia_us;  // del trabajo respondido
+    uint64_t trabajos;   // hasta ahora, para OP_ESTADISTICAS
+    double p50_us;
+    double p90_us;
+    double p99_us;
+    double max_us;
+    char mensaje[128];   // con ok == 0
+};
+
+// Peticion con sus campos fijos ya puestos
+PeticionServidor nuevaPeticion(OperacionServidor operacion);
+
+// Envia un mensaje con hasta dos descriptores adjuntos
+bool enviarMensaje(int sock, const void* datos, size_t bytes, const int* fds, int num_fds);
+
+// Recibe un mensaje de exactamente `bytes` bytes y hasta dos descriptores.
+// Devuelve false si el otro extremo cerro o el mensaje no tiene el tamano.
+bool recibirMensaje(int sock, void* datos, size_t bytes, int* fds, int& num_fds);
+
+// Buffer compartido anonimo (memfd) de `bytes` bytes con el tamano sellado,
+// mapeado para lectura y escritura. Devuelve el puntero o nullptr; el
+// descriptor queda en fd.
+void* crearBufferCompartido(size_t bytes, int& fd);
+
+// Sella un buffer ya escrito contra escrituras (F_SEAL_WRITE), para que el
+// servidor lo valide y lo filtre sin que cambie en el medio. El sello exige
+// que no quede ningun mapeo escribible: desmapea `datos` y devuelve un mapeo
+// de solo lectura, o nullptr.
+const void* sellarEntrada(int fd, void* datos, size_t bytes);
+
+// Bytes que ocupan las muestras de una imagen en un buffer compartido
+size_t bytesBufferCompartido(int width, int height, int channels);
+
+// Percentil p (0..100) por rango mas cercano; los valores se ordenan en el lugar
+double percentil(double* valores, size_t n, double p);
+
+// Socket ya conectado al servidor o -1
+int conectarServidor(const char* ruta);
+
+#endif
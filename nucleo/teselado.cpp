@@ -0,0 +1,275 @@
+#include "teselado.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define BYTES_ENTRADA_INDICE 16
+
+static void escribirU64(unsigned char* destino, uint64_t valor) {
+    for (int i = 0; i < 8; i++) destino[i] = (unsigned char)(valor >> (8 * i));
+}
+
+static uint64_t leerU64(const unsigned char* origen) {
+    uint64_t valor = 0;
+    for (int i = 0; i < 8; i++) valor |= (uint64_t)origen[i] << (8 * i);
+    return valor;
+}
+
+// Lee exactamente `bytes` desde `offset`
+static bool leerEn(int fd, void* destino, size_t bytes, uint64_t offset) {
+    char* p = (char*)destino;
+    while (bytes > 0) {
+        ssize_t n = pread(fd, p, bytes, (off_t)offset);
+        if (n <= 0) return false;
+        p += n;
+        bytes -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return true;
+}
+
+bool esArchivoTeselado(const char* ruta) {
+    FILE* file = fopen(ruta, "rb");
+    if (file == NULL) return false;
+    char magic[2];
+    bool es = fread(magic, 1, 2, file) == 2 && memcmp(magic, MAGIC_TESELADO, 2) == 0;
+    fclose(file);
+    return es;
+}
+
+ArchivoTeselado::ArchivoTeselado() : fd(-1), tesela_ancho(0), tesela_alto(0), teselas_leidas(0) {
+    memset(&encabezado, 0, sizeof(encabezado));
+}
+
+ArchivoTeselado::~ArchivoTeselado() {
+    cerrar();
+}
+
+void ArchivoTeselado::cerrar() {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    offsets.clear();
+    largos.clear();
+}
+
+bool ArchivoTeselado::abrir(const char* ruta) {
+    cerrar();
+    FILE* file = fopen(ruta, "rb");
+    if (file == NULL) {
+        std::cout << "Error, incorrect path or incorrect file." << std::endl;
+        return false;
+    }
+
+    char magic[MAX_MAGIC];
+    int width, height, max_color, channels;
+    bool ok = fscanf(file, "%2s %d %d %d %d %d %d", magic, &width, &height, &max_color, &channels,
+                     &tesela_ancho, &tesela_alto) == 7 && strcmp(magic, MAGIC_TESELADO) == 0;
+    // Un solo byte de espacio separa el encabezado del indice
+    long inicio_indice = ok && fgetc(file) != EOF ? ftell(file) : -1;
+    fclose(file);
+    if (!ok || inicio_indice < 0) {
+        std::cout << "Error reading tiled header." << std::endl;
+        return false;
+    }
+    if (width < 0 || height < 0 || max_color <= 0 || max_color > 65535 || (channels != 1 && channels != 3) ||
+        tesela_ancho <= 0 || tesela_alto <= 0) {
+        std::cout << "Invalid image header." << std::endl;
+        return false;
+    }
+    if ((long)width * height * channels > INT_MAX) {
+        std::cout << "Image too large." << std::endl;
+        return false;
+    }
+
+    strcpy(encabezado.magic, channels == 3 ? "P6" : "P5");
+    encabezado.width = width;
+    encabezado.height = height;
+    encabezado.max_color = max_color;
+    encabezado.channels = channels;
+    encabezado.binario = true;
+
+    fd = open(ruta, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        std::cout << "Error, incorrect path or incorrect file." << std::endl;
+        cerrar();
+        return false;
+    }
+
+    // El indice tiene que cubrir cada tesela con su largo exacto y dentro
+    // del archivo
+    long num_teselas = (long)teselasX() * teselasY();
+    uint64_t tamano = (uint64_t)info.st_size;
+    if ((uint64_t)inicio_indice + (uint64_t)num_teselas * BYTES_ENTRADA_INDICE > tamano) {
+        std::cout << "Error reading tile index." << std::endl;
+        cerrar();
+        return false;
+    }
+    std::vector<unsigned char> indice((size_t)num_teselas * BYTES_ENTRADA_INDICE);
+    if (!leerEn(fd, indice.data(), indice.size(), (uint64_t)inicio_indice)) {
+        std::cout << "Error reading tile index." << std::endl;
+        cerrar();
+        return false;
+    }
+    offsets.resize(num_teselas);
+    largos.resize(num_teselas);
+    int bytes = encabezado.bytesPorMuestra();
+    for (long t = 0; t < num_teselas; t++) {
+        offsets[t] = leerU64(&indice[t * BYTES_ENTRADA_INDICE]);
+        largos[t] = leerU64(&indice[t * BYTES_ENTRADA_INDICE + 8]);
+        int tx = (int)(t % teselasX());
+        int ty = (int)(t / teselasX());
+        uint64_t ancho = (uint64_t)std::min(tesela_ancho, width - tx * tesela_ancho);
+        uint64_t alto = (uint64_t)std::min(tesela_alto, height - ty * tesela_alto);
+        if (largos[t] != ancho * alto * channels * bytes || offsets[t] > tamano || largos[t] > tamano - offsets[t]) {
+            std::cout << "Invalid tile index." << std::endl;
+            cerrar();
+            return false;
+        }
+    }
+    teselas_leidas = 0;
+    return true;
+}
+
+bool ArchivoTeselado::leerRegion(int x, int y, int ancho, int alto, int* destino) {
+    if (x < 0 || y < 0 || ancho < 0 || alto < 0 || x + ancho > encabezado.width ||
+        y + alto > encabezado.height) {
+        std::cout << "Region out of image bounds." << std::endl;
+        return false;
+    }
+    if (ancho == 0 || alto == 0) return true;
+
+    int channels = encabezado.channels;
+    int bytes = encabezado.bytesPorMuestra();
+    int tx0 = x / tesela_ancho, tx1 = (x + ancho - 1) / tesela_ancho;
+    int ty0 = y / tesela_alto, ty1 = (y + alto - 1) / tesela_alto;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            long t = (long)ty * teselasX() + tx;
+            buffer.resize(largos[t]);
+            if (!leerEn(fd, buffer.data(), largos[t], offsets[t])) {
+                std::cout << "Error reading pixels." << std::endl;
+                return false;
+            }
+            teselas_leidas++;
+
+            // Interseccion de la tesela con la region
+            int base_x = tx * tesela_ancho, base_y = ty * tesela_alto;
+            int ancho_tesela = std::min(tesela_ancho, encabezado.width - base_x);
+            int desde_x = std::max(x, base_x), hasta_x = std::min(x + ancho, base_x + ancho_tesela);
+            int desde_y = std::max(y, base_y), hasta_y = std::min(y + alto, base_y + tesela_alto);
+            int count = (hasta_x - desde_x) * channels;
+            for (int fila = desde_y; fila < hasta_y; fila++) {
+                const unsigned char* origen = buffer.data() +
+                    ((size_t)(fila - base_y) * ancho_tesela + (desde_x - base_x)) * channels * bytes;
+                int* fila_destino = destino + ((size_t)(fila - y) * ancho + (desde_x - x)) * channels;
+                decodificarMuestras(origen, fila_destino, count, bytes);
+            }
+        }
+    }
+    return true;
+}
+
+EscritorTeselado::EscritorTeselado()
+    : output(nullptr), tesela_ancho(0), tesela_alto(0), fila_actual(0), inicio_indice(0) {
+    memset(&encabezado, 0, sizeof(encabezado));
+}
+
+EscritorTeselado::~EscritorTeselado() {
+    if (output != nullptr) {
+        fclose(output);
+        output = nullptr;
+    }
+}
+
+bool EscritorTeselado::abrir(const char* ruta, const EncabezadoPNM& enc, int ancho, int alto) {
+    if (ancho <= 0 || alto <= 0) {
+        std::cout << "Invalid tile size." << std::endl;
+        return false;
+    }
+    encabezado = enc;
+    tesela_ancho = ancho;
+    tesela_alto = alto;
+    fila_actual = 0;
+    romperEnlaceDuro(ruta);
+    output = fopen(ruta, "wb");
+    if (output == NULL) {
+        std::cout << "Error creating output file: " << ruta << std::endl;
+        return false;
+    }
+    if (fprintf(output, "%s\n%d %d\n%d %d\n%d %d\n", MAGIC_TESELADO, enc.width, enc.height, enc.max_color,
+                enc.channels, tesela_ancho, tesela_alto) < 0) {
+        std::cout << "Error writing header." << std::endl;
+        return false;
+    }
+
+    // Lugar para el indice; se completa en cerrar()
+    inicio_indice = ftell(output);
+    long num_teselas = (((long)enc.width + ancho - 1) / ancho) * (((long)enc.height + alto - 1) / alto);
+    offsets.assign(num_teselas, 0);
+    largos.assign(num_teselas, 0);
+    std::vector<unsigned char> vacio((size_t)num_teselas * BYTES_ENTRADA_INDICE, 0);
+    if (fwrite(vacio.data(), 1, vacio.size(), output) != vacio.size()) {
+        std::cout << "Error writing header." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool EscritorTeselado::escribirFranja(const int* filas, int num_filas) {
+    int restantes = encabezado.height - fila_actual;
+    if (num_filas != std::min(tesela_alto, restantes)) {
+        std::cout << "Tiled band does not match the tile height." << std::endl;
+        return false;
+    }
+    int channels = encabezado.channels;
+    int bytes = encabezado.bytesPorMuestra();
+    int teselas_x = (int)(((long)encabezado.width + tesela_ancho - 1) / tesela_ancho);
+    long ty = fila_actual / tesela_alto;
+    for (int tx = 0; tx < teselas_x; tx++) {
+        int base_x = tx * tesela_ancho;
+        int ancho = std::min(tesela_ancho, encabezado.width - base_x);
+        size_t bytes_fila = (size_t)ancho * channels * bytes;
+        buffer.resize(bytes_fila * num_filas);
+        for (int fila = 0; fila < num_filas; fila++) {
+            codificarMuestras(filas + ((size_t)fila * encabezado.width + base_x) * channels,
+                              buffer.data() + fila * bytes_fila, (long)ancho * channels, bytes);
+        }
+        long t = ty * teselas_x + tx;
+        offsets[t] = (uint64_t)ftell(output);
+        largos[t] = buffer.size();
+        if (fwrite(buffer.data(), 1, buffer.size(), output) != buffer.size()) {
+            std::cout << "Error writing pixels." << std::endl;
+            return false;
+        }
+    }
+    fila_actual += num_filas;
+    return true;
+}
+
+bool EscritorTeselado::cerrar() {
+    if (output == nullptr) return true;
+    bool ok = fila_actual == encabezado.height;
+    if (!ok) {
+        std::cout << "Tiled image is incomplete." << std::endl;
+    } else {
+        std::vector<unsigned char> indice(offsets.size() * BYTES_ENTRADA_INDICE);
+        for (size_t t = 0; t < offsets.size(); t++) {
+            escribirU64(&indice[t * BYTES_ENTRADA_INDICE], offsets[t]);
+            escribirU64(&indice[t * BYTES_ENTRADA_INDICE + 8], largos[t]);
+        }
+        ok = fseek(output, inicio_indice, SEEK_SET) == 0 &&
+             fwrite(indice.data(), 1, indice.size(), output) == indice.size();
+        if (!ok) std::cout << "Error writing tile index." << std::endl;
+    }
+    ok = fclose(output) == 0 && ok;
+    output = nullptr;
+    return ok;
+}
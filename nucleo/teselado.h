@@ -0,0 +1,87 @@
+#ifndef TESELADO_H
+#define TESELADO_H
+
+// Formato teselado (.pnmt) para leer regiones de imagenes grandes sin
+// recorrer el archivo entero.
+//
+// Encabezado de texto al estilo PNM:
+//
+//     PT
+//     <width> <height>
+//     <max_color> <channels>
+//     <tesela_ancho> <tesela_alto>
+//
+// seguido de un solo '\n', el indice y los datos. El indice tiene una entrada
+// por tesela, en orden de filas: offset y largo en bytes, dos enteros de 64
+// bits little endian. Cada tesela guarda sus filas seguidas, con las muestras
+// en la forma binaria de P5/P6; las de la ultima columna y la ultima fila de
+// teselas quedan recortadas al borde de la imagen. Leer una region cuesta una
+// lectura por tesela que toca.
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "pnm.h"
+
+#define MAGIC_TESELADO "PT"
+#define TESELA_POR_DEFECTO 256
+
+// Verdadero si el archivo empieza con MAGIC_TESELADO
+bool esArchivoTeselado(const char* ruta);
+
+class ArchivoTeselado {
+private:
+    int fd;
+    EncabezadoPNM encabezado;  // P5/P6 equivalente
+    int tesela_ancho;
+    int tesela_alto;
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> largos;
+    std::vector<unsigned char> buffer;
+    long teselas_leidas;
+
+public:
+    ArchivoTeselado();
+    ~ArchivoTeselado();
+
+    bool abrir(const char* ruta);
+    void cerrar();
+
+    // Columnas [x, x + ancho) de las filas [y, y + alto), en pixeles. Solo
+    // lee las teselas que la region toca, en cualquier orden.
+    bool leerRegion(int x, int y, int ancho, int alto, int* destino);
+
+    const EncabezadoPNM& getEncabezado() const { return encabezado; }
+    int getTeselaAncho() const { return tesela_ancho; }
+    int getTeselaAlto() const { return tesela_alto; }
+    int teselasX() const { return (int)(((long)encabezado.width + tesela_ancho - 1) / tesela_ancho); }
+    int teselasY() const { return (int)(((long)encabezado.height + tesela_alto - 1) / tesela_alto); }
+    long getTeselasLeidas() const { return teselas_leidas; }
+};
+
+// Escribe un archivo teselado de a una franja de tesela_alto filas enteras,
+// sin tener la imagen completa en memoria. El indice se escribe al cerrar.
+class EscritorTeselado {
+private:
+    FILE* output;
+    EncabezadoPNM encabezado;
+    int tesela_ancho;
+    int tesela_alto;
+    int fila_actual;
+    long inicio_indice;
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> largos;
+    std::vector<unsigned char> buffer;
+
+public:
+    EscritorTeselado();
+    ~EscritorTeselado();
+
+    bool abrir(const char* ruta, const EncabezadoPNM& enc, int tesela_ancho, int tesela_alto);
+    // tesela_alto filas, o las que queden en la ultima franja
+    bool escribirFranja(const int* filas, int num_filas);
+    bool cerrar();
+};
+
+#endif